@@ -0,0 +1,86 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include "../data.h"
+
+// Times summing every byte of a large buffer through operator[], at(), atUnchecked() and the
+// iterators, then adding a constant to every byte with std::transform through mutableBytes().
+// The checked accessors cost a branch per byte; the iterators are plain pointers, which the
+// compiler can vectorize.
+//
+// Usage: access [size in MB]
+// Defaults to 64 MB.
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, double seconds, size_t n);
+// Postcondition: Prints the time an operation took and the throughput.
+
+int main(int argc, char *argv[])
+{
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    size_t n = mb * 1024 * 1024;
+    std::mt19937_64 random(13);
+    
+    std::vector<byte> image(n);
+    for (byte &b : image)
+        b = static_cast<byte>(random());
+    data d(image.data(), n);
+    
+    std::cout << "Reading and writing every byte of " << mb << " MB:" << std::endl;
+    
+    uint64_t sums[4] = {};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < d.size(); i++)
+        sums[0] += d[i];
+    report("operator[]", secondsSince(start), n);
+    
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < d.size(); i++)
+    {
+        byte b = 0;
+        d.at(i, b);
+        sums[1] += b;
+    }
+    report("at", secondsSince(start), n);
+    
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < d.size(); i++)
+        sums[2] += d.atUnchecked(i);
+    report("atUnchecked", secondsSince(start), n);
+    
+    start = std::chrono::steady_clock::now();
+    for (byte b : d)
+        sums[3] += b;
+    report("iterators", secondsSince(start), n);
+    
+    bool matching = sums[0] == sums[1] && sums[1] == sums[2] && sums[2] == sums[3];
+    
+    start = std::chrono::steady_clock::now();
+    byte *out = d.mutableBytes();
+    std::transform(out, out + d.size(), out, [](byte b) { return static_cast<byte>(b + 1); });
+    report("std::transform", secondsSince(start), n);
+    
+    matching = matching && d[n / 2] == static_cast<byte>(image[n / 2] + 1);
+    std::cout << "  Results " << (matching ? "matching" : "NOT matching") << std::endl;
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, double seconds, size_t n)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms" << std::setw(10) << std::setprecision(0)
+              << n / seconds / (1024 * 1024) << " MB/s" << std::endl;
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <unistd.h>
+#include "../data.h"
+
+// Times compressing a buffer of log-like text, zeros and noise at both levels, reading it back
+// (every byte through operator[], random bytes, random 4 KB ranges, all of it) compressed and flat,
+// and saving it in both formats. Prints the memory every representation takes and checks that
+// every read and the compressed file give the same bytes.
+//
+// Usage: compress [size in MB] [path]
+// Defaults to 64 MB and compress_bench. The files are removed afterwards.
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, double seconds, size_t n);
+// Postcondition: Prints the time an operation on n bytes took and the throughput.
+
+uint64_t readAll(data &d, size_t n);
+// Postcondition: Reads n bytes through operator[], from the first on, and returns their sum.
+
+int main(int argc, char *argv[])
+{
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    std::string fName = argc > 2 ? argv[2] : "compress_bench";
+    size_t n = mb * 1024 * 1024;
+    std::mt19937_64 random(29);
+    
+    // Log lines, with a stretch of zeros or of noise every megabyte.
+    const char *words[] = {"GET", "POST", "/index.html", "/api/v1/items", "200", "404", "OK", "user=",
+                           "session=", "latency_ms=", "bytes=", "host=edge-", "\n"};
+    data source;
+    source.reserve(n);
+    while (source.size() < n)
+    {
+        if (source.size() % (1024 * 1024) < 64)
+        {
+            bool zeros = random() % 2 == 0;
+            for (size_t i = 0; i < 64 * 1024 && source.size() < n; i++)
+                source.appendByte(zeros ? 0 : static_cast<byte>(random()));
+            continue;
+        }
+        std::string w = words[random() % 13];
+        w += std::to_string(random() % 1000) + " ";
+        source.insertBytes(reinterpret_cast<const byte *>(w.data()), std::min(w.size(), n - source.size()),
+                           source.size());
+    }
+    
+    std::cout << "Compressing " << mb << " MB in blocks of " << data::compressedBlock / 1024 << " KB:" << std::endl;
+    
+    uint64_t expected = source.xxh3();
+    uint64_t flatSum = readAll(source, n);
+    bool matching = true;
+    const size_t probes = 1000000;
+    
+    for (data::compressionLevel level : {data::fastCompression, data::highCompression})
+    {
+        std::string name = level == data::fastCompression ? "fast" : "high";
+        data d(source);
+        
+        auto start = std::chrono::steady_clock::now();
+        d.compress(level);
+        report("compress, " + name, secondsSince(start), n);
+        std::cout << "    " << d.compressedSize() / 1024 << " KB, " << std::setprecision(1)
+                  << 100.0 * d.compressedSize() / n << "% of the bytes" << std::endl;
+        
+        start = std::chrono::steady_clock::now();
+        matching = matching && readAll(d, n) == flatSum;
+        report("operator[] over every byte", secondsSince(start), n);
+        
+        std::mt19937_64 same(31);
+        start = std::chrono::steady_clock::now();
+        uint64_t sum = 0;
+        for (size_t i = 0; i < probes; i++)
+            sum += d[same() % n];
+        double seconds = secondsSince(start);
+        std::cout << "  " << std::left << std::setw(32) << "random operator[]" << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << seconds * 1e9 / probes << " ns" << std::endl;
+        
+        std::mt19937_64 again(31);
+        uint64_t flat = 0;
+        for (size_t i = 0; i < probes; i++)
+            flat += source[again() % n];
+        matching = matching && sum == flat;
+        
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < 10000; i++)
+        {
+            size_t at = same() % (n - 4096);
+            data::range r(at, at + 4095);
+            matching = matching && d.viewInRange(r) == source.viewInRange(r);
+        }
+        report("random 4 KB views", secondsSince(start), 10000 * 4096);
+        
+        start = std::chrono::steady_clock::now();
+        d.saveToPath(fName, data::inPlace, data::compressedFormat);
+        report("save, compressed", secondsSince(start), n);
+        
+        data loaded(fName, data::compressedFile);
+        start = std::chrono::steady_clock::now();
+        loaded.decompress();
+        report("decompress", secondsSince(start), n);
+        matching = matching && loaded.xxh3() == expected && d.isCompressed();
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    source.saveToPath(fName);
+    report("save, plain", secondsSince(start), n);
+    
+    std::cout << "  Bytes " << (matching ? "matching" : "NOT matching") << std::endl;
+    unlink(fName.c_str());
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, double seconds, size_t n)
+{
+    std::cout << "  " << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms" << std::setw(10) << std::setprecision(0)
+              << n / seconds / (1024 * 1024) << " MB/s" << std::endl;
+}
+
+uint64_t readAll(data &d, size_t n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+        sum += d[i];
+    return sum;
+}
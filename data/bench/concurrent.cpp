@@ -0,0 +1,142 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "../data.h"
+#include "../concurrent.h"
+
+// Times reader threads looking up random bytes of a shared buffer while one writer keeps
+// overriding 8 byte records in it, for 1 to 64 readers: with a global mutex around every
+// lookup and override of a data object, and with snapshots of a concurrentData. A lookup reads
+// 16 bytes, through one lock or one snapshot.
+//
+// Usage: concurrent [size in MB] [milliseconds per run]
+// Defaults to 64 MB and 500 ms.
+
+struct result {
+    size_t lookups;
+    size_t writes;
+};
+
+result runLocked(data &d, std::mutex &m, unsigned readers, std::chrono::milliseconds duration);
+// Postcondition: Returns the lookups and writes made in duration through the mutex.
+
+result runSnapshots(concurrentData &d, unsigned readers, std::chrono::milliseconds duration);
+// Postcondition: Returns the lookups and writes made in duration through snapshots.
+
+void report(std::string name, result r, std::chrono::milliseconds duration);
+// Postcondition: Prints the lookups and writes per second of a run.
+
+int main(int argc, char *argv[])
+{
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    std::chrono::milliseconds duration(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500);
+    size_t n = mb * 1024 * 1024;
+    std::mt19937_64 random(3);
+    
+    std::vector<byte> image(n);
+    for (byte &b : image)
+        b = static_cast<byte>(random());
+    data locked(image.data(), n);
+    std::mutex m;
+    concurrentData shared(locked);
+    
+    std::cout << "Lookups of 16 bytes in " << mb << " MB with one writer, on "
+              << std::thread::hardware_concurrency() << " cores:" << std::endl;
+    for (unsigned readers = 1; readers <= 64; readers *= 2)
+    {
+        report(std::to_string(readers) + " readers, mutex", runLocked(locked, m, readers, duration), duration);
+        report(std::to_string(readers) + " readers, snapshots", runSnapshots(shared, readers, duration), duration);
+    }
+    
+    return 0;
+}
+
+result runLocked(data &d, std::mutex &m, unsigned readers, std::chrono::milliseconds duration)
+{
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> lookups(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < readers; t++)
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 random(t);
+            size_t done = 0;
+            uint64_t sum = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                std::lock_guard<std::mutex> lock(m);
+                for (int i = 0; i < 16; i++)
+                    sum += d[random() % d.size()];
+                done++;
+            }
+            lookups += done + (sum == 1);
+        });
+    
+    size_t writes = 0;
+    std::mt19937_64 random(readers);
+    byte record[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        size_t i = random() % (d.size() / 8) * 8;
+        data::range r(i, i + 7);
+        d.overrideBytes(record, 8, r);
+        writes++;
+    }
+    stop = true;
+    for (std::thread &t : threads)
+        t.join();
+    return {lookups.load(), writes};
+}
+
+result runSnapshots(concurrentData &d, unsigned readers, std::chrono::milliseconds duration)
+{
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> lookups(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < readers; t++)
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 random(t);
+            size_t done = 0;
+            uint64_t sum = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                concurrentData::snapshot s = d.read();
+                for (int i = 0; i < 16; i++)
+                    sum += s[random() % s.size()];
+                done++;
+            }
+            lookups += done + (sum == 1);
+        });
+    
+    size_t writes = 0;
+    std::mt19937_64 random(readers);
+    byte record[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    size_t n = d.size();
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        d.overrideBytes(record, 8, random() % (n / 8) * 8);
+        writes++;
+    }
+    stop = true;
+    for (std::thread &t : threads)
+        t.join();
+    d.reclaim();
+    return {lookups.load(), writes};
+}
+
+void report(std::string name, result r, std::chrono::milliseconds duration)
+{
+    double seconds = duration.count() / 1000.0;
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(14) << r.lookups / seconds << " lookups/s" << std::setw(12) << r.writes / seconds
+              << " writes/s" << std::endl;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include "../data.h"
+
+// Times making a delta between two versions of a large binary, in both modes, on one thread and
+// on every core, and applying it. The new version has scattered patched, inserted and removed
+// bytes, and a moved region.
+//
+// Usage: delta [size in MB] [edits]
+// Defaults to 64 MB and 1000 edits.
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, double seconds, size_t bytes);
+// Postcondition: Prints the time an operation took and the size of what it made.
+
+int main(int argc, char *argv[])
+{
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    size_t k = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    size_t n = mb * 1024 * 1024;
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::mt19937_64 random(11);
+    
+    // Words from a small vocabulary, so that the base repeats itself like code does.
+    std::vector<uint32_t> vocabulary(4096);
+    for (uint32_t &w : vocabulary)
+        w = static_cast<uint32_t>(random());
+    std::vector<byte> v1(n);
+    for (size_t i = 0; i + 4 <= n; i += 4)
+    {
+        uint32_t w = vocabulary[random() % vocabulary.size()];
+        std::copy(reinterpret_cast<byte *>(&w), reinterpret_cast<byte *>(&w) + 4, &v1[i]);
+    }
+    
+    data base(v1.data(), n);
+    data::editBatch batch;
+    byte patch[24];
+    for (size_t i = 0; i < k; i++)
+    {
+        for (byte &b : patch)
+            b = static_cast<byte>(random());
+        size_t at = (n / k) * i + random() % (n / k - 64);
+        if (i % 3 == 0)
+            batch.overrideBytes(patch, 4, at);
+        else if (i % 3 == 1)
+            batch.insertBytes(patch, 24, at);
+        else
+            batch.removeBytesIn(data::range(at, at + 15));
+    }
+    data target(base);
+    target.applyEdits(batch);
+    data moved(v1.data(), 1024 * 1024);
+    target.insertBytes(moved.viewAll().begin(), moved.size(), target.size() / 2);
+    
+    std::cout << "Delta between two versions of " << mb << " MB with " << k << " edits:" << std::endl;
+    
+    const char *names[] = {"blockMatching", "suffixMatching"};
+    data::deltaMode modes[] = {data::blockMatching, data::suffixMatching};
+    data delta;
+    for (int m = 0; m < 2; m++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        delta = data::diff(base, target, modes[m], 1);
+        report(std::string(names[m]) + ", 1 thread", secondsSince(start), delta.size());
+        
+        start = std::chrono::steady_clock::now();
+        delta = data::diff(base, target, modes[m], cores);
+        report(std::string(names[m]) + ", " + std::to_string(cores) + " threads", secondsSince(start), delta.size());
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    data rebuilt = data::applyDelta(base, delta);
+    report("applyDelta", secondsSince(start), rebuilt.size());
+    
+    bool matches = rebuilt.size() == target.size() && rebuilt.viewAll() == target.viewAll();
+    std::cout << "  " << (matches ? "matching" : "NOT matching") << " the new version" << std::endl;
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, double seconds, size_t bytes)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms" << std::setw(12) << bytes << " bytes" << std::endl;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include "../data.h"
+
+// Times applying a patch of scattered inserts, overrides and removals to a large buffer, one
+// call at a time (each one moving the bytes after it) and as a single batch, then checks that
+// both give the same bytes.
+//
+// Usage: edits [size in MB] [edits]
+// Defaults to 64 MB and 500 edits.
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, double seconds);
+// Postcondition: Prints the time an operation took.
+
+int main(int argc, char *argv[])
+{
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    size_t k = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500;
+    size_t n = mb * 1024 * 1024;
+    std::mt19937_64 random(7);
+    
+    std::vector<byte> image(n);
+    for (byte &b : image)
+        b = static_cast<byte>(random());
+    
+    // Edits at distinct offsets at least 64 bytes apart, so that none of them overlap.
+    std::vector<size_t> offsets(k);
+    for (size_t i = 0; i < k; i++)
+        offsets[i] = (n / k) * i + random() % (n / k - 32);
+    byte patch[16] = {0xDE, 0xAD, 0xBE, 0xEF};
+    
+    std::cout << "Applying " << k << " edits to " << mb << " MB:" << std::endl;
+    
+    data oneByOne(image.data(), n);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = k; i-- > 0;)
+    {
+        // Last to first, so the original offsets stay valid.
+        if (i % 3 == 0)
+            oneByOne.insertBytes(patch, 16, offsets[i]);
+        else if (i % 3 == 1)
+        {
+            data::range r(offsets[i], offsets[i] + 7);
+            oneByOne.overrideBytes(patch, 4, r);
+        }
+        else
+            oneByOne.removeBytesIn(data::range(offsets[i], offsets[i] + 15));
+    }
+    report("one call per edit", secondsSince(start));
+    
+    data batched(image.data(), n);
+    start = std::chrono::steady_clock::now();
+    data::editBatch batch;
+    for (size_t i = 0; i < k; i++)
+    {
+        if (i % 3 == 0)
+            batch.insertBytes(patch, 16, offsets[i]);
+        else if (i % 3 == 1)
+            batch.overrideBytes(patch, 4, data::range(offsets[i], offsets[i] + 7));
+        else
+            batch.removeBytesIn(data::range(offsets[i], offsets[i] + 15));
+    }
+    batched.applyEdits(batch);
+    report("one batch", secondsSince(start));
+    
+    bool matches = oneByOne.size() == batched.size() && oneByOne.viewAll() == batched.viewAll();
+    std::cout << "  " << batched.size() << " bytes, " << (matches ? "matching" : "NOT matching") << std::endl;
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, double seconds)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms" << std::endl;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include "../data.h"
+
+// Times append-heavy ingestion under each growth policy, with page-backed buffers that grow
+// through mremap and, for comparison, with buffers from a resource that forces a copy on every
+// growth (the old behavior), and with the whole size reserved up front.
+//
+// Usage: growth [size in MB]
+// Defaults to 512 MB, appended in 4 KB chunks.
+
+// Forwards to new/delete, which keeps data from mapping its buffers directly.
+class copyingResource : public std::pmr::memory_resource {
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, size_t n, double seconds);
+// Postcondition: Prints the throughput of an operation over n bytes.
+
+void ingest(data &d, size_t n);
+// Postcondition: Appends n bytes to d in 4 KB chunks.
+
+int main(int argc, char *argv[])
+{
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 512;
+    size_t n = mb * 1024 * 1024;
+    copyingResource copying;
+    
+    std::cout << "Appending " << mb << " MB in 4 KB chunks:" << std::endl;
+    
+    struct {
+        const char *name;
+        data::growthPolicy policy;
+        std::pmr::memory_resource *resource;
+    } runs[] = {
+        {"doubling (copying)", data::doubling, &copying},
+        {"1.5x (copying)", data::oneAndHalf, &copying},
+        {"doubling (mremap)", data::doubling, std::pmr::new_delete_resource()},
+        {"1.5x (mremap)", data::oneAndHalf, std::pmr::new_delete_resource()},
+        {"fixed 64 MB (mremap)", data::fixedStep, std::pmr::new_delete_resource()},
+    };
+    
+    for (auto &run : runs)
+    {
+        data d(run.resource);
+        d.setGrowthPolicy(run.policy, 64 * 1024 * 1024);
+        auto start = std::chrono::steady_clock::now();
+        ingest(d, n);
+        report(run.name, n, secondsSince(start));
+    }
+    
+    data reserved(std::pmr::new_delete_resource());
+    auto start = std::chrono::steady_clock::now();
+    reserved.reserve(n);
+    ingest(reserved, n);
+    report("reserved up front", n, secondsSince(start));
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, size_t n, double seconds)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << (n / 1048576.0) / seconds << " MB/s" << std::endl;
+}
+
+void ingest(data &d, size_t n)
+{
+    static const byte chunk[4096] = {1};
+    
+    for (size_t i = 0; i < n; i += sizeof(chunk))
+        d.insertBytes(chunk, sizeof(chunk), d.size());
+}
@@ -0,0 +1,153 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../data.h"
+
+// Times loading a large file with the sequential read path (buffered mode), in parallel chunks
+// and in parallel chunks through O_DIRECT, each from a cold page cache, then saving it to a new
+// file and syncing it the same three ways. The baseline is the original stream code: a loop of
+// std::ifstream::get to load and a std::ofstream write of the digest to save. Checks that every
+// load and save gives the same bytes.
+//
+// Usage: io [path] [size in MB]
+// Defaults to io_bench.bin and 1024 MB. The files are removed afterwards.
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, double seconds, size_t n);
+// Postcondition: Prints the time an operation on n bytes took and the throughput.
+
+void evict(std::string path);
+// Postcondition: Writes back and drops the cached pages of the file at path.
+
+int main(int argc, char *argv[])
+{
+    std::string fName = argc > 1 ? argv[1] : "io_bench.bin";
+    size_t mb = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1024;
+    size_t n = mb * 1024 * 1024;
+    std::string copyName = fName + ".copy";
+    std::mt19937_64 random(17);
+    
+    // A megabyte of noise repeated, with the offset of every megabyte written into it.
+    {
+        std::vector<byte> block(1024 * 1024);
+        for (byte &b : block)
+            b = static_cast<byte>(random());
+        data source;
+        source.reserve(n);
+        for (size_t i = 0; i < n; i += block.size())
+        {
+            block[0] = static_cast<byte>(i >> 20);
+            source.insertBytes(block.data(), block.size(), source.size());
+        }
+        source.saveToPath(fName);
+    }
+    
+    std::cout << "Loading and saving a file of " << mb << " MB on " << std::thread::hardware_concurrency()
+              << " cores:" << std::endl;
+    
+    struct mode {
+        std::string name;
+        data::loadMode load;
+        unsigned threads;
+        bool direct;
+    };
+    const mode modes[] = {
+        {"sequential", data::buffered, 1, false},
+        {"parallel", data::parallel, 0, false},
+        {"parallel, O_DIRECT", data::parallelDirect, 0, true},
+    };
+    
+    // The baseline, loading a byte at a time into a plain array and saving through a string.
+    uint64_t expected = 0;
+    bool matching = true;
+    {
+        evict(fName);
+        auto start = std::chrono::steady_clock::now();
+        std::ifstream ifile(fName.c_str(), std::ifstream::binary);
+        ifile.seekg(0, ifile.end);
+        size_t length = static_cast<size_t>(ifile.tellg());
+        ifile.seekg(0, ifile.beg);
+        byte *bytes = new byte[length];
+        for (size_t i = 0; i < length; i++)
+            bytes[i] = static_cast<byte>(ifile.get());
+        report("load, baseline ifstream", secondsSince(start), n);
+        
+        data d(bytes, length);
+        delete [] bytes;
+        expected = d.xxh3();
+        matching = length == n;
+        
+        start = std::chrono::steady_clock::now();
+        std::ofstream ofile(copyName.c_str(), std::ofstream::binary);
+        std::string str = d.digest();
+        ofile.write(str.c_str(), str.length());
+        ofile.close();
+        int fd = open(copyName.c_str(), O_RDONLY);
+        fsync(fd);
+        close(fd);
+        report("save + fsync, baseline ofstream", secondsSince(start), n);
+        
+        evict(copyName);
+        matching = matching && data(copyName, data::buffered).xxh3() == expected;
+        unlink(copyName.c_str());
+    }
+    
+    for (const mode &m : modes)
+    {
+        evict(fName);
+        auto start = std::chrono::steady_clock::now();
+        data d(fName, m.load);
+        report("load, " + m.name, secondsSince(start), n);
+        
+        matching = matching && d.size() == n && d.xxh3() == expected;
+        
+        d.useParallelIO(m.threads, m.direct);
+        start = std::chrono::steady_clock::now();
+        d.saveToPath(copyName);
+        int fd = open(copyName.c_str(), O_RDONLY);
+        fsync(fd);
+        close(fd);
+        report("save + fsync, " + m.name, secondsSince(start), n);
+        
+        evict(copyName);
+        matching = matching && data(copyName, data::buffered).xxh3() == expected;
+        unlink(copyName.c_str());
+    }
+    
+    std::cout << "  Bytes " << (matching ? "matching" : "NOT matching") << std::endl;
+    unlink(fName.c_str());
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, double seconds, size_t n)
+{
+    std::cout << "  " << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms" << std::setw(10) << std::setprecision(0)
+              << n / seconds / (1024 * 1024) << " MB/s" << std::endl;
+}
+
+void evict(std::string path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../data.h"
+
+// Times loading many small files: one constructor after another, with loadMany on a pool of
+// threads and with loadMany on io_uring, from a cold page cache and then a warm one. Checks that
+// every way loads the same bytes.
+//
+// Usage: many [directory] [files] [largest size in KB]
+// Defaults to many_bench, 2000 files and 16 KB. The files are removed afterwards.
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, double seconds, size_t n);
+// Postcondition: Prints the time loading n files took and the files per second.
+
+void evict(const std::vector<std::string> &paths);
+// Postcondition: Drops the cached pages of every file.
+
+int main(int argc, char *argv[])
+{
+    std::string dir = argc > 1 ? argv[1] : "many_bench";
+    size_t n = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    size_t largest = (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 16) * 1024;
+    std::mt19937_64 random(19);
+    
+    mkdir(dir.c_str(), 0755);
+    std::vector<std::string> paths;
+    std::vector<byte> noise(largest);
+    for (byte &b : noise)
+        b = static_cast<byte>(random());
+    for (size_t i = 0; i < n; i++)
+    {
+        paths.push_back(dir + "/" + std::to_string(i) + ".bin");
+        data(noise.data() + random() % (largest / 2), 1 + random() % (largest / 2)).saveToPath(paths.back());
+    }
+    
+    std::cout << "Loading " << n << " files of up to " << largest / 1024 << " KB:" << std::endl;
+    
+    std::vector<uint64_t> expected(n);
+    std::atomic<bool> matching(true);
+    for (bool cold : {true, false})
+    {
+        std::string temperature = cold ? ", cold" : ", warm";
+        
+        if (cold)
+            evict(paths);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++)
+            expected[i] = data(paths[i], data::buffered).xxh3();
+        report("constructors" + temperature, secondsSince(start), n);
+        
+        for (bool uring : {false, true})
+        {
+            if (cold)
+                evict(paths);
+            start = std::chrono::steady_clock::now();
+            data::loadMany(paths, [&](size_t i, data &d, bool loaded) {
+                if (!loaded || d.xxh3() != expected[i])
+                    matching = false;
+            }, uring);
+            report(std::string(uring ? "loadMany, io_uring" : "loadMany, threads") + temperature,
+                   secondsSince(start), n);
+        }
+    }
+    
+    std::cout << "  Bytes " << (matching ? "matching" : "NOT matching") << std::endl;
+    for (const std::string &p : paths)
+        unlink(p.c_str());
+    rmdir(dir.c_str());
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, double seconds, size_t n)
+{
+    std::cout << "  " << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms" << std::setw(10) << std::setprecision(0)
+              << n / seconds << " files/s" << std::endl;
+}
+
+void evict(const std::vector<std::string> &paths)
+{
+    for (const std::string &p : paths)
+    {
+        int fd = open(p.c_str(), O_RDONLY);
+        if (fd < 0)
+            continue;
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include "../data.h"
+#include "../resource.h"
+
+// Times request-scoped work: every request builds thousands of short-lived data objects of
+// 64 bytes to 16 KB and drops them all at the end, with buffers from the default resource,
+// a pool, or an arena released once per request. Also times filling one large buffer backed
+// by regular and by huge pages.
+//
+// Usage: resource [requests] [objects per request] [large buffer in MB]
+// Defaults to 200 requests of 5000 objects and a 512 MB buffer.
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, double seconds);
+// Postcondition: Prints the time an operation took.
+
+void serve(std::pmr::memory_resource *resource, size_t objects);
+// Postcondition: Builds and drops the objects of one request with buffers from resource.
+
+void fill(std::pmr::memory_resource *resource, size_t n);
+// Postcondition: Appends n bytes to a data object with buffers from resource.
+
+int main(int argc, char *argv[])
+{
+    size_t requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    size_t objects = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5000;
+    size_t mb = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 512;
+    
+    std::cout << requests << " requests of " << objects << " objects:" << std::endl;
+    
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requests; i++)
+        serve(std::pmr::get_default_resource(), objects);
+    report("default resource", secondsSince(start));
+    
+    poolResource pool;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requests; i++)
+        serve(&pool, objects);
+    report("pool resource", secondsSince(start));
+    
+    arenaResource arena(1024 * 1024);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requests; i++)
+    {
+        serve(&arena, objects);
+        arena.release();
+    }
+    report("arena resource", secondsSince(start));
+    
+    std::cout << "Appending " << mb << " MB to one buffer:" << std::endl;
+    
+    start = std::chrono::steady_clock::now();
+    fill(std::pmr::get_default_resource(), mb * 1024 * 1024);
+    report("default resource", secondsSince(start));
+    
+    hugePageResource huge;
+    start = std::chrono::steady_clock::now();
+    fill(&huge, mb * 1024 * 1024);
+    report("huge page resource", secondsSince(start));
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, double seconds)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms" << std::endl;
+}
+
+void serve(std::pmr::memory_resource *resource, size_t objects)
+{
+    static const byte payload[16384] = {};
+    
+    std::vector<data> live;
+    live.reserve(objects);
+    for (size_t i = 0; i < objects; i++)
+    {
+        size_t n = 64 << (i % 9);
+        live.emplace_back(payload, n, resource);
+        live.back().appendByte(static_cast<byte>(i));
+    }
+}
+
+void fill(std::pmr::memory_resource *resource, size_t n)
+{
+    static const byte chunk[4096] = {};
+    
+    data d(resource);
+    for (size_t i = 0; i < n; i += sizeof(chunk))
+        d.insertBytes(chunk, sizeof(chunk), d.size());
+}
@@ -0,0 +1,154 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "../data.h"
+#include "../ring.h"
+
+// Streams bytes through a bounded 1 MB queue in chunks of 64 bytes. First on one thread, with a
+// data object used as a queue (appending at the end, removing from the front) as an ordinary
+// buffer and as a ring buffer. Then from a producer thread to a consumer thread, through a data
+// ring guarded by a mutex and condition variables and through a lock-free ringBuffer, checking
+// that the bytes arrive intact.
+//
+// Usage: ring [MB streamed]
+// Defaults to 256 MB.
+
+static const size_t queueSize = 1024 * 1024;
+static const size_t chunk = 64;
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, double seconds, size_t n);
+// Postcondition: Prints the time it took to stream n bytes and the throughput.
+
+double streamQueue(data &queue, const std::vector<byte> &source, size_t n);
+// Postcondition: Streams n bytes of source through queue on one thread and returns the seconds.
+
+double streamLocked(const std::vector<byte> &source, size_t n, bool &intact);
+// Postcondition: Streams n bytes of source between two threads through a data ring guarded by a
+//                mutex and returns the seconds.
+
+double streamLockFree(const std::vector<byte> &source, size_t n, bool &intact);
+// Postcondition: Streams n bytes of source between two threads through a ringBuffer and returns
+//                the seconds.
+
+int main(int argc, char *argv[])
+{
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+    size_t n = mb * 1024 * 1024;
+    std::mt19937_64 random(5);
+    
+    // A source whose length is not a multiple of the queue, so that chunks wrap at every offset.
+    std::vector<byte> source(queueSize + 4093);
+    for (byte &b : source)
+        b = static_cast<byte>(random());
+    
+    std::cout << "Streaming " << mb << " MB through a queue of " << queueSize / 1024 << " KB in chunks of "
+              << chunk << " bytes:" << std::endl;
+    
+    // Every removal from the front of an ordinary buffer moves the rest of it, so it only streams
+    // a sixteenth of the bytes.
+    data plain(queueSize);
+    report("data, ordinary buffer", streamQueue(plain, source, n / 16), n / 16);
+    data ring;
+    ring.useRingBuffer(queueSize, false);
+    report("data, ring buffer", streamQueue(ring, source, n), n);
+    
+    bool intact = true;
+    report("two threads, mutex", streamLocked(source, n, intact), n);
+    report("two threads, ringBuffer", streamLockFree(source, n, intact), n);
+    std::cout << "  Bytes " << (intact ? "intact" : "NOT intact") << std::endl;
+    
+    return 0;
+}
+
+double streamQueue(data &queue, const std::vector<byte> &source, size_t n)
+{
+    // Keep the queue half full, as a consumer lagging behind its producer would.
+    size_t offset = 0;
+    for (size_t i = 0; i < queueSize / 2; i += chunk, offset = (offset + chunk) % (source.size() - chunk))
+        queue.insertBytes(source.data() + offset, chunk, queue.size());
+    
+    auto start = std::chrono::steady_clock::now();
+    for (size_t done = 0; done < n; done += chunk, offset = (offset + chunk) % (source.size() - chunk))
+    {
+        queue.insertBytes(source.data() + offset, chunk, queue.size());
+        queue.popFront(chunk);
+    }
+    return secondsSince(start);
+}
+
+double streamLocked(const std::vector<byte> &source, size_t n, bool &intact)
+{
+    data queue;
+    queue.useRingBuffer(queueSize, false);
+    std::mutex m;
+    std::condition_variable hasRoom, hasBytes;
+    
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        size_t offset = 0;
+        for (size_t done = 0; done < n; done += chunk, offset = (offset + chunk) % (source.size() - chunk))
+        {
+            std::unique_lock<std::mutex> lock(m);
+            hasRoom.wait(lock, [&]() { return queue.size() + chunk <= queueSize; });
+            queue.insertBytes(source.data() + offset, chunk, queue.size());
+            hasBytes.notify_one();
+        }
+    });
+    
+    size_t offset = 0;
+    for (size_t done = 0; done < n; done += chunk, offset = (offset + chunk) % (source.size() - chunk))
+    {
+        std::unique_lock<std::mutex> lock(m);
+        hasBytes.wait(lock, [&]() { return queue.size() >= chunk; });
+        intact = intact && queue.viewAll().slice(0, chunk) == data::view(source.data() + offset, chunk);
+        queue.popFront(chunk);
+        hasRoom.notify_one();
+    }
+    producer.join();
+    return secondsSince(start);
+}
+
+double streamLockFree(const std::vector<byte> &source, size_t n, bool &intact)
+{
+    ringBuffer queue(queueSize);
+    
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        size_t offset = 0;
+        for (size_t done = 0; done < n; done += chunk, offset = (offset + chunk) % (source.size() - chunk))
+            queue.write(source.data() + offset, chunk);
+        queue.close();
+    });
+    
+    byte received[chunk];
+    size_t offset = 0;
+    while (queue.read(received, chunk) == chunk)
+    {
+        intact = intact && data::view(received, chunk) == data::view(source.data() + offset, chunk);
+        offset = (offset + chunk) % (source.size() - chunk);
+    }
+    producer.join();
+    return secondsSince(start);
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, double seconds, size_t n)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms" << std::setw(10) << std::setprecision(0)
+              << n / seconds / (1024 * 1024) << " MB/s" << std::endl;
+}
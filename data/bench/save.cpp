@@ -0,0 +1,102 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../data.h"
+
+// Times saving a large file after patching its header: in place, where only the dirty extent
+// is written, through an atomic replace, as a full rewrite into another file, and through a
+// writable mapping, where saving flushes the one touched page. The default size is past 4 GB,
+// so the edits, saves and the final reload go through 64-bit offsets.
+//
+// Usage: save [path] [size in MB]
+// Defaults to save_bench.bin and 5120 MB. The file is created sparse and removed afterwards.
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, double seconds);
+// Postcondition: Prints the time an operation took.
+
+void createSparse(std::string path, size_t n);
+// Postcondition: Creates a sparse file of n bytes at path.
+
+int main(int argc, char *argv[])
+{
+    std::string fName = argc > 1 ? argv[1] : "save_bench.bin";
+    size_t mb = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5120;
+    std::string copyName = fName + ".copy";
+    
+    createSparse(fName, mb * 1024 * 1024);
+    std::cout << "Saving a " << mb << " MB file after patching 16 bytes of its header:" << std::endl;
+    
+    byte header[16] = {0x7F, 'D', 'A', 'T', 'A', 1, 0, 0};
+    data::range r(0, 15);
+    
+    data d(fName, data::mapped);
+    d.usePieceTable(true);
+    d.overrideBytes(header, 16, r);
+    auto start = std::chrono::steady_clock::now();
+    d.save();
+    report("save (in place)", secondsSince(start));
+    
+    byte trailer[] = {0xEE, 0xFF};
+    d.insertBytes(trailer, 2, d.size());
+    start = std::chrono::steady_clock::now();
+    d.save();
+    report("save (in place, appended)", secondsSince(start));
+    
+    header[5] = 2;
+    d.overrideBytes(header, 16, r);
+    start = std::chrono::steady_clock::now();
+    d.save(data::atomicReplace);
+    report("save (atomic replace)", secondsSince(start));
+    
+    start = std::chrono::steady_clock::now();
+    d.saveToPath(copyName);
+    report("save (full rewrite)", secondsSince(start));
+    
+    header[5] = 3;
+    start = std::chrono::steady_clock::now();
+    {
+        data patched(fName, data::writable);
+        patched.overrideBytes(header, 16, r);
+        patched.save();
+    }
+    report("writable mapping, open+save", secondsSince(start));
+    
+    data check(fName, data::mapped);
+    bool matches = check.size() == mb * 1024 * 1024 + 2 && check[5] == 3 && check[check.size() - 2] == 0xEE;
+    std::cout << "  reloaded " << check.size() << " bytes, " << (matches ? "matching" : "NOT matching")
+              << " the edits" << std::endl;
+    
+    unlink(fName.c_str());
+    unlink(copyName.c_str());
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, double seconds)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms" << std::endl;
+}
+
+void createSparse(std::string path, size_t n)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, n) != 0)
+    {
+        std::cout << "Fatal error: Could not create " << path << std::endl;
+        exit(1);
+    }
+    close(fd);
+}
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include "../data.h"
+#include "../search.h"
+
+// Times searching a large random buffer for an absent 8 byte marker: with a loop over
+// operator[], with memmem and with find and rfind. Then times scanning it for thousands of
+// 4 to 16 byte signatures in one pass, with and without a shared first byte.
+//
+// Usage: search [size in MB] [signatures]
+// Defaults to 256 MB and 2000 signatures.
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, size_t n, double seconds, size_t found);
+// Postcondition: Prints the throughput of an operation over n bytes and what it found.
+
+size_t indexScan(data &d, const byte *needle, size_t n);
+// Postcondition: Returns the first occurrence of needle, reading the bytes with operator[].
+
+int main(int argc, char *argv[])
+{
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+    size_t signatures = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    size_t n = mb * 1024 * 1024;
+    std::mt19937_64 random(42);
+    
+    data d(std::pmr::new_delete_resource());
+    d.reserve(n);
+    for (size_t i = 0; i < n; i += 8)
+    {
+        uint64_t word = random();
+        d.insertBytes(reinterpret_cast<const byte *>(&word), 8, d.size());
+    }
+    
+    byte marker[8] = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F'};
+    std::cout << "Searching " << mb << " MB for an absent 8 byte marker:" << std::endl;
+    
+    auto start = std::chrono::steady_clock::now();
+    size_t found = indexScan(d, marker, 8);
+    report("operator[] loop", n, secondsSince(start), found);
+    
+    data::view all = d.viewAll();
+    start = std::chrono::steady_clock::now();
+    const void *p = memmem(all.begin(), all.size(), marker, 8);
+    report("memmem", n, secondsSince(start), p ? static_cast<const byte *>(p) - all.begin() : data::notFound);
+    
+    start = std::chrono::steady_clock::now();
+    found = d.find(marker, 8);
+    report("find", n, secondsSince(start), found);
+    
+    start = std::chrono::steady_clock::now();
+    found = d.rfind(marker, 8);
+    report("rfind", n, secondsSince(start), found);
+    
+    std::cout << "Scanning for " << signatures << " signatures in one pass:" << std::endl;
+    
+    patternScanner anyStart;
+    patternScanner markerStart;
+    for (size_t i = 0; i < signatures; i++)
+    {
+        byte signature[16];
+        size_t length = 4 + random() % 13;
+        for (size_t j = 0; j < length; j++)
+            signature[j] = static_cast<byte>(random());
+        anyStart.addPattern(signature, length);
+        signature[0] = 0xFF;
+        markerStart.addPattern(signature, length);
+    }
+    anyStart.compile();
+    markerStart.compile();
+    
+    start = std::chrono::steady_clock::now();
+    found = anyStart.countMatches(all);
+    report("any first byte", n, secondsSince(start), found);
+    
+    start = std::chrono::steady_clock::now();
+    found = markerStart.countMatches(all);
+    report("0xFF first byte", n, secondsSince(start), found);
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, size_t n, double seconds, size_t found)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << (n / 1048576.0) / seconds << " MB/s";
+    if (found == data::notFound)
+        std::cout << "  (not found)" << std::endl;
+    else
+        std::cout << "  (" << found << ")" << std::endl;
+}
+
+size_t indexScan(data &d, const byte *needle, size_t n)
+{
+    for (size_t i = 0; i + n <= d.size(); i++)
+    {
+        size_t j = 0;
+        while (j < n && d[i + j] == needle[j])
+            j++;
+        if (j == n)
+            return i;
+    }
+    return data::notFound;
+}
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+#include "../data.h"
+
+// Compares the 8-bit bulk-copy storage of data against the old layout, where every
+// byte was an unsigned short and every copy went element by element. The memory of each
+// layout is measured as the growth of the resident set while a copy of the bytes exists.
+//
+// Usage: storage [path] [synthetic size in MB]
+// Defaults to ../tests/photo.jpeg and 1024 MB.
+
+typedef unsigned short legacyByte;
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, size_t n, double seconds);
+// Postcondition: Prints the throughput of an operation over n bytes.
+
+size_t residentBytes();
+// Postcondition: Returns the resident set size of the process, from /proc/self/statm.
+
+void benchmark(data &d, std::string label);
+// Postcondition: Times copy, insert and remove on d against the legacy layout.
+
+int main(int argc, char *argv[])
+{
+    std::string fName = argc > 1 ? argv[1] : "../tests/photo.jpeg";
+    size_t mb = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1024;
+    
+    auto start = std::chrono::steady_clock::now();
+    data photo(fName, data::buffered);
+    report("load (buffered)", photo.size(), secondsSince(start));
+    
+    start = std::chrono::steady_clock::now();
+    data mappedPhoto(fName, data::mapped);
+    report("load (mapped)", mappedPhoto.size(), secondsSince(start));
+    benchmark(photo, fName);
+    
+    std::vector<byte> source(mb * 1024 * 1024);
+    for (size_t i = 0; i < source.size(); i++)
+        source[i] = static_cast<byte>(i * 2654435761u >> 24);
+    
+    data synthetic(source.data(), source.size());
+    std::vector<byte>().swap(source);
+    benchmark(synthetic, std::to_string(mb) + " MB synthetic");
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, size_t n, double seconds)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << (n / 1048576.0) / seconds << " MB/s" << std::endl;
+}
+
+size_t residentBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    size_t total = 0;
+    size_t resident = 0;
+    statm >> total >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+void benchmark(data &d, std::string label)
+{
+    size_t n = d.size();
+    std::cout << label << ": " << n << " bytes" << std::endl;
+    
+    size_t before = residentBytes();
+    auto start = std::chrono::steady_clock::now();
+    {
+        data copy(d);
+        report("copy", n, secondsSince(start));
+        std::cout << "  memory (8-bit)              " << std::max(residentBytes(), before) - before << " bytes resident" << std::endl;
+        
+        byte patch[] = {1, 2, 3, 4};
+        start = std::chrono::steady_clock::now();
+        copy.insertBytes(patch, 4, n / 2);
+        report("insert (middle)", n, secondsSince(start));
+        
+        data::range r(n / 2, n / 2 + 3);
+        start = std::chrono::steady_clock::now();
+        copy.removeBytesIn(r);
+        report("remove (middle)", n, secondsSince(start));
+    }
+    
+    // The legacy copy loop, widening each byte into a 16-bit slot.
+    before = residentBytes();
+    legacyByte *legacy = new legacyByte[n];
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+        legacy[i] = d[i];
+    report("copy (legacy 16-bit loop)", n, secondsSince(start));
+    std::cout << "  memory (legacy 16-bit)      " << std::max(residentBytes(), before) - before << " bytes resident" << std::endl;
+    
+    legacyByte *legacyCopy = new legacyByte[n];
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+        legacyCopy[i] = legacy[i];
+    report("copy (legacy 16-bit buffer)", n, secondsSince(start));
+    
+    delete [] legacyCopy;
+    delete [] legacy;
+}
@@ -0,0 +1,163 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../data.h"
+
+// Times streaming bytes out of a pipe, a byte at a time through an istream as before and with
+// readFrom on the istream and on the descriptor, then hex dumping them to /dev/null with iostream
+// formatting per byte and with hexDump. Checks that both ingest the same bytes and that both dumps
+// of the first megabyte match.
+//
+// Usage: stream [size in MB to ingest] [size in MB to dump]
+// Defaults to 256 MB and 64 MB.
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+// Postcondition: Returns the seconds elapsed since start.
+
+void report(std::string name, double seconds, size_t n);
+// Postcondition: Prints the time an operation on n bytes took and the throughput.
+
+int openPipe(const std::vector<byte> &source, size_t n);
+// Postcondition: Returns the read end of a pipe that a child process fills with n bytes, repeating
+//                the source.
+
+void naiveDump(std::ostream &out, data::view v);
+// Postcondition: Writes the same dump as hexDump with iostream formatting for every byte.
+
+int main(int argc, char *argv[])
+{
+    size_t ingest = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256) * 1024 * 1024;
+    size_t dumped = (argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64) * 1024 * 1024;
+    std::mt19937_64 random(23);
+    std::vector<byte> source(1024 * 1024);
+    for (byte &b : source)
+        b = static_cast<byte>(random());
+    
+    std::cout << "Ingesting " << ingest / (1024 * 1024) << " MB from a pipe:" << std::endl;
+    
+    uint64_t expected = 0;
+    bool matching = true;
+    for (int way = 0; way < 3; way++)
+    {
+        int fd = openPipe(source, way == 0 ? ingest / 16 : ingest);
+        std::ifstream in("/dev/fd/" + std::to_string(fd), std::ios::binary);
+        data d;
+        
+        auto start = std::chrono::steady_clock::now();
+        if (way == 0)
+        {
+            // A sixteenth of the input, or this one would dominate the run.
+            for (std::istreambuf_iterator<char> i(in), end; i != end; ++i)
+                d.appendByte(static_cast<byte>(*i));
+            report("istream, byte by byte (1/16)", secondsSince(start), d.size());
+        }
+        else if (way == 1)
+        {
+            in >> d;
+            report("operator>>", secondsSince(start), d.size());
+        }
+        else
+        {
+            d.readFrom(fd);
+            report("readFrom(fd)", secondsSince(start), d.size());
+        }
+        
+        in.close();
+        close(fd);
+        wait(nullptr);
+        if (way > 0)
+        {
+            uint64_t h = d.xxh3();
+            expected = expected == 0 ? h : expected;
+            matching = matching && d.size() == ingest && h == expected;
+        }
+    }
+    
+    std::cout << "Hex dumping " << dumped / (1024 * 1024) << " MB to /dev/null:" << std::endl;
+    
+    data d;
+    d.reserve(dumped);
+    for (size_t i = 0; i < dumped; i += source.size())
+        d.insertBytes(source.data(), std::min(source.size(), dumped - i), d.size());
+    std::ofstream null("/dev/null");
+    
+    auto start = std::chrono::steady_clock::now();
+    naiveDump(null, d.viewAll());
+    report("iostream per byte", secondsSince(start), d.size());
+    
+    start = std::chrono::steady_clock::now();
+    d.hexDump(null);
+    report("hexDump", secondsSince(start), d.size());
+    
+    std::ostringstream naive, fast;
+    naiveDump(naive, d.viewAll().slice(0, 1024 * 1024 - 5));
+    data::hexDump(fast, d.viewAll().slice(0, 1024 * 1024 - 5));
+    matching = matching && naive.str() == fast.str();
+    
+    std::cout << "  Bytes " << (matching ? "matching" : "NOT matching") << std::endl;
+    
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(std::string name, double seconds, size_t n)
+{
+    std::cout << "  " << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000.0 << " ms" << std::setw(10) << std::setprecision(0)
+              << n / seconds / (1024 * 1024) << " MB/s" << std::endl;
+}
+
+int openPipe(const std::vector<byte> &source, size_t n)
+{
+    int ends[2];
+    if (pipe(ends) != 0)
+        exit(1);
+    if (fork() == 0)
+    {
+        close(ends[0]);
+        for (size_t sent = 0; sent < n;)
+        {
+            size_t offset = sent % source.size();
+            ssize_t w = write(ends[1], source.data() + offset, std::min(source.size() - offset, n - sent));
+            if (w <= 0)
+                _exit(1);
+            sent += w;
+        }
+        _exit(0);
+    }
+    close(ends[1]);
+    return ends[0];
+}
+
+void naiveDump(std::ostream &out, data::view v)
+{
+    for (size_t i = 0; i < v.size(); i += 16)
+    {
+        out << std::hex << std::setfill('0') << std::setw(8) << i << ": ";
+        for (size_t j = 0; j < 16; j++)
+        {
+            if (i + j < v.size())
+                out << std::setw(2) << static_cast<int>(v[i + j]);
+            else
+                out << "  ";
+            if (j % 2 == 1)
+                out << ' ';
+        }
+        out << ' ';
+        for (size_t j = i; j < i + 16 && j < v.size(); j++)
+            out << (v[j] >= 0x20 && v[j] < 0x7F ? static_cast<char>(v[j]) : '.');
+        out << std::dec << '\n';
+    }
+}
@@ -0,0 +1,233 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <random>
+#include "../data.h"
+
+// Times the everyday operations of data against the same work on a std::vector<uint8_t>, on
+// synthetic buffers from 64 bytes up to the largest size (growing 16 times at each step) and on
+// photo.jpeg, and prints the results as JSON so runs of different releases can be compared.
+//
+// Every operation runs once untimed, so buffers and caches are warm, then is repeated in
+// batches until it took at least 50 ms. Before a batch the buffer is restored (untimed), so
+// removals never run out of bytes and growth never piles up. Batches double while they take
+// less than 5 ms, so restoring stays cheap next to the work; saves always go to a new file, one
+// per batch.
+//
+// Usage: suite [largest size in MB] [path] [output]
+// Defaults to 1024 MB, ../tests/photo.jpeg and the standard output. Temporary files are written
+// into the working directory and removed afterwards.
+
+struct sample {
+    std::string source;         // "synthetic" or the name of the file.
+    size_t size;                // The size of the buffer before the operation.
+    std::string operation;      // What was timed.
+    std::string offset;         // Where in the buffer, or "" for operations over all of it.
+    std::string implementation; // "data" or "vector".
+    size_t iterations;          // How many times it ran.
+    double seconds;             // How long it took in total.
+};
+
+static const double minSeconds = 0.05;
+static const double batchSeconds = 0.005;
+static const char *scratchPath = "suite_bench.bin";
+static const char *savedPath = "suite_bench.saved";
+
+template <typename Setup, typename Op>
+sample measure(Setup setup, Op op, size_t limit = SIZE_MAX);
+// Postcondition: Runs setup and then op up to limit times in a row, timing only op, until it
+//                took minSeconds.
+
+void benchmark(std::vector<sample> &results, const std::vector<byte> &bytes, std::string source);
+// Postcondition: Times every operation on bytes, through data and through a vector.
+
+std::string hexVector(const std::vector<byte> &v);
+// Postcondition: Returns the hex representation of v, the vector counterpart of hexDigest.
+
+void writeJson(std::ostream &out, const std::vector<sample> &results, size_t largest);
+// Postcondition: Prints the results as a JSON object.
+
+int main(int argc, char *argv[])
+{
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+    std::string fName = argc > 2 ? argv[2] : "../tests/photo.jpeg";
+    size_t largest = mb * 1024 * 1024;
+    std::mt19937_64 random(1);
+    std::vector<sample> results;
+    
+    for (size_t n = 64; n <= largest; n *= 16)
+    {
+        std::vector<byte> bytes(n);
+        for (byte &b : bytes)
+            b = static_cast<byte>(random());
+        std::cerr << "Synthetic, " << n << " bytes..." << std::endl;
+        benchmark(results, bytes, "synthetic");
+    }
+    
+    std::ifstream file(fName, std::ios::binary);
+    if (file)
+    {
+        std::vector<byte> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::cerr << fName << ", " << bytes.size() << " bytes..." << std::endl;
+        benchmark(results, bytes, fName.substr(fName.find_last_of('/') + 1));
+    }
+    else
+        std::cerr << "Error: Could not open " << fName << ", skipping it." << std::endl;
+    
+    std::remove(scratchPath);
+    std::remove(savedPath);
+    
+    if (argc > 3)
+    {
+        std::ofstream out(argv[3]);
+        writeJson(out, results, largest);
+    }
+    else
+        writeJson(std::cout, results, largest);
+    
+    return 0;
+}
+
+template <typename Setup, typename Op>
+sample measure(Setup setup, Op op, size_t limit)
+{
+    sample s;
+    s.iterations = 0;
+    s.seconds = 0;
+    size_t batch = 1;
+    setup();
+    op();
+    while (s.seconds < minSeconds)
+    {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < batch; i++)
+            op();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        s.seconds += seconds;
+        s.iterations += batch;
+        if (seconds < batchSeconds && batch <= limit / 2)
+            batch *= 2;
+    }
+    return s;
+}
+
+void benchmark(std::vector<sample> &results, const std::vector<byte> &bytes, std::string source)
+{
+    size_t n = bytes.size();
+    size_t removals = std::max<size_t>(1, (n - 16) / 32);
+    byte patch[16] = {0xDE, 0xAD, 0xBE, 0xEF, 0xDE, 0xAD, 0xBE, 0xEF, 0xDE, 0xAD, 0xBE, 0xEF, 0xDE, 0xAD, 0xBE, 0xEF};
+    const char *places[] = {"front", "middle", "back"};
+    double fractions[] = {0.0, 0.5, 1.0};
+    
+    std::ofstream(scratchPath, std::ios::binary).write(reinterpret_cast<const char *>(bytes.data()), n);
+    
+    auto record = [&](sample s, std::string operation, std::string offset, std::string implementation) {
+        s.source = source;
+        s.size = n;
+        s.operation = operation;
+        s.offset = offset;
+        s.implementation = implementation;
+        results.push_back(s);
+    };
+    auto nothing = []() {};
+    
+    // data
+    {
+        data base(bytes.data(), n);
+        data d;
+        auto restore = [&]() { d = base; };
+        
+        record(measure(nothing, [&]() { data loaded(scratchPath, data::buffered); }), "load", "", "data");
+        record(measure([&]() { std::remove(savedPath); }, [&]() { base.saveToPath(savedPath); }, 1), "save", "", "data");
+        record(measure(restore, [&]() { d.appendByte(0x2A); }), "append", "", "data");
+        record(measure(restore, [&]() { d.prependByte(0x2A); }), "prepend", "", "data");
+        for (int p = 0; p < 3; p++)
+        {
+            double f = fractions[p];
+            record(measure(restore, [&]() { d.insertBytes(patch, 16, static_cast<size_t>(f * d.size())); }),
+                   "insert", places[p], "data");
+            record(measure(restore, [&]() {
+                size_t i = static_cast<size_t>(f * (d.size() - 16));
+                data::range r(i, i + 15);
+                d.overrideBytes(patch, 16, r);
+            }), "override", places[p], "data");
+            record(measure(restore, [&]() {
+                size_t i = static_cast<size_t>(f * (d.size() - 16));
+                d.removeBytesIn(data::range(i, i + 15));
+            }, removals), "remove", places[p], "data");
+        }
+        record(measure(nothing, [&]() { std::string s = base.hexDigest(); }), "hexDigest", "", "data");
+        record(measure(nothing, [&]() { data copy(base); }), "copy", "", "data");
+    }
+    
+    // The std::vector<uint8_t> baseline
+    {
+        std::vector<byte> v;
+        auto restore = [&]() { v.assign(bytes.begin(), bytes.end()); };
+        
+        record(measure(nothing, [&]() {
+            std::ifstream in(scratchPath, std::ios::binary);
+            in.seekg(0, std::ios::end);
+            std::vector<byte> loaded(static_cast<size_t>(in.tellg()));
+            in.seekg(0);
+            in.read(reinterpret_cast<char *>(loaded.data()), loaded.size());
+        }), "load", "", "vector");
+        record(measure([&]() { std::remove(savedPath); }, [&]() {
+            std::ofstream out(savedPath, std::ios::binary);
+            out.write(reinterpret_cast<const char *>(bytes.data()), n);
+        }, 1), "save", "", "vector");
+        record(measure(restore, [&]() { v.push_back(0x2A); }), "append", "", "vector");
+        record(measure(restore, [&]() { v.insert(v.begin(), 0x2A); }), "prepend", "", "vector");
+        for (int p = 0; p < 3; p++)
+        {
+            double f = fractions[p];
+            record(measure(restore, [&]() {
+                v.insert(v.begin() + static_cast<size_t>(f * v.size()), patch, patch + 16);
+            }), "insert", places[p], "vector");
+            record(measure(restore, [&]() {
+                std::copy(patch, patch + 16, v.begin() + static_cast<size_t>(f * (v.size() - 16)));
+            }), "override", places[p], "vector");
+            record(measure(restore, [&]() {
+                auto i = v.begin() + static_cast<size_t>(f * (v.size() - 16));
+                v.erase(i, i + 16);
+            }, removals), "remove", places[p], "vector");
+        }
+        record(measure(nothing, [&]() { std::string s = hexVector(bytes); }), "hexDigest", "", "vector");
+        record(measure(nothing, [&]() { std::vector<byte> copy(bytes); }), "copy", "", "vector");
+    }
+}
+
+std::string hexVector(const std::vector<byte> &v)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string s(2 * v.size(), '\0');
+    for (size_t i = 0; i < v.size(); i++)
+    {
+        s[2 * i] = digits[v[i] >> 4];
+        s[2 * i + 1] = digits[v[i] & 0xF];
+    }
+    return s;
+}
+
+void writeJson(std::ostream &out, const std::vector<sample> &results, size_t largest)
+{
+    out << "{\n  \"benchmark\": \"data\",\n  \"largestSize\": " << largest << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const sample &s = results[i];
+        std::ostringstream ns;
+        ns.precision(6);
+        ns << s.seconds * 1e9 / s.iterations;
+        out << (i ? "," : "") << "\n    {\"source\": \"" << s.source << "\", \"size\": " << s.size
+            << ", \"operation\": \"" << s.operation << "\", \"offset\": \"" << s.offset
+            << "\", \"implementation\": \"" << s.implementation << "\", \"iterations\": " << s.iterations
+            << ", \"nsPerOp\": " << ns.str() << "}";
+    }
+    out << "\n  ]\n}" << std::endl;
+}
@@ -0,0 +1,591 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "blockstore.h"
+#include "hash.h"
+
+// A block is a run of sequences, as in LZ4. Each one is a token holding the amount of literals in
+// its high nibble and the length of the match minus 4 in its low nibble, then (for a nibble of 15)
+// the rest of the amount of literals in bytes of 255 ended by a smaller one, the literals, the
+// offset of the match as 2 bytes little endian and the rest of its length like that of the
+// literals. The last sequence stops after its literals.
+//
+// A container is a header followed by the blocks:
+//
+//     'D' 'C' 'M' 'P' 1                        magic and version
+//     varint length, varint block size
+//     XXH64 of the bytes                       8 bytes, little endian
+//     varint per block                         its stored length shifted left once, with the
+//                                              low bit set if it is kept uncompressed
+//     the blocks, one after another
+
+/** Block Format **/
+
+static const byte containerMagic[5] = {'D', 'C', 'M', 'P', 1};
+
+static const size_t minMatch = 4;               // The shortest match, and the bytes hashed to find one.
+static const size_t maxOffset = 65535;          // The farthest a match may start behind.
+static const unsigned fastHashBits = 14;        // Entries of the fast level's table, as a power of two.
+static const unsigned highHashBits = 15;        // Heads of the high level's chains, as a power of two.
+static const unsigned highDepth = 64;           // Candidates the high level tries per position.
+
+static inline uint32_t read32(const byte *p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint64_t read64(const byte *p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint32_t hashOf(uint32_t v, unsigned bits)
+{
+    return (v * 2654435761u) >> (32 - bits);
+}
+
+// Returns how many bytes from a and b on match, up to end.
+static inline size_t matchLength(const byte *a, const byte *b, const byte *end)
+{
+    const byte *start = b;
+    while (b + 8 <= end)
+    {
+        uint64_t x = read64(a) ^ read64(b);
+        if (x != 0)
+            return b - start + (__builtin_ctzll(x) >> 3);
+        a += 8;
+        b += 8;
+    }
+    while (b < end && *a == *b)
+    {
+        a++;
+        b++;
+    }
+    return b - start;
+}
+
+static byte *putLength(byte *o, size_t n)
+{
+    for (; n >= 255; n -= 255)
+        *o++ = 255;
+    *o++ = static_cast<byte>(n);
+    return o;
+}
+
+// Writes a sequence of n literals followed by a match, or just the literals if length is 0.
+static byte *putSequence(byte *o, const byte *literals, size_t n, size_t offset, size_t length)
+{
+    byte *token = o++;
+    *token = static_cast<byte>(std::min<size_t>(n, 15) << 4);
+    if (n >= 15)
+        o = putLength(o, n - 15);
+    std::memcpy(o, literals, n);
+    o += n;
+    if (length == 0)
+        return o;
+    
+    *o++ = static_cast<byte>(offset);
+    *o++ = static_cast<byte>(offset >> 8);
+    length -= minMatch;
+    *token |= static_cast<byte>(std::min<size_t>(length, 15));
+    if (length >= 15)
+        o = putLength(o, length - 15);
+    return o;
+}
+
+static bool getLength(const byte *&p, const byte *end, size_t &n)
+{
+    byte b;
+    do
+    {
+        if (p == end)
+            return false;
+        b = *p++;
+        n += b;
+    } while (b == 255);
+    return true;
+}
+
+// Greedy matching through a table of the last position of every hashed 4 bytes, skipping ahead
+// faster the longer nothing matches.
+static size_t compressFast(const byte *src, size_t n, byte *dst)
+{
+    uint16_t table[1 << fastHashBits] = {};
+    byte *o = dst;
+    size_t anchor = 0;
+    size_t ip = 0;
+    size_t misses = 0;
+    
+    while (n >= minMatch && ip <= n - minMatch)
+    {
+        uint32_t h = hashOf(read32(src + ip), fastHashBits);
+        size_t candidate = table[h];
+        table[h] = static_cast<uint16_t>(ip);
+        
+        if (candidate >= ip || read32(src + candidate) != read32(src + ip))
+        {
+            ip += 1 + (misses++ >> 6);
+            continue;
+        }
+        
+        size_t length = minMatch + matchLength(src + candidate + minMatch, src + ip + minMatch, src + n);
+        while (ip > anchor && candidate > 0 && src[ip - 1] == src[candidate - 1])
+        {
+            ip--;
+            candidate--;
+            length++;
+        }
+        
+        o = putSequence(o, src + anchor, ip - anchor, ip - candidate, length);
+        ip += length;
+        anchor = ip;
+        misses = 0;
+        if (ip - 2 <= n - minMatch)
+            table[hashOf(read32(src + ip - 2), fastHashBits)] = static_cast<uint16_t>(ip - 2);
+    }
+    
+    if (anchor < n)
+        o = putSequence(o, src + anchor, n - anchor, 0, 0);
+    return o - dst;
+}
+
+// Follows chains of every earlier position with the same hashed 4 bytes for the longest match,
+// and takes a literal instead whenever the next position matches longer.
+static size_t compressHigh(const byte *src, size_t n, byte *dst)
+{
+    std::vector<uint32_t> head(1 << highHashBits, 0);   // The last position + 1 of every hash.
+    std::vector<uint32_t> chain(n, 0);                  // The position + 1 before each one.
+    size_t inserted = 0;
+    
+    // Returns the longest match for p, having chained every position before it.
+    auto find = [&](size_t p, size_t &offset) {
+        for (; inserted < p; inserted++)
+        {
+            uint32_t h = hashOf(read32(src + inserted), highHashBits);
+            chain[inserted] = head[h];
+            head[h] = static_cast<uint32_t>(inserted + 1);
+        }
+        
+        size_t best = 0;
+        uint32_t c = head[hashOf(read32(src + p), highHashBits)];
+        for (unsigned depth = 0; c != 0 && depth < highDepth; depth++, c = chain[c - 1])
+        {
+            size_t candidate = c - 1;
+            if (p - candidate > maxOffset)
+                break;
+            if (p + best < n && src[candidate + best] == src[p + best])
+            {
+                size_t length = matchLength(src + candidate, src + p, src + n);
+                if (length > best)
+                {
+                    best = length;
+                    offset = p - candidate;
+                }
+            }
+        }
+        return best >= minMatch ? best : 0;
+    };
+    
+    byte *o = dst;
+    size_t anchor = 0;
+    size_t ip = 0;
+    while (n >= minMatch && ip <= n - minMatch)
+    {
+        size_t offset = 0;
+        size_t length = find(ip, offset);
+        if (length == 0)
+        {
+            ip++;
+            continue;
+        }
+        
+        size_t nextOffset = 0;
+        size_t next;
+        while (ip + 1 <= n - minMatch && (next = find(ip + 1, nextOffset)) > length)
+        {
+            ip++;
+            length = next;
+            offset = nextOffset;
+        }
+        
+        o = putSequence(o, src + anchor, ip - anchor, offset, length);
+        ip += length;
+        anchor = ip;
+    }
+    
+    if (anchor < n)
+        o = putSequence(o, src + anchor, n - anchor, 0, 0);
+    return o - dst;
+}
+
+static bool writeAll(int fd, const byte *b, size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t w = write(fd, b, n);
+        if (w < 0 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return false;
+        b += w;
+        n -= w;
+    }
+    return true;
+}
+
+static void putVarint(std::vector<byte> &out, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<byte>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<byte>(v));
+}
+
+static bool getVarint(const byte *&p, const byte *end, uint64_t &v)
+{
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7)
+    {
+        byte b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static void putHash(std::vector<byte> &out, uint64_t h)
+{
+    for (int i = 0; i < 8; i++)
+        out.push_back(static_cast<byte>(h >> (8 * i)));
+}
+
+static uint64_t getHash(const byte *p)
+{
+    uint64_t h = 0;
+    for (int i = 0; i < 8; i++)
+        h |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return h;
+}
+
+/** Public Member Functions **/
+
+data::blockStore::blockStore(const byte *b, size_t n, compressionLevel level, std::pmr::memory_resource *r)
+    : blockStore(r)
+{
+    length = n;
+    checksum = xxh64Hasher::hash(view(b, n));
+    blocks.reserve((n + compressedBlock - 1) / compressedBlock);
+    payload.reserve(n / 4);
+    
+    std::vector<byte> out(compressBound(compressedBlock));
+    for (size_t i = 0; i < n; i += compressedBlock)
+    {
+        size_t k = std::min(compressedBlock, n - i);
+        size_t c = compressBlock(b + i, k, out.data(), level);
+        bool raw = c >= k;
+        blocks.push_back(block{payload.size(), raw ? k : c, raw});
+        payload.insert(payload.end(), raw ? b + i : out.data(), raw ? b + i + k : out.data() + c);
+    }
+    payload.shrink_to_fit();
+}
+
+data::blockStore::~blockStore()
+{
+    dropCache();
+}
+
+data::blockStore * data::blockStore::fromContainer(view container, std::pmr::memory_resource *r)
+{
+    const byte *p = container.begin();
+    const byte *end = container.end();
+    uint64_t n = 0;
+    uint64_t blockSize = 0;
+    
+    if (container.size() < 5 || std::memcmp(p, containerMagic, 5) != 0)
+        return nullptr;
+    p += 5;
+    if (!getVarint(p, end, n) || !getVarint(p, end, blockSize) || blockSize != compressedBlock || end - p < 8)
+        return nullptr;
+    uint64_t expectedHash = getHash(p);
+    p += 8;
+    
+    // Every block takes at least a byte, which bounds their count before anything is allocated.
+    uint64_t count = (n + compressedBlock - 1) / compressedBlock;
+    if (count > static_cast<uint64_t>(end - p))
+        return nullptr;
+    
+    blockStore *store = new blockStore(r);
+    store->length = n;
+    store->blocks.reserve(count);
+    size_t offset = 0;
+    for (uint64_t k = 0; k < count; k++)
+    {
+        uint64_t tag = 0;
+        if (!getVarint(p, end, tag) || (tag >> 1) > static_cast<uint64_t>(end - p))
+        {
+            delete store;
+            return nullptr;
+        }
+        store->blocks.push_back(block{offset, static_cast<size_t>(tag >> 1), (tag & 1) != 0});
+        offset += tag >> 1;
+    }
+    
+    if (offset != static_cast<size_t>(end - p))
+    {
+        delete store;
+        return nullptr;
+    }
+    store->payload.assign(p, end);
+    
+    // Corrupt blocks are found now rather than on the first read that reaches them.
+    std::vector<byte> check(compressedBlock);
+    xxh64Hasher h;
+    for (size_t k = 0; k < count; k++)
+    {
+        const block &b = store->blocks[k];
+        const byte *bytes = store->payload.data() + b.offset;
+        size_t expected = store->blockLength(k);
+        bool valid = b.raw ? b.length == expected : decompressBlock(bytes, b.length, check.data(), expected);
+        if (!valid)
+        {
+            delete store;
+            return nullptr;
+        }
+        h.update(b.raw ? bytes : check.data(), expected);
+    }
+    
+    if (h.digest() != expectedHash)
+    {
+        delete store;
+        return nullptr;
+    }
+    store->checksum = expectedHash;
+    return store;
+}
+
+size_t data::blockStore::size()
+{
+    return length;
+}
+
+size_t data::blockStore::compressedSize()
+{
+    return payload.capacity() + blocks.capacity() * sizeof(block);
+}
+
+byte data::blockStore::at(size_t i)
+{
+    return load(i / compressedBlock)[i % compressedBlock];
+}
+
+void data::blockStore::copyTo(byte *dst, size_t i, size_t n)
+{
+    while (n > 0)
+    {
+        size_t k = i / compressedBlock;
+        size_t offset = i % compressedBlock;
+        size_t m = std::min(n, blockLength(k) - offset);
+        
+        // Whole blocks are decompressed straight into dst, leaving the cache to what is hot.
+        const block &b = blocks[k];
+        if (offset == 0 && m == blockLength(k) && !b.raw)
+        {
+            if (!decompressBlock(payload.data() + b.offset, b.length, dst, m))
+            {
+                std::cout << "Fatal error: Corrupt compressed block." << std::endl;
+                exit(1);
+            }
+        }
+        else
+        {
+            std::memcpy(dst, load(k) + offset, m);
+        }
+        
+        dst += m;
+        i += m;
+        n -= m;
+    }
+}
+
+const byte * data::blockStore::range(size_t i, size_t n)
+{
+    if (n == 0)
+        return scratch.data();
+    
+    size_t k = i / compressedBlock;
+    if (i % compressedBlock + n <= blockLength(k))
+        return load(k) + i % compressedBlock;
+    
+    scratch.resize(n);
+    copyTo(scratch.data(), i, n);
+    return scratch.data();
+}
+
+void data::blockStore::dropCache()
+{
+    for (slot &s : cache)
+    {
+        if (s.bytes)
+            resource->deallocate(s.bytes, compressedBlock);
+        s = slot{notFound, 0, nullptr};
+    }
+    scratch.clear();
+    scratch.shrink_to_fit();
+}
+
+bool data::blockStore::writeTo(int fd)
+{
+    std::vector<byte> header(containerMagic, containerMagic + 5);
+    putVarint(header, length);
+    putVarint(header, compressedBlock);
+    putHash(header, checksum);
+    for (const block &b : blocks)
+        putVarint(header, static_cast<uint64_t>(b.length) << 1 | (b.raw ? 1 : 0));
+    
+    return writeAll(fd, header.data(), header.size()) && writeAll(fd, payload.data(), payload.size());
+}
+
+size_t data::blockStore::compressBlock(const byte *src, size_t n, byte *dst, compressionLevel level)
+{
+    return level == highCompression ? compressHigh(src, n, dst) : compressFast(src, n, dst);
+}
+
+bool data::blockStore::decompressBlock(const byte *src, size_t n, byte *dst, size_t length)
+{
+    const byte *p = src;
+    const byte *end = src + n;
+    size_t out = 0;
+    
+    while (p < end)
+    {
+        byte token = *p++;
+        size_t literals = token >> 4;
+        
+        // Short literals are copied 16 bytes at a time while both buffers have that much left,
+        // the bytes past them being overwritten next.
+        if (literals < 15 && end - p >= 16 && length - out >= 16)
+        {
+            std::memcpy(dst + out, p, 16);
+        }
+        else
+        {
+            if (literals == 15 && !getLength(p, end, literals))
+                return false;
+            if (literals > static_cast<size_t>(end - p) || literals > length - out)
+                return false;
+            std::memcpy(dst + out, p, literals);
+        }
+        p += literals;
+        out += literals;
+        
+        if (p == end)
+            break;
+        
+        if (end - p < 2)
+            return false;
+        size_t offset = p[0] | static_cast<size_t>(p[1]) << 8;
+        p += 2;
+        size_t match = token & 0x0F;
+        if (match == 15 && !getLength(p, end, match))
+            return false;
+        match += minMatch;
+        if (offset == 0 || offset > out || match > length - out)
+            return false;
+        
+        // Matches closer than their length repeat the bytes they are still writing, so they
+        // are copied in steps no longer than their offset.
+        byte *o = dst + out;
+        const byte *from = o - offset;
+        if (offset >= 8 && length - out - match >= 8)
+        {
+            for (size_t i = 0; i < match; i += 8)
+                std::memcpy(o + i, from + i, 8);
+        }
+        else if (offset == 1)
+        {
+            std::memset(o, *from, match);
+        }
+        else if (offset >= match)
+        {
+            std::memcpy(o, from, match);
+        }
+        else
+        {
+            for (size_t i = 0; i < match; i++)
+                o[i] = from[i];
+        }
+        out += match;
+    }
+    
+    return out == length;
+}
+
+size_t data::blockStore::compressBound(size_t n)
+{
+    return n + n / 255 + 16;
+}
+
+/** Private Member Functions **/
+
+data::blockStore::blockStore(std::pmr::memory_resource *r) : payload(r), blocks(r), scratch(r)
+{
+    resource = r;
+    length = 0;
+    checksum = 0;
+    last = 0;
+    clock = 0;
+    for (slot &s : cache)
+        s = slot{notFound, 0, nullptr};
+}
+
+const byte * data::blockStore::load(size_t k)
+{
+    const block &b = blocks[k];
+    if (b.raw)
+        return payload.data() + b.offset;
+    if (cache[last].index == k)
+        return cache[last].bytes;
+    
+    // The slot holding the block, or else the least recently used one (empty ones first).
+    size_t victim = 0;
+    for (size_t s = 0; s < cachedBlocks; s++)
+    {
+        if (cache[s].index == k)
+        {
+            victim = s;
+            break;
+        }
+        if (cache[s].used < cache[victim].used)
+            victim = s;
+    }
+    
+    slot &s = cache[victim];
+    s.used = ++clock;
+    last = victim;
+    if (s.index == k)
+        return s.bytes;
+    
+    if (s.bytes == nullptr)
+        s.bytes = static_cast<byte *>(resource->allocate(compressedBlock));
+    if (!decompressBlock(payload.data() + b.offset, b.length, s.bytes, blockLength(k)))
+    {
+        std::cout << "Fatal error: Corrupt compressed block." << std::endl;
+        exit(1);
+    }
+    s.index = k;
+    return s.bytes;
+}
+
+size_t data::blockStore::blockLength(size_t k)
+{
+    return std::min(compressedBlock, length - k * compressedBlock);
+}
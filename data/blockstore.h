@@ -0,0 +1,98 @@
+#ifndef BLOCKSTORE_H
+#define BLOCKSTORE_H
+#include <memory_resource>
+#include <vector>
+#include "data.h"
+
+/** data::blockStore declaration **/
+
+// The bytes of a compressed data object, in blocks of compressedBlock bytes compressed one by one
+// with an LZ4 style codec, so that reading a few bytes only decompresses the blocks holding them.
+// Blocks that do not shrink are kept as they are. Up to cachedBlocks decompressed blocks are kept
+// in a least recently used cache, whose slots are only allocated once they are needed.
+
+class data::blockStore {
+public:
+    blockStore(const byte *b, size_t length, compressionLevel level, std::pmr::memory_resource *resource);
+    // Postcondition: Compresses the length bytes of b. The blocks and the cache are allocated from
+    //                resource.
+    
+    ~blockStore();
+    // Postcondition: Releases the blocks and the cache.
+    
+    static blockStore *fromContainer(view container, std::pmr::memory_resource *resource);
+    // Postcondition: Returns the store held in a container written by writeTo, or nullptr if it is
+    //                not one, any of its blocks is corrupt or the bytes do not match its hash.
+    
+    size_t size();
+    // Postcondition: Returns the amount of bytes once decompressed.
+    
+    size_t compressedSize();
+    // Postcondition: Returns the amount of memory taken by the compressed blocks and their index.
+    
+    byte at(size_t i);
+    // Precondition: i must be less than size().
+    // Postcondition: Returns the byte at i.
+    
+    void copyTo(byte *dst, size_t i, size_t n);
+    // Precondition: i + n must not exceed size().
+    // Postcondition: Copies the n bytes starting at i into dst.
+    
+    const byte *range(size_t i, size_t n);
+    // Precondition: i + n must not exceed size().
+    // Postcondition: Returns the n bytes starting at i, contiguous, inside a cached block if they
+    //                lie in one and in a scratch buffer otherwise. Valid until the next call.
+    
+    void dropCache();
+    // Postcondition: Releases every cached block.
+    
+    bool writeTo(int fd);
+    // Postcondition: Writes the store to fd as a container, returning false if a write fails.
+    
+    static size_t compressBlock(const byte *src, size_t n, byte *dst, compressionLevel level);
+    // Precondition: dst must have room for compressBound(n) bytes.
+    // Postcondition: Compresses n bytes (at most 64 KB) of src into dst and returns the amount of
+    //                bytes written.
+    
+    static bool decompressBlock(const byte *src, size_t n, byte *dst, size_t length);
+    // Postcondition: Decompresses the n bytes of src into exactly length bytes of dst, returning
+    //                false, having written nothing outside dst, if they are corrupt.
+    
+    static size_t compressBound(size_t n);
+    // Postcondition: Returns the most bytes that compressing n bytes may take.
+
+private:
+    struct block {
+        size_t offset;      // Where the block starts in the payload.
+        size_t length;      // The amount of bytes it takes there.
+        bool raw;           // True if it is kept uncompressed.
+    };
+    
+    struct slot {
+        size_t index;       // The block it holds, or notFound.
+        uint64_t used;      // When it was last used.
+        byte *bytes;        // compressedBlock bytes, or nullptr until first used.
+    };
+    
+    explicit blockStore(std::pmr::memory_resource *resource);
+    blockStore(const blockStore &);
+    blockStore & operator=(const blockStore &);
+    
+    const byte *load(size_t k);
+    // Postcondition: Returns block k decompressed, through the cache.
+    
+    size_t blockLength(size_t k);
+    // Postcondition: Returns the amount of bytes block k holds once decompressed.
+    
+    std::pmr::memory_resource *resource;    // Where the blocks and the cache come from.
+    std::pmr::vector<byte> payload;         // Every block, one after another.
+    std::pmr::vector<block> blocks;         // Where each block is in the payload.
+    std::pmr::vector<byte> scratch;         // Ranges that cross blocks.
+    size_t length;                          // The amount of bytes once decompressed.
+    uint64_t checksum;                      // XXH64 of the bytes, kept for the container.
+    slot cache[cachedBlocks];               // The most recently used blocks, decompressed.
+    size_t last;                            // The slot used last.
+    uint64_t clock;                         // Counts the uses of the cache.
+};
+
+#endif
@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include "concurrent.h"
+
+// Every chunk but the last of a version is full, so byte i is at chunks[i / chunkSize] and
+// i % chunkSize. A chunk also remembers how many of its bytes any version wrote (used): a version
+// whose last chunk ends there can keep writing into it in place, since the versions sharing the
+// chunk never read past their own length.
+//
+// Only writers, holding the mutex, change reference counts, the retired lists and the epoch.
+// Readers only touch their counter, the epoch and the current version.
+
+/** Reader Slots **/
+
+// The slot of the calling thread. Threads are spread over the slots in the order they first
+// read; threads sharing a slot share its counters, which is correct, only slower.
+static size_t readerIndex()
+{
+    static std::atomic<size_t> threads(0);
+    thread_local size_t index = threads.fetch_add(1, std::memory_order_relaxed) % concurrentData::readerSlots;
+    return index;
+}
+
+/** snapshot **/
+
+concurrentData::snapshot::snapshot(std::atomic<size_t> *pin, const version *v) : pin(pin), current(v)
+{
+}
+
+concurrentData::snapshot::snapshot(snapshot &&s) noexcept : pin(s.pin), current(s.current)
+{
+    s.pin = nullptr;
+    s.current = nullptr;
+}
+
+concurrentData::snapshot & concurrentData::snapshot::operator=(snapshot &&s) noexcept
+{
+    if (this != &s)
+    {
+        if (pin)
+            pin->fetch_sub(1, std::memory_order_release);
+        pin = s.pin;
+        current = s.current;
+        s.pin = nullptr;
+        s.current = nullptr;
+    }
+    return *this;
+}
+
+concurrentData::snapshot::~snapshot()
+{
+    if (pin)
+        pin->fetch_sub(1, std::memory_order_release);
+}
+
+size_t concurrentData::snapshot::size() const
+{
+    return current->length;
+}
+
+byte concurrentData::snapshot::operator[](size_t i) const
+{
+    if (i >= current->length)
+    {
+        std::cout << "Fatal error: Index out of bounds." << std::endl;
+        exit(1);
+    }
+    return current->chunks[i / chunkSize]->bytes[i % chunkSize];
+}
+
+void concurrentData::snapshot::copyTo(byte *out, size_t i, size_t n) const
+{
+    if (i > current->length || n > current->length - i)
+    {
+        std::cout << "Fatal error: Range out of bounds." << std::endl;
+        exit(1);
+    }
+    while (n > 0)
+    {
+        size_t offset = i % chunkSize;
+        size_t k = std::min(n, chunkSize - offset);
+        memcpy(out, current->chunks[i / chunkSize]->bytes + offset, k);
+        out += k;
+        i += k;
+        n -= k;
+    }
+}
+
+size_t concurrentData::snapshot::chunkCount() const
+{
+    return current->chunks.size();
+}
+
+data::view concurrentData::snapshot::chunkAt(size_t k) const
+{
+    if (k >= current->chunks.size())
+    {
+        std::cout << "Fatal error: Index out of bounds." << std::endl;
+        exit(1);
+    }
+    size_t n = k + 1 < current->chunks.size() ? chunkSize : current->length - k * chunkSize;
+    return data::view(current->chunks[k]->bytes, n);
+}
+
+data concurrentData::snapshot::copy() const
+{
+    data d;
+    if (current->length == 0)
+        return d;
+    d.reserve(current->length);
+    for (size_t k = 0; k < current->chunks.size(); k++)
+    {
+        data::view v = chunkAt(k);
+        d.insertBytes(v.begin(), v.size(), d.size());
+    }
+    return d;
+}
+
+uint64_t concurrentData::snapshot::versionNumber() const
+{
+    return current->number;
+}
+
+/** Public Member Functions **/
+
+/*** Constructors & Destructors ***/
+
+concurrentData::concurrentData() : epoch(0)
+{
+    for (readerSlot &s : slots)
+    {
+        s.active[0].store(0, std::memory_order_relaxed);
+        s.active[1].store(0, std::memory_order_relaxed);
+    }
+    current.store(new version{0, 0, {}});
+}
+
+concurrentData::concurrentData(data &d) : concurrentData()
+{
+    data::view all = d.viewAll();
+    if (all.empty())
+        return;
+    // Nothing can read the empty version yet, so publishing frees it at once.
+    data::editBatch::edit e = {0, 0, 0, all.size()};
+    publish(std::vector<data::editBatch::edit>(1, e), all.begin());
+}
+
+concurrentData::~concurrentData()
+{
+    for (int parity = 0; parity < 2; parity++)
+        for (version *v : retired[parity])
+            release(v);
+    release(current.load());
+}
+
+/*** Reading ***/
+
+concurrentData::snapshot concurrentData::read()
+{
+    readerSlot &slot = slots[readerIndex()];
+    for (;;)
+    {
+        // Announced in the epoch it is still in after announcing, the reader will not see a
+        // version freed before it is done.
+        uint64_t e = epoch.load();
+        std::atomic<size_t> *pin = &slot.active[e & 1];
+        pin->fetch_add(1);
+        if (epoch.load() == e)
+            return snapshot(pin, current.load());
+        pin->fetch_sub(1, std::memory_order_release);
+    }
+}
+
+size_t concurrentData::size()
+{
+    return read().size();
+}
+
+/*** Writing ***/
+
+void concurrentData::appendByte(byte b)
+{
+    appendBytes(&b, 1);
+}
+
+void concurrentData::appendBytes(const byte *b, size_t n)
+{
+    if (n == 0)
+        return;
+    std::lock_guard<std::mutex> lock(writer);
+    size_t length = current.load(std::memory_order_relaxed)->length;
+    data::editBatch::edit e = {length, length, 0, n};
+    publish(std::vector<data::editBatch::edit>(1, e), b);
+}
+
+void concurrentData::insertBytes(const byte *b, size_t n, size_t i)
+{
+    data::editBatch batch;
+    batch.insertBytes(b, n, i);
+    applyEdits(batch);
+}
+
+void concurrentData::overrideBytes(const byte *b, size_t n, data::range &r)
+{
+    data::editBatch batch;
+    batch.overrideBytes(b, n, r);
+    applyEdits(batch);
+}
+
+void concurrentData::overrideBytes(const byte *b, size_t n, size_t i)
+{
+    data::editBatch batch;
+    batch.overrideBytes(b, n, i);
+    applyEdits(batch);
+}
+
+void concurrentData::removeBytesIn(data::range r)
+{
+    data::editBatch batch;
+    batch.removeBytesIn(r);
+    applyEdits(batch);
+}
+
+bool concurrentData::applyEdits(data::editBatch &batch)
+{
+    if (batch.empty())
+        return true;
+    std::lock_guard<std::mutex> lock(writer);
+    std::vector<data::editBatch::edit> edits;
+    if (!batch.sorted(current.load(std::memory_order_relaxed)->length, edits))
+        return false;
+    publish(edits, batch.added.data());
+    return true;
+}
+
+/*** Reclamation ***/
+
+void concurrentData::reclaim()
+{
+    std::lock_guard<std::mutex> lock(writer);
+    while (!retired[0].empty() || !retired[1].empty())
+        if (!advance())
+            std::this_thread::yield();
+}
+
+size_t concurrentData::retiredVersions()
+{
+    std::lock_guard<std::mutex> lock(writer);
+    return retired[0].size() + retired[1].size();
+}
+
+/** Private Member Functions **/
+
+void concurrentData::publish(const std::vector<data::editBatch::edit> &edits, const byte *added)
+{
+    version *old = current.load(std::memory_order_relaxed);
+    version *next = new version{old->number + 1, 0, {}};
+    next->chunks.reserve(old->chunks.size() + 1);
+    
+    // Copies bytes to the end of the new version, filling its last chunk first.
+    auto put = [next](const byte *b, size_t n) {
+        while (n > 0)
+        {
+            size_t offset = next->length % chunkSize;
+            if (offset == 0)
+            {
+                chunk *c = new chunk;
+                c->references = 1;
+                c->used = 0;
+                next->chunks.push_back(c);
+            }
+            else if (next->chunks.back()->used != offset)
+            {
+                // Another version wrote past this point; the new bytes go into a copy.
+                chunk *shared = next->chunks.back();
+                chunk *c = new chunk;
+                c->references = 1;
+                c->used = offset;
+                memcpy(c->bytes, shared->bytes, offset);
+                shared->references--;
+                next->chunks.back() = c;
+            }
+            chunk *c = next->chunks.back();
+            size_t k = std::min(n, chunkSize - offset);
+            memcpy(c->bytes + offset, b, k);
+            c->used = offset + k;
+            next->length += k;
+            b += k;
+            n -= k;
+        }
+    };
+    
+    // Carries the old bytes in [i, end) over, sharing every whole chunk that lines up.
+    auto keep = [next, old, &put](size_t i, size_t end) {
+        while (i < end)
+        {
+            size_t k = i / chunkSize;
+            size_t chunkEnd = std::min((k + 1) * chunkSize, old->length);
+            if (i % chunkSize == 0 && next->length % chunkSize == 0 && chunkEnd <= end)
+            {
+                old->chunks[k]->references++;
+                next->chunks.push_back(old->chunks[k]);
+                next->length += chunkEnd - i;
+                i = chunkEnd;
+            }
+            else
+            {
+                size_t stop = std::min(chunkEnd, end);
+                put(old->chunks[k]->bytes + i % chunkSize, stop - i);
+                i = stop;
+            }
+        }
+    };
+    
+    size_t i = 0;
+    for (const data::editBatch::edit &e : edits)
+    {
+        keep(i, e.begin);
+        put(added + e.offset, e.length);
+        i = e.end;
+    }
+    keep(i, old->length);
+    
+    current.store(next);
+    retired[epoch.load(std::memory_order_relaxed) & 1].push_back(old);
+    
+    // Without readers in the way, this frees the old version straight away.
+    if (advance())
+        advance();
+}
+
+bool concurrentData::advance()
+{
+    uint64_t e = epoch.load(std::memory_order_relaxed);
+    std::vector<version *> &previous = retired[(e + 1) & 1];
+    for (readerSlot &s : slots)
+        if (s.active[(e + 1) & 1].load() != 0)
+            return false;
+    
+    for (version *v : previous)
+        release(v);
+    previous.clear();
+    epoch.store(e + 1);
+    return true;
+}
+
+void concurrentData::release(version *v)
+{
+    for (chunk *c : v->chunks)
+        if (--c->references == 0)
+            delete c;
+    delete v;
+}
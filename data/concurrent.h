@@ -0,0 +1,169 @@
+#ifndef CONCURRENT_H
+#define CONCURRENT_H
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "data.h"
+
+/** concurrentData declaration **/
+
+// Bytes shared by many reader threads and changed by writers, with snapshot isolation. Every
+// change publishes a new immutable version with a single atomic store, and readers take
+// snapshots of the current one without ever blocking or seeing a change halfway.
+//
+// A version is an array of refcounted chunks of chunkSize bytes, and a new version shares every
+// chunk an edit did not touch: overriding bytes copies the chunks they are in, appending copies
+// the last chunk, and inserting or removing copies the chunks from the edit on (unless they line
+// up again). Writers are serialized by a mutex; batching edits through applyEdits publishes them
+// as one version.
+//
+// Versions that are no longer current are reclaimed by the writers with epochs: a reader
+// announces the parity of the epoch it started in, and the versions retired during an epoch are
+// freed once no reader is left from the epoch before it.
+
+class concurrentData {
+private:
+    struct chunk;
+    struct version;
+
+public:
+    static const size_t chunkSize = 64 * 1024;  // The size of every chunk but the last.
+    static const size_t readerSlots = 64;       // The amount of counters readers announce in.
+    
+    class snapshot {
+    public:
+        snapshot(snapshot &&s) noexcept;
+        snapshot & operator=(snapshot &&s) noexcept;
+        ~snapshot();
+        // Postcondition: Lets the version be reclaimed once no other snapshot uses it.
+        
+        size_t size() const;
+        // Postcondition: Returns the amount of bytes in the snapshot.
+        
+        byte operator[](size_t i) const;
+        // Precondition: i must be less than size().
+        // Postcondition: Returns the byte in the specified index.
+        
+        void copyTo(byte *out, size_t i, size_t n) const;
+        // Precondition: i + n must not exceed size().
+        // Postcondition: Copies the n bytes starting at i into out.
+        
+        size_t chunkCount() const;
+        // Postcondition: Returns the amount of chunks the bytes are split in.
+        
+        data::view chunkAt(size_t k) const;
+        // Precondition: k must be less than chunkCount().
+        // Postcondition: Returns a view of the bytes of chunk k, valid while the snapshot lives.
+        
+        data copy() const;
+        // Postcondition: Returns a data object with a copy of the bytes.
+        
+        uint64_t versionNumber() const;
+        // Postcondition: Returns the number of the version, counting the published ones from 0.
+    
+    private:
+        friend class concurrentData;
+        
+        snapshot(std::atomic<size_t> *pin, const version *v);
+        snapshot(const snapshot &);
+        snapshot & operator=(const snapshot &);
+        
+        std::atomic<size_t> *pin;   // The counter announcing the reader, or nullptr once moved.
+        const version *current;     // The version read.
+    };
+    
+    /*** Constructors & Destructors ***/
+    concurrentData();
+    // Postcondition: Creates an empty object.
+    
+    concurrentData(data &d);
+    // Postcondition: Creates an object whose first version is a copy of the bytes of d.
+    
+    ~concurrentData();
+    // Precondition: No snapshot may be left.
+    // Postcondition: Frees every version.
+    
+    /*** Reading ***/
+    snapshot read();
+    // Postcondition: Returns a snapshot of the current version, without blocking.
+    
+    size_t size();
+    // Postcondition: Returns the amount of bytes in the current version.
+    
+    /*** Writing ***/
+    void appendByte(byte b);
+    // Postcondition: Publishes a version with b appended.
+    
+    void appendBytes(const byte *b, size_t n);
+    // Postcondition: Publishes a version with the n bytes of b appended.
+    
+    void insertBytes(const byte *b, size_t n, size_t i);
+    // Precondition: i must not be larger than the size.
+    // Postcondition: Publishes a version with the n bytes of b inserted before the byte at i.
+    
+    void overrideBytes(const byte *b, size_t n, data::range &r);
+    // Precondition: The range must be between 0 and the size - 1.
+    // Postcondition: Publishes a version with the bytes in the range replaced by the n bytes of b.
+    
+    void overrideBytes(const byte *b, size_t n, size_t i);
+    // Precondition: i + n must not exceed the size.
+    // Postcondition: Publishes a version with the n bytes starting at i overwritten.
+    
+    void removeBytesIn(data::range r);
+    // Precondition: The range must be between 0 and the size - 1.
+    // Postcondition: Publishes a version without the bytes in the range.
+    
+    bool applyEdits(data::editBatch &batch);
+    // Postcondition: Publishes every edit of the batch as a single version, with the same rules as
+    //                data::applyEdits. Returns false, publishing nothing, if edits overlap.
+    
+    /*** Reclamation ***/
+    void reclaim();
+    // Postcondition: Waits for the readers of old versions to finish and frees every retired
+    //                version. Publishing reclaims what it can without waiting.
+    
+    size_t retiredVersions();
+    // Postcondition: Returns the amount of versions waiting for readers to finish.
+
+private:
+    struct chunk {
+        size_t references;          // The versions using the chunk.
+        size_t used;                // The bytes any version wrote.
+        byte bytes[chunkSize];
+    };
+    
+    struct version {
+        uint64_t number;            // The amount of versions published before it.
+        size_t length;              // The amount of bytes.
+        std::vector<chunk *> chunks;
+    };
+    
+    struct alignas(64) readerSlot {
+        std::atomic<size_t> active[2];  // The readers announced in even and odd epochs.
+    };
+    
+    concurrentData(const concurrentData &);
+    concurrentData & operator=(const concurrentData &);
+    
+    void publish(const std::vector<data::editBatch::edit> &edits, const byte *added);
+    // Precondition: The writer mutex must be held, and edits sorted and disjoint.
+    // Postcondition: Builds the next version from the current one and the edits, makes it
+    //                current and retires the previous one.
+    
+    bool advance();
+    // Postcondition: Moves to the next epoch and frees the versions retired two epochs ago, if
+    //                no reader from the previous epoch is left. Returns false otherwise.
+    
+    void release(version *v);
+    // Postcondition: Frees a version and the chunks no other version uses.
+    
+    std::atomic<version *> current;     // The version new snapshots read.
+    std::atomic<uint64_t> epoch;        // The current epoch.
+    readerSlot slots[readerSlots];      // Where readers announce themselves.
+    
+    std::mutex writer;                  // Serializes writers.
+    std::vector<version *> retired[2];  // Versions retired in even and odd epochs.
+};
+
+#endif
@@ -1,18 +1,92 @@
 #include <iostream>
 #include <string>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
 #include <cstdlib>
+#include <cerrno>
+#include <algorithm>
+#include <cstring>
+#include <climits>
+#include <map>
+#include <mutex>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <unistd.h>
 #include "data.h"
+#include "piecetable.h"
+#include "blockstore.h"
+#include "ring.h"
+
+// Files smaller than this are cheaper to read than to map in automatic mode.
+static const size_t mapThreshold = 64 * 1024;
+
+// Marks a dirty extent that runs to the end of the bytes, whatever their size.
+static const size_t dirtyToEnd = SIZE_MAX;
+
+// Piece tables are written through a buffer of this size instead of being flattened.
+static const size_t bounceSize = 1024 * 1024;
+
+// Owned buffers from the new/delete resource at least this large are mapped directly, so that
+// growing and shrinking them moves pages with mremap instead of copying bytes.
+static const size_t pageThreshold = 1024 * 1024;
+
+static bool pageBacked(std::pmr::memory_resource *resource, size_t n)
+{
+    return n >= pageThreshold && resource == std::pmr::new_delete_resource();
+}
+
+static byte * allocateFrom(std::pmr::memory_resource *resource, size_t n)
+{
+    if (!pageBacked(resource, n))
+        return static_cast<byte *>(resource->allocate(n, alignof(std::max_align_t)));
+    
+    void *m = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED)
+        throw std::bad_alloc();
+    return static_cast<byte *>(m);
+}
+
+static void deallocateFrom(std::pmr::memory_resource *resource, byte *b, size_t n)
+{
+    if (pageBacked(resource, n))
+        munmap(b, n);
+    else
+        resource->deallocate(b, n, alignof(std::max_align_t));
+}
+
+// Every file mapped by a data object or a shared block in this process, by device and inode,
+// with the amount of mappings of it. Saves never write into or cut a file that another one maps.
+static std::mutex mappingsLock;
+static std::map<std::pair<dev_t, ino_t>, size_t> mappings;
+
+static void holdMapping(dev_t device, ino_t inode)
+{
+    std::lock_guard<std::mutex> lock(mappingsLock);
+    mappings[std::make_pair(device, inode)]++;
+}
+
+static void releaseMapping(dev_t device, ino_t inode)
+{
+    std::lock_guard<std::mutex> lock(mappingsLock);
+    std::map<std::pair<dev_t, ino_t>, size_t>::iterator i = mappings.find(std::make_pair(device, inode));
+    if (i != mappings.end() && --i->second == 0)
+        mappings.erase(i);
+}
+
+static size_t mappingsOf(dev_t device, ino_t inode)
+{
+    std::lock_guard<std::mutex> lock(mappingsLock);
+    std::map<std::pair<dev_t, ino_t>, size_t>::const_iterator i = mappings.find(std::make_pair(device, inode));
+    return i == mappings.end() ? 0 : i->second;
+}
 
 /** Public Class Objects **/
-data::range::range(int l, int u)
+data::range::range(size_t l, size_t u)
 {
-    if (l < 0) {
-        std::cout << "Fatal error: Attempted to start a range at a value less than 0." << std::endl;
-        exit(1);
-    } else if (u <= l) {
+    if (u <= l) {
         std::cout << "Fatal error: Attempted to create an upper bound less or equal to lower bound." << std::endl;
         exit(1);
     }
@@ -22,510 +96,1957 @@ data::range::range(int l, int u)
     distance = u - l;
 }
 
-int data::range::lowerBound()
+size_t data::range::lowerBound()
 {
     return lower;
 }
 
-int data::range::upperBound()
+size_t data::range::upperBound()
 {
     return upper;
 }
 
-int data::range::rangeDistance()
+size_t data::range::rangeDistance()
+{
+    return distance;
+}
+
+data::view::view()
+{
+    first = nullptr;
+    length = 0;
+}
+
+data::view::view(const byte *b, size_t n)
+{
+    first = b;
+    length = n;
+}
+
+size_t data::view::size() const
+{
+    return length;
+}
+
+bool data::view::empty() const
+{
+    return length == 0;
+}
+
+const byte * data::view::begin() const
+{
+    return first;
+}
+
+const byte * data::view::end() const
+{
+    return first + length;
+}
+
+byte data::view::operator[](size_t i) const
+{
+    return first[i];
+}
+
+data::view data::view::slice(size_t i, size_t n) const
+{
+    if (i > length || n > length - i) {
+        std::cout << "Fatal error: Slice out of bounds." << std::endl;
+        exit(1);
+    }
+    
+    return view(first + i, n);
+}
+
+std::string data::view::digest() const
+{
+    return std::string(reinterpret_cast<const char *>(first), length);
+}
+
+bool data::view::operator==(const view &v) const
+{
+    return length == v.length && (length == 0 || std::memcmp(first, v.first, length) == 0);
+}
+
+bool data::view::operator!=(const view &v) const
+{
+    return !(*this == v);
+}
+
+bool data::view::operator<(const view &v) const
+{
+    size_t n = std::min(length, v.length);
+    int c = n > 0 ? std::memcmp(first, v.first, n) : 0;
+    return c < 0 || (c == 0 && length < v.length);
+}
+
+// Owns the bytes of a data object once they are shared, either an array or a file mapping.
+struct data::sharedView::block {
+    byte *bytes;
+    size_t length;
+    bool mapped;
+    dev_t device;           // Device of the mapped file.
+    ino_t inode;            // Inode of the mapped file.
+    std::pmr::memory_resource *resource;
+    
+    ~block()
+    {
+        if (bytes == nullptr)
+            return;
+        if (mapped)
+        {
+            munmap(bytes, length);
+            releaseMapping(device, inode);
+        }
+        else
+            deallocateFrom(resource, bytes, length);
+    }
+};
+
+data::sharedView::sharedView()
+{
+}
+
+size_t data::sharedView::size() const
+{
+    return bytes.size();
+}
+
+bool data::sharedView::empty() const
+{
+    return bytes.empty();
+}
+
+const byte * data::sharedView::begin() const
+{
+    return bytes.begin();
+}
+
+const byte * data::sharedView::end() const
+{
+    return bytes.end();
+}
+
+byte data::sharedView::operator[](size_t i) const
+{
+    return bytes[i];
+}
+
+data::sharedView data::sharedView::slice(size_t i, size_t n) const
+{
+    sharedView v;
+    v.owner = owner;
+    v.bytes = bytes.slice(i, n);
+    return v;
+}
+
+data::view data::sharedView::asView() const
+{
+    return bytes;
+}
+
+std::string data::sharedView::digest() const
+{
+    return bytes.digest();
+}
+
+bool data::sharedView::operator==(const sharedView &v) const
+{
+    return bytes == v.bytes;
+}
+
+bool data::sharedView::operator!=(const sharedView &v) const
+{
+    return bytes != v.bytes;
+}
+
+bool data::sharedView::operator<(const sharedView &v) const
+{
+    return bytes < v.bytes;
+}
+
+data::editBatch::editBatch()
+{
+}
+
+void data::editBatch::insertBytes(const byte *b, size_t n, size_t i)
+{
+    record(b, n, i, i);
+}
+
+void data::editBatch::overrideBytes(const byte *b, size_t n, range r)
+{
+    record(b, n, r.lowerBound(), r.upperBound() + 1);
+}
+
+void data::editBatch::overrideBytes(const byte *b, size_t n, size_t i)
+{
+    record(b, n, i, i + n);
+}
+
+void data::editBatch::removeBytesIn(range r)
+{
+    record(nullptr, 0, r.lowerBound(), r.upperBound() + 1);
+}
+
+void data::editBatch::removeByteAt(size_t i)
+{
+    record(nullptr, 0, i, i + 1);
+}
+
+size_t data::editBatch::size() const
+{
+    return edits.size();
+}
+
+bool data::editBatch::empty() const
+{
+    return edits.empty();
+}
+
+void data::editBatch::clear()
+{
+    edits.clear();
+    added.clear();
+}
+
+void data::editBatch::record(const byte *b, size_t n, size_t begin, size_t end)
+{
+    edit e = {begin, end, added.size(), n};
+    edits.push_back(e);
+    if (n > 0)
+        added.insert(added.end(), b, b + n);
+}
+
+bool data::editBatch::sorted(size_t n, std::vector<edit> &ordered)
+{
+    ordered = edits;
+    std::stable_sort(ordered.begin(), ordered.end(), [](const edit &a, const edit &b) {
+        return a.begin != b.begin ? a.begin < b.begin : a.end < b.end;
+    });
+    
+    for (size_t i = 0; i < ordered.size(); i++)
+    {
+        if (ordered[i].end > n)
+        {
+            std::cout << "Fatal error: Edit out of bounds." << std::endl;
+            exit(1);
+        }
+        if (i > 0 && ordered[i].begin < ordered[i - 1].end)
+        {
+            std::cout << "Error: Attempted to apply overlapping edits." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Public Member Functions **/
+
+/*** Constructors & Destructor ***/
+data::data()
+{
+    resource = std::pmr::get_default_resource();
+    initialize();
+}
+
+data::data(std::pmr::memory_resource *r)
+{
+    resource = r;
+    initialize();
+}
+
+data::data(std::string fpath, loadMode mode, std::pmr::memory_resource *r)
+{
+    resource = r;
+    initialize();
+    filePath = fpath;
+    DATA_STATS_TIME(loadOp);
+    
+    int fd = open(fpath.c_str(), mode == writable ? O_RDWR : O_RDONLY);
+    if (fd < 0)
+    {
+        std::cout << "Fatal error: Could not read file: " << fpath << std::endl;
+        exit(1);
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        std::cout << "Fatal error: Could not read file: " << fpath << std::endl;
+        exit(1);
+    }
+    
+    bool regular = S_ISREG(st.st_mode) && st.st_size > 0;
+    size_t length = regular ? static_cast<size_t>(st.st_size) : 0;
+    
+    // A writable file keeps its descriptor for growing the mapping; an empty one is mapped once
+    // it grows.
+    if (mode == writable && S_ISREG(st.st_mode))
+    {
+        void *m = length > 0 ? mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : nullptr;
+        if (m != MAP_FAILED)
+        {
+            mapping = static_cast<const byte *>(m);
+            mappingLength = length;
+            mappedFile = fd;
+            fileLength = length;
+            if (m != nullptr)
+                bytes = static_cast<byte *>(m);
+            mappedDevice = st.st_dev;
+            mappedInode = st.st_ino;
+            holdMapping(mappedDevice, mappedInode);
+            count = length;
+            internalCapacity = length;
+            track(fd);
+            return;
+        }
+    }
+    
+    if (regular && (mode == mapped || (mode == automatic && length >= mapThreshold)))
+    {
+        void *m = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED)
+        {
+            madvise(m, length, MADV_SEQUENTIAL);
+            mapping = static_cast<const byte *>(m);
+            mappingLength = length;
+            bytes = const_cast<byte *>(mapping);
+            mappedDevice = st.st_dev;
+            mappedInode = st.st_ino;
+            holdMapping(mappedDevice, mappedInode);
+            count = length;
+        }
+    }
+    
+    if (mode == parallel || mode == parallelDirect)
+        useParallelIO(0, mode == parallelDirect);
+    
+    // Pipes, special files and failed mappings take the bulk read path, as do files too small to
+    // split.
+    if (mapping == nullptr && ioThreads != 1 && length >= 2 * parallelChunk)
+        readParallel(fd, length);
+    else if (mapping == nullptr)
+        readDescriptor(fd, length);
+    
+    // A compressed file is read whole and parsed, keeping its blocks. It is rewritten whole when
+    // saved, so it is not tracked.
+    if (mode == compressedFile)
+    {
+        close(fd);
+        blocks = blockStore::fromContainer(view(bytes, count), resource);
+        if (blocks == nullptr)
+        {
+            std::cout << "Fatal error: Not a compressed file: " << fpath << std::endl;
+            exit(1);
+        }
+        releaseBytes();
+        bytes = inlineBytes;
+        internalCapacity = inlineCapacity;
+        count = blocks->size();
+        fileFormat = compressedFormat;
+        return;
+    }
+    
+    if (regular)
+        track(fd);
+    
+    close(fd);
+}
+
+data::data(const byte *b, size_t n, std::pmr::memory_resource *r)
+{
+    resource = r;
+    initialize();
+    if (n > inlineCapacity)
+    {
+        bytes = allocateBytes(n);
+        internalCapacity = n;
+    }
+    if (n > 0)
+        std::memcpy(bytes, b, n);
+    count = n;
+}
+
+data::data(const std::byte *b, size_t n, std::pmr::memory_resource *r) : data(reinterpret_cast<const byte *>(b), n, r)
+{
+}
+
+data::data(const data &d) : data(d, std::pmr::get_default_resource())
+{
+}
+
+data::data(const data &d, std::pmr::memory_resource *r)
+{
+    resource = r;
+    initialize();
+    DATA_STATS_TIME(copyOp);
+    count = d.count;
+    maxCapacity = d.maxCapacity;
+    growth = d.growth;
+    growthStep = d.growthStep;
+    filePath = d.filePath;
+    ioThreads = d.ioThreads;
+    ioDirect = d.ioDirect;
+    pieceEditing = d.pieceEditing;
+    fileFormat = d.fileFormat;
+    
+    // Tracking stays off as initialize() left it: the original may save its own edits before the
+    // copy's first save, which therefore writes the whole file.
+    
+    // Mapped, piece table and compressed sources are copied into a buffer of their exact size.
+    size_t n = d.mapping || d.pieces || d.blocks ? count : d.internalCapacity;
+    if (n > inlineCapacity)
+    {
+        bytes = allocateBytes(n);
+        internalCapacity = n;
+    }
+    
+    if (d.pieces || d.blocks)
+        d.copyStored(bytes, 0, count);
+    else
+        std::memcpy(bytes, d.bytes, count);
+    DATA_STATS_ONLY(stats.recordCopy(count));
+}
+
+data::data(data &&d) noexcept
+{
+    resource = d.resource;
+    initialize();
+    steal(d);
+}
+
+data::data(size_t n, std::pmr::memory_resource *r)
+{
+    
+    if (n == 0)
+    {
+        std::cout << "Fatal error: Attempted to set an invalid capacity." << std::endl;
+        exit(1);
+    }
+    
+    resource = r;
+    initialize();
+    maxCapacity = n;
+    if (n != unlimited && n > inlineCapacity)
+    {
+        bytes = allocateBytes(n);
+        internalCapacity = n;
+    }
+    else if (n != unlimited)
+    {
+        internalCapacity = n;
+    }
+}
+
+//data::data(int nBytes)
+//{
+//    bytes = new byte[n];
+//    count = n - 1;
+//    for (int i = 0; i < n; i++)
+//        bytes[i] = 0;
+//
+//    filePath = "";
+//    maxCapacity = -1;
+//    internalCapacity = n;
+//}
+
+data::~data()
+{
+    delete pieces;
+    delete blocks;
+    releaseBytes();
+}
+
+data & data::operator=(const data &d)
+{
+    if (this != &d)
+    {
+        data tmp(d, resource);
+        swap(tmp);
+    }
+    return *this;
+}
+
+data & data::operator=(data &&d) noexcept
+{
+    if (this != &d)
+    {
+        delete pieces;
+        delete blocks;
+        releaseBytes();
+        initialize();
+        steal(d);
+    }
+    return *this;
+}
+
+void data::swap(data &d) noexcept
+{
+    if (this == &d)
+        return;
+    
+    data tmp(std::move(d));
+    d = std::move(*this);
+    *this = std::move(tmp);
+}
+
+void swap(data &a, data &b) noexcept
+{
+    a.swap(b);
+}
+
+/*** Representation of buffer of bytes ***/
+std::string data::digest()
+{
+    flatten();
+    return std::string(reinterpret_cast<const char *>(bytes), count);
+}
+
+std::string data::hexDigest()
+{
+    flatten();
+    std::string s(2 * size(), '\0');
+    hexEncode(bytes, size(), &s[0]);
+    return s;
+}
+
+/*** File manipulation ***/
+void data::save(saveMode mode)
+{
+    DATA_STATS_TIME(saveOp);
+    if (filePath == "")
+    {
+        std::cout << "Error: Attempted to save when file is not loaded." << std::endl;
+        std::cout << "Call \'saveToPath\' and provide a file path instead." << std::endl;
+        return;
+    }
+    
+    // A compressed file is written whole, so a mapping of the file it replaces must not need it.
+    if (fileFormat == compressedFormat && mapping)
+    {
+        closeFile();
+        detach();
+    }
+    
+    struct stat st;
+    bool exists = stat(filePath.c_str(), &st) == 0;
+    
+    // The dirty extents only describe the tracked file, and only while nobody else resized it.
+    bool patch = exists && tracking && fileFormat == plainFormat && st.st_dev == savedDevice && st.st_ino == savedInode &&
+                 static_cast<size_t>(st.st_size) == savedLength;
+    
+    // Other mappings of the file, in any object or shared view, read its pages for as long as
+    // they live, so while one is left the file is replaced instead of written into or cut. This
+    // object's own mapping only counts as its own while no view shares it.
+    bool ownMapping = (mapping || mappedFile >= 0) && (!shared || shared.use_count() == 1);
+    if (exists && mappingsOf(st.st_dev, st.st_ino) > (ownMapping && st.st_dev == mappedDevice &&
+                                                      st.st_ino == mappedInode ? 1 : 0))
+        mode = atomicReplace;
+    
+    // A writable mapping is the file already, so saving it in place only has to flush it. Any
+    // other save writes the whole file, since the mapped one may be longer than the bytes.
+    if (mappedFile >= 0 && mode == inPlace && exists && st.st_dev == mappedDevice && st.st_ino == mappedInode)
+    {
+        if (!syncFile())
+            std::cout << "Failed to save." << std::endl;
+        return;
+    }
+    if (mappedFile >= 0)
+        patch = false;
+    
+    if (mode == inPlace && exists && mapping && st.st_dev == mappedDevice && st.st_ino == mappedInode)
+    {
+        // An untouched mapping already matches its own file, and truncating that file would
+        // pull the pages out from under the mapping, so only other targets are written.
+        if (pieces == nullptr)
+            return;
+        
+        // Original pieces keep their file offsets until bytes shift; after that, patching would
+        // overwrite bytes they still read.
+        if (!patch || shifted())
+            flatten();
+    }
+    
+    bool saved;
+    if (mode == atomicReplace)
+    {
+        mode_t mask = umask(0);
+        umask(mask);
+        saved = replaceFile(patch, exists ? st.st_mode & 07777 : 0666 & ~mask);
+    }
+    else
+    {
+        saved = patch ? patchFile() : rewriteFile();
+    }
+    
+    if (!saved)
+        std::cout << "Failed to save." << std::endl;
+    
+    // A writable mapping follows the file it was saved to, so that edits keep going to it.
+    if (saved && mappedFile >= 0)
+        remapFile();
+}
+
+void data::saveToPath(std::string fpath, saveMode mode, saveFormat format)
+{
+    filePath = fpath;
+    fileFormat = format;
+    save(mode);
+}
+
+/*** Bytes retrieval ***/
+byte data::operator[](size_t i)
+{
+    if (i >= count) {
+        std::cout << "Fatal error: Index out of bounds." << std::endl;
+        exit(1);
+    }
+    
+    if (pieces || blocks)
+        return storedAt(i);
+    
+    return bytes[i];
+}
+
+byte * data::bytesInRange(data::range &r)
+{
+    if (r.upperBound() >= count){
+        std::cout << "Fatal error: Range out of bounds." << std::endl;
+        exit(1);
+    }
+    
+    byte *buffer = new byte[r.rangeDistance() + 1];
+    
+    if (pieces || blocks)
+        copyStored(buffer, r.lowerBound(), r.rangeDistance() + 1);
+    else
+        std::memcpy(buffer, bytes + r.lowerBound(), r.rangeDistance() + 1);
+    
+    return buffer;
+}
+
+bool data::at(size_t i, byte &b)
+{
+    if (i >= count)
+    {
+        std::cout << "Error: Index out of bounds." << std::endl;
+        return false;
+    }
+    
+    b = pieces || blocks ? storedAt(i) : bytes[i];
+    return true;
+}
+
+
+const byte * data::begin()
+{
+    flatten();
+    return bytes;
+}
+
+const byte * data::end()
+{
+    flatten();
+    return bytes + count;
+}
+
+const byte * data::rawBytes()
+{
+    return begin();
+}
+
+byte * data::mutableBytes()
+{
+    flatten();
+    detach();
+    markDirty(0, dirtyToEnd);
+    return bytes;
+}
+
+data::view data::viewAll()
+{
+    flatten();
+    return view(bytes, count);
+}
+
+data::view data::viewInRange(data::range &r)
+{
+    if (r.upperBound() >= count){
+        std::cout << "Fatal error: Range out of bounds." << std::endl;
+        exit(1);
+    }
+    
+    if (blocks)
+        return view(blocks->range(r.lowerBound(), r.rangeDistance() + 1), r.rangeDistance() + 1);
+    
+    flatten();
+    return view(bytes + r.lowerBound(), r.rangeDistance() + 1);
+}
+
+data::sharedView data::shareAll()
+{
+    flatten();
+    share();
+    
+    sharedView v;
+    v.owner = shared;
+    v.bytes = view(bytes, count);
+    return v;
+}
+
+data::sharedView data::shareRange(data::range &r)
+{
+    if (r.upperBound() >= count){
+        std::cout << "Fatal error: Range out of bounds." << std::endl;
+        exit(1);
+    }
+    
+    flatten();
+    share();
+    
+    sharedView v;
+    v.owner = shared;
+    v.bytes = view(bytes + r.lowerBound(), r.rangeDistance() + 1);
+    return v;
+}
+
+/*** Bytes manipulation ***/
+void data::appendByte(byte b)
+{
+    DATA_STATS_TIME(appendOp);
+    if (maxCapacity != unlimited && count == maxCapacity)
+    {
+        if (!(ring && ringOverwrite))
+        {
+            std::cout << "Error: Attempted to append a byte when the buffer has no more capacity." << std::endl;
+            return;
+        }
+        popFront(1);
+    }
+    
+    markDirty(count, count + 1);
+    
+    if (pieceEditing)
+    {
+        editTable()->insert(count, &b, 1);
+        count++;
+        return;
+    }
+    
+    detach();
+    
+    makeRoom(count + 1);
+    bytes[count++] = b;
+}
+
+void data::prependByte(byte b)
+{
+    DATA_STATS_TIME(prependOp);
+    if (maxCapacity != unlimited && count == maxCapacity)
+    {
+        std::cout << "Error: Attempted to append a byte when the buffer has no more capacity." << std::endl;
+        return;
+    }
+    
+    markDirty(0, dirtyToEnd);
+    
+    if (pieceEditing)
+    {
+        editTable()->insert(0, &b, 1);
+        count++;
+        return;
+    }
+    
+    detach();
+    
+    makeRoom(count + 1);
+    
+    std::memmove(bytes + 1, bytes, count);
+    DATA_STATS_ONLY(stats.recordCopy(count));
+    bytes[0] = b;
+    count++;
+}
+
+void data::insertBytes(const byte *b, size_t n, size_t i)
+{
+    DATA_STATS_TIME(insertOp);
+    if (i > count) {
+        std::cout << "Fatal error: Index out of bounds." << std::endl;
+        exit(1);
+    }
+    
+    // An overwriting ring makes room for appended bytes by dropping the oldest ones.
+    if (ring && ringOverwrite && i == count && n > maxCapacity - count)
+    {
+        if (n > maxCapacity)
+        {
+            b += n - maxCapacity;
+            n = maxCapacity;
+        }
+        popFront(n - (maxCapacity - count));
+        i = count;
+    }
+    
+    if (maxCapacity != unlimited && count == maxCapacity)
+    {
+        std::cout << "Error: Attempted to insert a buffer of bytes when there is no more capacity." << std::endl;
+        return;
+    }
+    
+    // Written as a subtraction so that count + n cannot overflow, even without a limit.
+    if (n > maxCapacity - count)
+    {
+        std::cout << "Error: Attempted to insert a buffer of bytes when it will exceed the capacity." << std::endl;
+        return;
+    }
+    
+    markDirty(i, i == count ? i + n : dirtyToEnd);
+    
+    if (pieceEditing)
+    {
+        editTable()->insert(i, b, n);
+        count += n;
+        return;
+    }
+    
+    detach();
+    
+    makeRoom(count + n);
+    
+    std::memmove(bytes + i + n, bytes + i, count - i);
+    DATA_STATS_ONLY(stats.recordCopy(count - i));
+    std::memcpy(bytes + i, b, n);
+    count += n;
+}
+
+void data::insertBytes(const std::byte *b, size_t n, size_t i)
+{
+    insertBytes(reinterpret_cast<const byte *>(b), n, i);
+}
+
+void data::overrideBytes(const byte *b, size_t n, range &r)
+{
+    DATA_STATS_TIME(overrideOp);
+    if (r.upperBound() >= count) {
+        std::cout << "Fatal error: Range out of bounds." << std::endl;
+        exit(1);
+    }
+    
+    size_t kept = count - r.rangeDistance() - 1;
+    
+    if (n > maxCapacity - kept)
+    {
+        std::cout << "Error: Attempted to insert a buffer of bytes when it will exceed the capacity." << std::endl;
+        return;
+    }
+    
+    markDirty(r.lowerBound(), n == r.rangeDistance() + 1 ? r.lowerBound() + n : dirtyToEnd);
+    
+    if (pieceEditing)
+    {
+        editTable()->remove(r.lowerBound(), r.rangeDistance() + 1);
+        pieces->insert(r.lowerBound(), b, n);
+        count = kept + n;
+        return;
+    }
+    
+    detach();
+    
+    makeRoom(kept + n);
+    
+    std::memmove(bytes + r.lowerBound() + n, bytes + r.upperBound() + 1, count - r.upperBound() - 1);
+    DATA_STATS_ONLY(if (n != r.rangeDistance() + 1) stats.recordCopy(count - r.upperBound() - 1));
+    std::memcpy(bytes + r.lowerBound(), b, n);
+    count = kept + n;
+}
+
+void data::overrideBytes(const std::byte *b, size_t n, range &r)
+{
+    overrideBytes(reinterpret_cast<const byte *>(b), n, r);
+}
+
+void data::removeByteAt(size_t i)
+{
+    DATA_STATS_TIME(removeOp);
+    if (i >= count)
+    {
+        std::cout << "Fatal error: Attempted to remove a byte out of bounds." << std::endl;
+        exit(1);
+    }
+    
+    markDirty(i, dirtyToEnd);
+    
+    if (pieceEditing)
+    {
+        editTable()->remove(i, 1);
+        count--;
+        return;
+    }
+    
+    detach();
+    
+    std::memmove(bytes + i, bytes + i + 1, count - i - 1);
+    DATA_STATS_ONLY(stats.recordCopy(count - i - 1));
+    count--;
+}
+
+void data::removeBytesIn(data::range r)
+{
+    DATA_STATS_TIME(removeOp);
+    if (r.upperBound() >= count)
+    {
+        std::cout << "Fatal error: Attempted to remove bytes out of bounds." << std::endl;
+        exit(1);
+    }
+    
+    markDirty(r.lowerBound(), dirtyToEnd);
+    
+    if (pieceEditing)
+    {
+        editTable()->remove(r.lowerBound(), r.rangeDistance() + 1);
+        count -= r.rangeDistance() + 1;
+        return;
+    }
+    
+    detach();
+    
+    std::memmove(bytes + r.lowerBound(), bytes + r.upperBound() + 1, count - r.upperBound() - 1);
+    DATA_STATS_ONLY(stats.recordCopy(count - r.upperBound() - 1));
+    count -= r.rangeDistance() + 1;
+}
+
+bool data::applyEdits(editBatch &batch)
+{
+    DATA_STATS_TIME(applyEditsOp);
+    std::vector<editBatch::edit> edits;
+    if (!batch.sorted(count, edits))
+        return false;
+    
+    size_t removed = 0;
+    size_t inserted = 0;
+    for (const editBatch::edit &e : edits)
+    {
+        removed += e.end - e.begin;
+        inserted += e.length;
+    }
+    
+    size_t kept = count - removed;
+    if (inserted > maxCapacity - kept)
+    {
+        std::cout << "Error: Attempted to apply edits that will exceed the capacity." << std::endl;
+        return false;
+    }
+    
+    if (edits.empty())
+        return true;
+    
+    // Up to the first edit that changes the length, the bytes stay where they were.
+    for (const editBatch::edit &e : edits)
+    {
+        if (e.end - e.begin != e.length)
+        {
+            markDirty(e.begin, dirtyToEnd);
+            break;
+        }
+        if (e.end > e.begin)
+            markDirty(e.begin, e.end);
+    }
+    
+    const byte *added = batch.added.data();
+    
+    if (pieceEditing)
+    {
+        // Last to first, so that the offsets of the edits still to go stay valid.
+        pieceTable *table = editTable();
+        for (size_t i = edits.size(); i-- > 0;)
+        {
+            const editBatch::edit &e = edits[i];
+            if (e.end > e.begin)
+                table->remove(e.begin, e.end - e.begin);
+            if (e.length > 0)
+                table->insert(e.begin, added + e.offset, e.length);
+        }
+        count = kept + inserted;
+        return true;
+    }
+    
+    // A ring has room for any size up to its length, and copying it out of a ring or a writable
+    // file would end it.
+    size_t n = kept + inserted;
+    if (ring || mappedFile >= 0)
+    {
+        makeRoom(n);
+        editInPlace(edits, added);
+        count = n;
+        return true;
+    }
+    
+    // Mapped and shared bytes are read in place, since they are copied anyway.
+    decompress();
+    byte *tmp = buffer(n > 0 ? n : 1);
+    byte *out = tmp;
+    size_t from = 0;
+    for (const editBatch::edit &e : edits)
+    {
+        std::memcpy(out, bytes + from, e.begin - from);
+        out += e.begin - from;
+        if (e.length > 0)
+            std::memcpy(out, added + e.offset, e.length);
+        out += e.length;
+        from = e.end;
+    }
+    std::memcpy(out, bytes + from, count - from);
+    DATA_STATS_ONLY(stats.recordCopy(kept));
+    
+    releaseBytes();
+    bytes = tmp;
+    internalCapacity = tmp == inlineBytes ? inlineCapacity : (n > 0 ? n : 1);
+    count = n;
+    return true;
+}
+
+void data::editInPlace(const std::vector<editBatch::edit> &edits, const byte *added)
+{
+    // The kept bytes moving left go first, front to back, then those moving right, back to front.
+    // Either way a run only lands on bytes that already moved or belong to no run.
+    size_t from = 0;
+    size_t to = 0;
+    for (size_t i = 0; i <= edits.size(); i++)
+    {
+        size_t end = i < edits.size() ? edits[i].begin : count;
+        if (to < from)
+            std::memmove(bytes + to, bytes + from, end - from);
+        to += end - from;
+        if (i < edits.size())
+        {
+            to += edits[i].length;
+            from = edits[i].end;
+        }
+    }
+    
+    for (size_t i = edits.size() + 1; i-- > 0;)
+    {
+        size_t begin = i > 0 ? edits[i - 1].end : 0;
+        size_t end = i < edits.size() ? edits[i].begin : count;
+        to -= end - begin;
+        if (to > begin)
+            std::memmove(bytes + to, bytes + begin, end - begin);
+        if (i > 0)
+        {
+            to -= edits[i - 1].length;
+            std::memcpy(bytes + to, added + edits[i - 1].offset, edits[i - 1].length);
+        }
+    }
+    DATA_STATS_ONLY(stats.recordCopy(count));
+}
+
+void data::setCapacity(size_t n)
+{
+    
+    if (n == 0)
+    {
+        std::cout << "Fatal error: Attempted to set an invalid capacity." << std::endl;
+        exit(1);
+    }
+    
+    flatten();
+    detach();
+    
+    if (n == unlimited)
+    {
+        maxCapacity = unlimited;
+    }
+    else
+    {
+        if (n < count)
+            count = n;
+        
+        resizeBuffer(n);
+        maxCapacity = n;
+    }
+
+}
+
+void data::reserve(size_t n)
+{
+    flatten();
+    detach();
+    
+    n = std::min(n, maxCapacity);
+    if (n > internalCapacity)
+        resizeBuffer(n);
+}
+
+void data::shrinkToFit()
+{
+    flatten();
+    
+    // Mapped bytes are not owned and rings keep their size, so there is nothing to give back.
+    if (mapping || ring)
+        return;
+    
+    detach();
+    
+    size_t n = count > 0 ? count : 1;
+    if (n < internalCapacity && bytes != inlineBytes)
+        resizeBuffer(n);
+}
+
+void data::setGrowthPolicy(growthPolicy policy, size_t step)
+{
+    if (policy == fixedStep && step == 0)
+    {
+        std::cout << "Fatal error: Attempted to set a growth step of 0 bytes." << std::endl;
+        exit(1);
+    }
+    
+    growth = policy;
+    growthStep = step;
+}
+
+/*** Ring buffer ***/
+bool data::useRingBuffer(size_t n, bool overwrite)
+{
+    if (n == 0)
+    {
+        std::cout << "Fatal error: Attempted to set an invalid capacity." << std::endl;
+        exit(1);
+    }
+    
+    flatten();
+    pieceEditing = false;
+    
+    size_t page = mirrorGranularity();
+    n = (n + page - 1) / page * page;
+    byte *m = mapMirrored(n);
+    if (m == nullptr)
+    {
+        std::cout << "Error: Could not map a ring buffer of " << n << " bytes." << std::endl;
+        return false;
+    }
+    
+    // The newest bytes are kept.
+    size_t kept = std::min(count, n);
+    if (kept < count)
+        markDirty(0, dirtyToEnd);
+    std::memcpy(m, bytes + count - kept, kept);
+    DATA_STATS_ONLY(stats.recordAllocation(n));
+    DATA_STATS_ONLY(stats.recordCopy(kept));
+    
+    releaseBytes();
+    bytes = m;
+    ring = m;
+    ringLength = n;
+    ringOverwrite = overwrite;
+    count = kept;
+    internalCapacity = n;
+    maxCapacity = n;
+    return true;
+}
+
+bool data::isRingBuffer()
+{
+    return ring != nullptr;
+}
+
+size_t data::popFront(size_t n)
+{
+    n = std::min(n, count);
+    if (n == 0)
+        return 0;
+    
+    if (ring)
+    {
+        // The second mapping makes the bytes past the end of the ring the ones at its start.
+        markDirty(0, dirtyToEnd);
+        bytes += n;
+        if (bytes >= ring + ringLength)
+            bytes -= ringLength;
+        count -= n;
+        return n;
+    }
+    
+    // Mapped, shared, compressed or piece table bytes are let go whole rather than copied out
+    // first, unless they are a writable file, which is edited like any buffer.
+    if (n == count && mappedFile < 0 && (mapping || shared || blocks || pieces))
+    {
+        markDirty(0, dirtyToEnd);
+        delete pieces;
+        pieces = nullptr;
+        delete blocks;
+        blocks = nullptr;
+        releaseBytes();
+        bytes = inlineBytes;
+        internalCapacity = inlineCapacity;
+        count = 0;
+        return n;
+    }
+    
+    if (n == 1)
+        removeByteAt(0);
+    else
+        removeBytesIn(range(0, n - 1));
+    return n;
+}
+
+byte * data::appendSpace(size_t n)
+{
+    flatten();
+    detach();
+    
+    if (ring && ringOverwrite && n > maxCapacity - count && n <= maxCapacity)
+        popFront(n - (maxCapacity - count));
+    
+    if (n > maxCapacity - count)
+    {
+        std::cout << "Error: Attempted to make room for bytes when it will exceed the capacity." << std::endl;
+        return nullptr;
+    }
+    
+    makeRoom(count + n);
+    return bytes + count;
+}
+
+void data::commitAppend(size_t n)
+{
+    if (pieces || n > internalCapacity - count)
+    {
+        std::cout << "Fatal error: Attempted to append bytes beyond the room made for them." << std::endl;
+        exit(1);
+    }
+    
+    markDirty(count, count + n);
+    count += n;
+}
+
+/*** Size information ***/
+size_t data::size()
+{
+    return count;
+}
+
+double data::kSize()
+{
+    return static_cast<double>(size()) / 1024.0;
+}
+
+double data::mSize()
+{
+    return static_cast<double>(kSize()) / 1024.0;
+}
+
+double data::gSize()
+{
+    return static_cast<double>(mSize()) / 1024.0;
+}
+
+size_t data::bufferCapacity()
+{
+    return maxCapacity;
+}
+
+size_t data::capacity()
+{
+    return (mapping && mappedFile < 0) || blocks ? count : internalCapacity;
+}
+
+bool data::isMapped()
+{
+    return mapping != nullptr;
+}
+
+std::pmr::memory_resource * data::memoryResource()
+{
+    return resource;
+}
+
+/*** Editing representation ***/
+void data::usePieceTable(bool enable)
+{
+    if (enable && ring)
+        resizeBuffer(internalCapacity);
+    if (enable)
+        closeFile();
+    pieceEditing = enable;
+    if (!enable)
+        flatten();
+}
+
+bool data::isPieceTable()
+{
+    return pieceEditing;
+}
+
+/*** Compressed storage ***/
+void data::compress(compressionLevel level)
+{
+    if (blocks)
+    {
+        blocks->dropCache();
+        return;
+    }
+    if (count <= inlineCapacity)
+        return;
+    
+    DATA_STATS_TIME(compressOp);
+    flatten();
+    closeFile();
+    blocks = new blockStore(bytes, count, level, resource);
+    
+    releaseBytes();
+    bytes = inlineBytes;
+    internalCapacity = inlineCapacity;
+}
+
+void data::decompress()
+{
+    if (blocks == nullptr)
+        return;
+    
+    // The inline buffer is free while the bytes are compressed, so small files land there.
+    DATA_STATS_TIME(decompressOp);
+    byte *tmp = count <= inlineCapacity ? inlineBytes : allocateBytes(count);
+    blocks->copyTo(tmp, 0, count);
+    DATA_STATS_ONLY(stats.recordCopy(count));
+    
+    delete blocks;
+    blocks = nullptr;
+    bytes = tmp;
+    internalCapacity = tmp == inlineBytes ? inlineCapacity : count;
+}
+
+bool data::isCompressed()
+{
+    return blocks != nullptr;
+}
+
+size_t data::compressedSize()
+{
+    return blocks ? blocks->compressedSize() : 0;
+}
+
+/*** Statistics ***/
+dataStats data::statistics()
+{
+#if DATA_STATS
+    return stats;
+#else
+    return dataStats();
+#endif
+}
+
+void data::resetStatistics()
+{
+    DATA_STATS_ONLY(stats.reset());
+}
+
+/** Private Member Functions **/
+
+void data::allocate(size_t needed)
+{
+    size_t n;
+    switch (growth)
+    {
+        case oneAndHalf:
+            n = internalCapacity > SIZE_MAX / 3 * 2 ? SIZE_MAX : internalCapacity + internalCapacity / 2;
+            break;
+        case fixedStep:
+            n = internalCapacity > SIZE_MAX - growthStep ? SIZE_MAX : internalCapacity + growthStep;
+            break;
+        default:
+            n = internalCapacity > SIZE_MAX / 2 ? SIZE_MAX : internalCapacity * 2;
+            break;
+    }
+    
+    n = std::max(n, needed);
+    n = std::min(n, maxCapacity); // Constraints to maxCapacity
+    
+    resizeBuffer(n);
+}
+
+void data::makeRoom(size_t needed)
+{
+    if (needed > internalCapacity)
+        allocate(needed);
+    
+    // Pages of the mapping past the end of the file cannot be touched, so the file grows as the
+    // bytes reach them, a page at a time rather than a syscall per byte.
+    if (mappedFile >= 0 && needed > fileLength)
+    {
+        static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t length = (needed + page - 1) / page * page;
+        if (ftruncate(mappedFile, static_cast<off_t>(length)) != 0)
+            throw std::bad_alloc();
+        fileLength = length;
+    }
+}
+
+void data::detach()
+{
+    decompress();
+    
+    // Once no shared view is left, the shared bytes are simply taken back.
+    if (shared && shared.use_count() == 1)
+    {
+        shared->bytes = nullptr;
+        shared.reset();
+    }
+    
+    // A writable mapping is edited in place.
+    if ((mapping == nullptr || mappedFile >= 0) && !shared)
+        return;
+    
+    size_t n = count > 0 ? count : 1;
+    byte *tmp = buffer(n);
+    std::memcpy(tmp, bytes, count);
+    DATA_STATS_ONLY(stats.recordCopy(count));
+    
+    releaseBytes();
+    bytes = tmp;
+    internalCapacity = tmp == inlineBytes ? inlineCapacity : n;
+}
+
+void data::flatten()
 {
-    return distance;
+    decompress();
+    if (pieces == nullptr)
+        return;
+    
+    size_t n = count;
+    byte *tmp = buffer(n > 0 ? n : 1);
+    pieces->copyTo(tmp, 0, n);
+    DATA_STATS_ONLY(stats.recordCopy(n));
+    
+    delete pieces;
+    pieces = nullptr;
+    
+    releaseBytes();
+    bytes = tmp;
+    internalCapacity = tmp == inlineBytes ? inlineCapacity : (n > 0 ? n : 1);
 }
 
-/** Public Member Functions **/
-
-/*** Constructors & Destructor ***/
-data::data()
+void data::initialize()
 {
-    bytes = new byte;
-    count = -1;
-    maxCapacity = -1;
-    internalCapacity = 1;
+    bytes = inlineBytes;
+    count = 0;
+    maxCapacity = unlimited;
+    internalCapacity = inlineCapacity;
+    growth = doubling;
+    growthStep = 64 * 1024;
     filePath = "";
+    ioThreads = 1;
+    ioDirect = false;
+    mapping = nullptr;
+    mappingLength = 0;
+    mappedFile = -1;
+    fileLength = 0;
+    ring = nullptr;
+    ringLength = 0;
+    ringOverwrite = false;
+    tracking = false;
+    savedLength = 0;
+    dirty.clear();
+    pieceEditing = false;
+    pieces = nullptr;
+    blocks = nullptr;
+    fileFormat = plainFormat;
+    shared.reset();
 }
 
-data::data(std::string fpath)
+void data::steal(data &d)
 {
-    std::ifstream ifile(fpath.c_str(), std::ifstream::binary);
+    count = d.count;
+    maxCapacity = d.maxCapacity;
+    internalCapacity = d.internalCapacity;
+    growth = d.growth;
+    growthStep = d.growthStep;
+    filePath = std::move(d.filePath);
+    resource = d.resource;
+    ioThreads = d.ioThreads;
+    ioDirect = d.ioDirect;
+    mapping = d.mapping;
+    mappingLength = d.mappingLength;
+    mappedFile = d.mappedFile;
+    fileLength = d.fileLength;
+    mappedDevice = d.mappedDevice;
+    mappedInode = d.mappedInode;
+    ring = d.ring;
+    ringLength = d.ringLength;
+    ringOverwrite = d.ringOverwrite;
+    tracking = d.tracking;
+    savedDevice = d.savedDevice;
+    savedInode = d.savedInode;
+    savedLength = d.savedLength;
+    dirty = std::move(d.dirty);
+    pieceEditing = d.pieceEditing;
+    pieces = d.pieces;
+    blocks = d.blocks;
+    fileFormat = d.fileFormat;
+    shared = std::move(d.shared);
     
-    if (ifile)
+    // Compressed bytes leave the inline buffer unused, whatever their count. A piece table over
+    // the inline buffer reads it from here instead, which allocates nothing, as moves must not.
+    if (d.bytes == d.inlineBytes && d.pieces)
     {
-        ifile.seekg(0, ifile.end);
-        int length = ifile.tellg();
-        ifile.seekg(0, ifile.beg);
-        
-        bytes = new byte[length];
-        for(int i = 0; i < length; i++)
-        {
-            int b = ifile.get();
-            if (b < 0)
-                b += 256;
-            bytes[i] = b;
-        }
-        
-        ifile.close();
-        count = length;
+        std::memcpy(inlineBytes, d.inlineBytes, inlineCapacity);
+        pieces->rebase(inlineBytes);
     }
-    else
+    else if (d.bytes == d.inlineBytes && d.blocks == nullptr)
     {
-        std::cout << "Fatal error: Could not read file: " << fpath << std::endl;
-        exit(1);
+        std::memcpy(inlineBytes, d.inlineBytes, count);
+    }
+    else if (d.bytes != d.inlineBytes)
+    {
+        bytes = d.bytes;
     }
     
-    filePath = fpath;
-    maxCapacity = -1;
-    internalCapacity = count + 1;
+    d.initialize();
 }
 
-data::data(byte *b, int n)
+byte * data::buffer(size_t n)
 {
-    bytes = new byte[n];
-    maxCapacity = -1;
-    internalCapacity = n;
-    filePath = "";
-    for(int i = 0; i < n; i++)
-        bytes[i] = b[i];
-    count = n - 1;
+    if (n <= inlineCapacity && bytes != inlineBytes)
+        return inlineBytes;
+    return allocateBytes(n);
 }
 
-data::data(data &d)
+byte * data::allocateBytes(size_t n)
 {
-    count = d.count;
-    maxCapacity = d.maxCapacity;
-    internalCapacity = d.internalCapacity;
-    filePath = d.filePath;
-    bytes = new byte[d.internalCapacity];
-    for(int i = 0; i < count + 1; i++)
-        bytes[i] = d.bytes[i];
+    DATA_STATS_ONLY(stats.recordAllocation(n));
+    return allocateFrom(resource, n);
+}
+
+void data::deallocateBytes(byte *b, size_t n)
+{
+    deallocateFrom(resource, b, n);
 }
 
-data::data(int n)
+void data::resizeBuffer(size_t n)
 {
+    // A writable mapping only reserves address space here, leaving the file as long as it is.
+    // Shrinking leaves the mapping as it is.
+    if (mappedFile >= 0)
+    {
+        if (n > mappingLength)
+        {
+            void *m = mapping ? mremap(const_cast<byte *>(mapping), mappingLength, n, MREMAP_MAYMOVE)
+                              : mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_SHARED, mappedFile, 0);
+            if (m == MAP_FAILED)
+                throw std::bad_alloc();
+            mapping = static_cast<const byte *>(m);
+            mappingLength = n;
+            bytes = static_cast<byte *>(m);
+        }
+        internalCapacity = n;
+        DATA_STATS_ONLY(stats.recordReallocation(n));
+        return;
+    }
     
-    if (n < -1 || n == 0)
+    // Small capacities live in the inline buffer, which needs no copy if already in use.
+    if (bytes == inlineBytes && n <= inlineCapacity)
     {
-        std::cout << "Fatal error: Attempted to set an invalid capacity." << std::endl;
-        exit(1);
+        internalCapacity = n;
+        return;
     }
     
-    maxCapacity = n;
+    if (bytes != inlineBytes && !ring && pageBacked(resource, internalCapacity) && pageBacked(resource, n))
+    {
+        void *m = mremap(bytes, internalCapacity, n, MREMAP_MAYMOVE);
+        if (m == MAP_FAILED)
+            throw std::bad_alloc();
+        bytes = static_cast<byte *>(m);
+        internalCapacity = n;
+        DATA_STATS_ONLY(stats.recordReallocation(n));
+        return;
+    }
+    
+    byte *tmp = buffer(n);
+    std::memcpy(tmp, bytes, count);
+    DATA_STATS_ONLY(stats.recordReallocation(n));
+    DATA_STATS_ONLY(stats.recordCopy(count));
+    releaseBytes();
+    bytes = tmp;
     internalCapacity = n;
-    bytes = new byte[n];
-    count = -1;
-    filePath = "";
 }
 
-//data::data(int nBytes)
-//{
-//    bytes = new byte[n];
-//    count = n - 1;
-//    for (int i = 0; i < n; i++)
-//        bytes[i] = 0;
-//
-//    filePath = "";
-//    maxCapacity = -1;
-//    internalCapacity = n;
-//}
+byte data::storedAt(size_t i)
+{
+    return pieces ? pieces->at(i) : blocks->at(i);
+}
 
-data::~data()
+void data::copyStored(byte *dst, size_t i, size_t n) const
 {
-    if (internalCapacity == 1)
-        delete bytes;
+    if (pieces)
+        pieces->copyTo(dst, i, n);
     else
-        delete [] bytes;
+        blocks->copyTo(dst, i, n);
 }
 
-/*** Representation of buffer of bytes ***/
-std::string data::digest()
+data::pieceTable * data::editTable()
 {
-    std::string d = "";
-    for(int i = 0; i <= count; i++) {
-        d += char(bytes[i]);
+    if (pieces == nullptr)
+    {
+        decompress();
+        pieces = new pieceTable(bytes, count, resource);
     }
-    
-    return d;
+    return pieces;
 }
 
-std::string data::hexDigest()
+void data::markDirty(size_t begin, size_t end)
 {
-    std::stringstream ss;
+    // Appends and sequential edits land on the last extent.
+    if (!dirty.empty() && dirty.back().first <= begin && begin <= dirty.back().second)
+    {
+        dirty.back().second = std::max(dirty.back().second, end);
+        return;
+    }
+    
+    // Extents that overlap or touch [begin, end) are merged into one.
+    auto first = std::lower_bound(dirty.begin(), dirty.end(), begin,
+                                  [](const std::pair<size_t, size_t> &e, size_t b) { return e.second < b; });
+    auto last = first;
+    while (last != dirty.end() && last->first <= end)
+        last++;
     
-    for(int i = 0; i <= count; i++)
-        ss << std::hex << std::setfill('0') << std::setw(2) << bytes[i];
+    if (first == last)
+    {
+        dirty.insert(first, std::make_pair(begin, end));
+        return;
+    }
     
-    return ss.str();
+    first->first = std::min(first->first, begin);
+    first->second = std::max((last - 1)->second, end);
+    dirty.erase(first + 1, last);
 }
 
-/*** File manipulation ***/
-void data::save()
+bool data::shifted()
 {
-    if (filePath == "")
+    return !dirty.empty() && dirty.back().second == dirtyToEnd;
+}
+
+bool data::writeExtent(int fd, size_t begin, size_t end)
+{
+    bool stored = pieces || blocks;
+    if (!stored && ioThreads != 1 && end - begin >= 2 * parallelChunk)
+        return writeParallel(fd, begin, end);
+    
+    std::vector<byte> bounce(stored ? std::min(end - begin, bounceSize) : 0);
+    
+    while (begin < end)
     {
-        std::cout << "Error: Attempted to save when file is not loaded." << std::endl;
-        std::cout << "Call \'saveToPath\' and provide a file path instead." << std::endl;
-    } else {
-        std::ofstream ofile(filePath.c_str(), std::ofstream::binary);
-        
-        if(ofile)
+        size_t n = stored ? std::min(end - begin, bounce.size()) : end - begin;
+        const byte *src = bytes + begin;
+        if (stored)
         {
-            std::string str = digest();
-            ofile.write(str.c_str(), str.length());
-            ofile.close();
+            copyStored(bounce.data(), begin, n);
+            src = bounce.data();
         }
-        else
+        
+        size_t written = 0;
+        while (written < n)
         {
-            std::cout << "Failed to save." << std::endl;
+            ssize_t w = pwrite(fd, src + written, n - written, begin + written);
+            if (w < 0 && errno == EINTR)
+                continue;
+            if (w <= 0)
+                return false;
+            written += w;
         }
+        begin += n;
     }
     
+    return true;
 }
 
-void data::saveToPath(std::string fpath)
+bool data::writeChanges(int fd)
 {
-    filePath = fpath;
-    save();
+    for (const std::pair<size_t, size_t> &e : dirty)
+    {
+        size_t end = std::min(e.second, size());
+        if (e.first < end && !writeExtent(fd, e.first, end))
+            return false;
+    }
+    
+    return size() >= savedLength || ftruncate(fd, size()) == 0;
 }
 
-/*** Bytes retrieval ***/
-byte data::operator[](int i)
+bool data::patchFile()
 {
-    if (i < 0) {
-        std::cout << "Fatal error: Attempted to access an index less than 0." << std::endl;
-        exit(1);
-    }
+    if (dirty.empty() && size() == savedLength)
+        return true;
     
-    if (i > count) {
-        std::cout << "Fatal error: Index out of bounds." << std::endl;
-        exit(1);
-    }
+    int fd = open(filePath.c_str(), O_WRONLY);
+    if (fd < 0)
+        return false;
     
-    return bytes[i];
+    bool saved = writeChanges(fd);
+    if (saved)
+        track(fd);
+    
+    return close(fd) == 0 && saved;
 }
 
-byte * data::bytesInRange(data::range &r)
+bool data::rewriteFile()
 {
-    if (r.upperBound() > count){
-        std::cout << "Fatal error: Range out of bounds." << std::endl;
-        exit(1);
-    }
+    int fd = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+        return false;
     
-    byte *buffer = new byte[r.rangeDistance()];
+    bool saved = writeWhole(fd);
+    if (saved)
+        track(fd);
     
-    for(int i = 0; i < r.upperBound(); i++)
-        buffer[i] = bytes[i + r.lowerBound()];
+    return close(fd) == 0 && saved;
+}
+
+bool data::writeWhole(int fd)
+{
+    if (fileFormat == plainFormat)
+        return writeExtent(fd, 0, size());
+    if (blocks)
+        return blocks->writeTo(fd);
     
-    return buffer;
+    flatten();
+    blockStore store(bytes, count, fastCompression, resource);
+    return store.writeTo(fd);
 }
 
-/*** Bytes manipulation ***/
-void data::appendByte(byte b)
+bool data::replaceFile(bool patch, mode_t permissions)
 {
-    if (maxCapacity == -1)
+    std::string temp = filePath + ".XXXXXX";
+    int fd = mkstemp(&temp[0]);
+    if (fd < 0)
+        return false;
+    
+    // A reflink shares every untouched extent with the target, leaving only the dirty ones to write.
+    bool cloned = false;
+#ifdef FICLONE
+    if (patch)
     {
-        if (count == internalCapacity - 1)
-            allocate();
-        bytes[++count] = b;
-        
+        int source = open(filePath.c_str(), O_RDONLY);
+        if (source >= 0)
+        {
+            cloned = ioctl(fd, FICLONE, source) == 0;
+            close(source);
+        }
     }
-    else if (count == maxCapacity - 1)
+#endif
+
+    bool saved = cloned ? writeChanges(fd) : writeWhole(fd);
+    saved = saved && fchmod(fd, permissions) == 0 && fsync(fd) == 0;
+    saved = saved && rename(temp.c_str(), filePath.c_str()) == 0;
+    if (saved)
+        track(fd);
+    
+    saved = close(fd) == 0 && saved;
+    if (!saved)
     {
-        std::cout << "Error: Attempted to append a byte when the buffer has no more capacity." << std::endl;
+        unlink(temp.c_str());
+        return false;
     }
-    else
+    
+    // The rename itself only lasts once the directory is synced.
+    size_t slash = filePath.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : filePath.substr(0, slash > 0 ? slash : 1);
+    int dirFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd >= 0)
     {
-        if (count == internalCapacity - 1)
-            allocate();
-        bytes[++count] = b;
+        fsync(dirFd);
+        close(dirFd);
     }
     
+    return true;
 }
 
-void data::prependByte(byte b)
+void data::track(int fd)
 {
-    if (maxCapacity == -1)
+    // A compressed file does not hold the bytes at their offsets, so it is never patched.
+    struct stat st;
+    if (fileFormat == compressedFormat || fstat(fd, &st) != 0)
     {
-        if (count == internalCapacity - 1)
-            allocate();
-        
-        byte *tmp = new byte[internalCapacity];
-        tmp[0] = b;
-        for(int i = 0; i <= count; i++)
-            tmp[i + 1] = bytes[i];
-        count++;
-        delete [] bytes;
-        bytes = tmp;
-        
+        tracking = false;
+        return;
     }
-    else if (count == maxCapacity - 1)
+    
+    tracking = true;
+    savedDevice = st.st_dev;
+    savedInode = st.st_ino;
+    savedLength = size();
+    dirty.clear();
+}
+
+bool data::syncFile()
+{
+    // msync works on whole pages, so every dirty extent starts at the beginning of its page.
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    bool synced = true;
+    for (const std::pair<size_t, size_t> &e : dirty)
     {
-        std::cout << "Error: Attempted to append a byte when the buffer has no more capacity." << std::endl;
+        size_t begin = e.first / page * page;
+        size_t end = std::min(e.second, count);
+        if (end > begin && msync(const_cast<byte *>(mapping) + begin, end - begin, MS_SYNC) != 0)
+            synced = false;
     }
-    else
+    
+    if (fileLength > count)
     {
-        if (count == internalCapacity - 1)
-            allocate();
-        
-        byte *tmp = new byte[internalCapacity];
-        tmp[0] = b;
-        for(int i = 0; i <= count; i++)
-            tmp[i + 1] = bytes[i];
-        count++;
-        delete [] bytes;
-        for(int i = 0; i < count + 1; i++)
-            bytes[i] = tmp[i];
+        if (ftruncate(mappedFile, static_cast<off_t>(count)) != 0 || fsync(mappedFile) != 0)
+            synced = false;
+        else
+            fileLength = count;
     }
     
+    if (synced)
+        track(mappedFile);
+    return synced;
 }
 
-void data::insertBytes(byte *b, int n, int i)
+void data::closeFile()
 {
-    if (i < 0) {
-        std::cout << "Fatal error: Attempted to insert at an index less than 0." << std::endl;
-        exit(1);
-    }
+    if (mappedFile < 0)
+        return;
     
-    if (i > count + 1) {
-        std::cout << "Fatal error: Index out of bounds." << std::endl;
-        exit(1);
-    }
+    size_t n = count > 0 ? count : 1;
+    byte *tmp = buffer(n);
+    std::memcpy(tmp, bytes, count);
+    DATA_STATS_ONLY(stats.recordCopy(count));
     
-    if (maxCapacity == -1)
-    {
-        while (count + n > internalCapacity - 1)
-            allocate();
-        
-        byte *tmp = new byte[internalCapacity];
-        
-        for(int j = 0; j < i; j++)
-            tmp[j] = bytes[j];
-        
-        for (int j = 0; j < n; j++)
-            tmp[j + i] = b[j];
-        
-        for(int j = i; j <= count; j++)
-            tmp[j + n] = bytes[j];
-        
-        delete [] bytes;
-        bytes = tmp;
-        count += n;
-    }
-    else if (count == maxCapacity - 1)
-    {
-        std::cout << "Error: Attempted to insert a buffer of bytes when there is no more capacity." << std::endl;
-    }
-    else if (count + n == maxCapacity)
-    {
-        std::cout << "Error: Attempted to insert a buffer of bytes when it will exceed the capacity." << std::endl;
-    }
-    else
+    releaseBytes();
+    bytes = tmp;
+    internalCapacity = tmp == inlineBytes ? inlineCapacity : n;
+}
+
+bool data::remapFile()
+{
+    // The new file is mapped before the old mapping goes, so a failure still has the bytes.
+    struct stat st;
+    int fd = open(filePath.c_str(), O_RDWR);
+    void *m = fd >= 0 && fstat(fd, &st) == 0 ? nullptr : MAP_FAILED;
+    if (m == nullptr && count > 0)
+        m = mmap(nullptr, count, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED)
     {
-        while (count + n > internalCapacity - 1)
-            allocate();
-        byte *tmp = new byte[internalCapacity];
-        
-        for(int j = 0; j < i; j++)
-            tmp[j] = bytes[j];
-        
-        for (int j = 0; j < n; j++)
-            tmp[j + i] = b[j];
-        
-        for(int j = i; j <= count; j++)
-            tmp[j + n] = bytes[j];
-        
-        delete [] bytes;
-        bytes = tmp;
-        count += n;
+        if (fd >= 0)
+            close(fd);
+        closeFile();
+        return false;
     }
+    
+    releaseBytes();
+    mapping = static_cast<const byte *>(m);
+    mappingLength = count;
+    mappedFile = fd;
+    fileLength = count;
+    mappedDevice = st.st_dev;
+    mappedInode = st.st_ino;
+    holdMapping(mappedDevice, mappedInode);
+    bytes = m != nullptr ? static_cast<byte *>(m) : inlineBytes;
+    internalCapacity = count;
+    return true;
 }
 
-void data::overrideBytes(byte *b, int n, range &r)
+void data::readDescriptor(int fd, size_t hint)
 {
-    if (r.upperBound() > count) {
-        std::cout << "Fatal error: Range out of bounds." << std::endl;
-        exit(1);
-    }
+    // One spare byte lets the final zero-length read land without growing the buffer.
+    resizeBuffer(hint > 0 ? hint + 1 : 64 * 1024);
     
-    if (maxCapacity == -1)
+    for (;;)
     {
-        while (count + n > internalCapacity - 1)
-            allocate();
-        
-        byte *tmp = new byte[internalCapacity];
+        if (count == internalCapacity)
+            resizeBuffer(internalCapacity * 2);
         
-        int i;
-        for (i = 0; i < r.lowerBound(); i++)
-            tmp[i] = bytes[i];
-        
-        for (int j = 0; j < n; j++)
-            tmp[j + r.lowerBound()] = b[j];
-        
-        for(int j = r.upperBound() + 1; j <= count; j++)
+        ssize_t r = read(fd, bytes + count, internalCapacity - count);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0)
         {
-            tmp[i + n] = bytes[j];
-            i++;
+            std::cout << "Fatal error: Could not read file: " << filePath << std::endl;
+            exit(1);
         }
-        
-        delete [] bytes;
-        bytes = tmp;
-        count += n - r.rangeDistance() - 1;
+        if (r == 0)
+            break;
+        count += r;
     }
-    else if (count == maxCapacity - 1)
+}
+
+void data::releaseBytes()
+{
+    if (ring)
     {
-        std::cout << "Error: Attempted to insert a buffer of bytes when there is no more capacity." << std::endl;
+        unmapMirrored(ring, ringLength);
+        ring = nullptr;
+        ringLength = 0;
+        ringOverwrite = false;
     }
-    else if (count + n - r.rangeDistance() - 1 == maxCapacity - 1)
+    else if (shared)
     {
-        std::cout << "Error: Attempted to insert a buffer of bytes when it will exceed the capacity." << std::endl;
+        shared.reset();
+        mapping = nullptr;
+        mappingLength = 0;
     }
-    else
+    else if (mapping || mappedFile >= 0)
     {
-        while (count + n > internalCapacity - 1)
-            allocate();
-        
-        byte *tmp = new byte[internalCapacity];
-        
-        int i;
-        for (i = 0; i < r.lowerBound(); i++)
-            tmp[i] = bytes[i];
-        
-        for (int j = 0; j < n; j++)
-            tmp[j + r.lowerBound()] = b[j];
-        
-        for(int j = r.upperBound() + 1; j <= count; j++)
-        {
-            tmp[i + n] = bytes[j];
-            i++;
-        }
-        
-        delete [] bytes;
-        bytes = tmp;
-        count += n - r.rangeDistance() - 1;
+        unmap();
     }
-}
-
-void data::removeByteAt(int i)
-{
-    if (i > count)
+    else if (bytes != inlineBytes)
     {
-        std::cout << "Fatal error: Attempted to remove a byte out of bounds." << std::endl;
-        exit(1);
+        deallocateBytes(bytes, internalCapacity);
     }
     
-    byte *tmp = new byte[internalCapacity];
-    for (int j = 0; j < i; j++)
-        tmp[j] = bytes[j];
-    
-    for (int j = i + 1; j <= count; j++)
-        tmp[j - 1] = bytes[j];
-    
-    delete [] bytes;
-    bytes = tmp;
-    count--;
+    bytes = nullptr;
 }
 
-void data::removeBytesIn(data::range r)
+void data::share()
 {
-    if (r.upperBound() > count)
-    {
-        std::cout << "Fatal error: Attempted to remove bytes out of bounds." << std::endl;
-        exit(1);
-    }
+    if (shared)
+        return;
     
-    byte *tmp = new byte[internalCapacity];
-    for (int i = 0; i < r.lowerBound(); i++)
-        tmp[i] = bytes[i];
-    
-    for (int i = r.upperBound() + 1; i <= count; i++)
-        tmp[i - r.rangeDistance()] = bytes[i];
-    
-    delete [] bytes;
-    bytes = tmp;
-    count -= r.rangeDistance() + 1;
-}
-
-void data::setCapacity(int n)
-{
+    // Views cannot keep a ring alive, so its bytes move into an ordinary buffer first.
+    if (ring)
+        resizeBuffer(internalCapacity);
     
-    if (n < -1 || n == 0)
-    {
-        std::cout << "Fatal error: Attempted to set an invalid capacity." << std::endl;
-        exit(1);
-    }
+    // Views of a writable mapping would see it change and move, so they get owned bytes too.
+    closeFile();
     
-    if (n == -1)
-    {
-        maxCapacity = -1;
-    }
-    else
+    // The inline buffer dies with this object, so it is moved to the heap before sharing.
+    if (bytes == inlineBytes)
     {
-        byte *tmp = new byte[n];
-        if (n - 1 < count)
-        {
-            for (int i = 0; i < n; i++)
-                tmp[i] = bytes[i];
-            count = n - 1;
-        }
-        else
-        {
-            for (int i = 0; i <= count; i++)
-                tmp[i] = bytes[i];
-        }
-        
-        delete [] bytes;
+        byte *tmp = allocateBytes(internalCapacity);
+        std::memcpy(tmp, inlineBytes, count);
+        DATA_STATS_ONLY(stats.recordCopy(count));
         bytes = tmp;
-        maxCapacity = n;
-        internalCapacity = n;
     }
     
+    shared = std::make_shared<sharedView::block>();
+    shared->bytes = mapping ? const_cast<byte *>(mapping) : bytes;
+    shared->length = mapping ? mappingLength : internalCapacity;
+    shared->mapped = mapping != nullptr;
+    shared->device = mappedDevice;
+    shared->inode = mappedInode;
+    shared->resource = resource;
 }
 
-/*** Size information ***/
-unsigned int data::size()
-{
-    return count + 1;
-}
-
-double data::kSize()
-{
-    return static_cast<double>(size()) / 1024.0;
-}
-
-double data::mSize()
-{
-    return static_cast<double>(kSize()) / 1024.0;
-}
-
-double data::gSize()
-{
-    return static_cast<double>(mSize()) / 1024.0;
-}
-
-int data::bufferCapacity()
-{
-    return maxCapacity;
-}
-
-/** Private Member Functions **/
-
-void data::allocate()
+void data::unmap()
 {
+    if (mappedFile < 0 && mapping == nullptr)
+        return;
     
-    int n = internalCapacity * 2;
-    
-    if (maxCapacity != -1)
-        n = std::max(maxCapacity, n); // Constraints to maxCapacity
+    // The file behind a writable mapping keeps the bytes, without the room grown past them,
+    // unless cutting it would pull pages out from under another mapping of it.
+    if (mappedFile >= 0)
+    {
+        if (mappingsOf(mappedDevice, mappedInode) == 1 && ftruncate(mappedFile, static_cast<off_t>(count)) == 0)
+            savedLength = count;
+        close(mappedFile);
+        mappedFile = -1;
+    }
     
-    byte *tmp = new byte[n];
-    for (int i = 0; i < count + 1; i++)
-        tmp[i] = bytes[i];
-    delete [] bytes;
-    bytes = tmp;
-    internalCapacity = n;
+    if (mapping)
+        munmap(const_cast<byte *>(mapping), mappingLength);
+    mapping = nullptr;
+    mappingLength = 0;
+    releaseMapping(mappedDevice, mappedInode);
 }
 
 
@@ -533,13 +2054,15 @@ void data::allocate()
 
 std::istream & operator>>(std::istream &in, data &d)
 {
-    std::string s;
-    in >> s;
+    // Only the bytes go, so a ring stays a ring and the limits and policies still apply.
+    d.popFront(d.size());
+    if (d.readFrom(in) == 0)
+        in.setstate(std::ios::failbit);
     return in;
 }
 
 std::ostream& operator<<(std::ostream &out, data &d)
 {
-    out << "<" << d.bytes << "> " << d.size() << " bytes";
+    out << "<" << d.size() << " bytes>";
     return out;
 }
@@ -2,64 +2,316 @@
 #define DATA_H
 #include <iostream>
 #include <string>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+#include "stats.h"
+#if __cplusplus >= 202002L
+#include <span>
+#define DATA_HAS_SPAN 1
+#else
+#define DATA_HAS_SPAN 0
+#endif
 
 /** Type Definitions **/
-typedef unsigned short byte;
+typedef uint8_t byte;
+
+class concurrentData;
 
 /** data Object declaration **/
 
 class data {
     
     friend std::istream& operator>>(std::istream &in, data &d);
-    // Precondition: A file must exist in the specified path.
-    // Postcondition: Loads the content of a specified filePath.
+    // Postcondition: Replaces the bytes of d with the rest of the stream, read as in readFrom, so
+    //                that its capacity limit, growth policy, resource and ring buffer still apply.
+    //                Sets failbit if there was nothing left to read.
     
     friend std::ostream& operator<<(std::ostream &out, data &d);
-    // Postcontidition: Displays the amount of bytes in the data object.
-    
+    // Postcontidition: Displays the amount of bytes in the data object. See hexDump for the bytes.
+
 public:
+
+    enum loadMode {
+        automatic,  // Maps large regular files, reads everything else.
+        mapped,     // Maps the file read-only whenever the OS allows it.
+        buffered,   // Always reads the file into an owned buffer.
+        writable,       // Maps the file read-write and shared, so that edits go straight to the file.
+        parallel,       // Reads the file in chunks on every core, with pread.
+        parallelDirect, // Same as parallel, bypassing the page cache with O_DIRECT where allowed.
+        compressedFile  // Reads a file saved in compressedFormat, keeping the bytes compressed.
+    };
+    
+    enum growthPolicy {
+        doubling,       // Doubles the capacity (the default).
+        oneAndHalf,     // Grows the capacity by half, wasting less memory.
+        fixedStep       // Grows the capacity by a fixed amount of bytes.
+    };
+    
+    enum deltaMode {
+        blockMatching,  // Matches whole blocks of the base through a rolling hash, like rsync.
+        suffixMatching  // Finds the longest match at every byte through a suffix array, like bsdiff.
+    };
+    
+    enum compressionLevel {
+        fastCompression,    // Takes the first match a hash table finds, at the speed of LZ4.
+        highCompression     // Searches chains of earlier matches for the longest, for smaller blocks.
+    };
+    
+    enum saveMode {
+        inPlace,        // Writes into the existing file, patching only what changed when possible.
+        atomicReplace   // Writes a temporary file, syncs it and renames it over the target.
+    };
+    
+    enum saveFormat {
+        plainFormat,        // The bytes as they are.
+        compressedFormat    // The bytes compressed block by block, read back with compressedFile.
+    };
+    
+    static constexpr size_t unlimited = SIZE_MAX;   // The capacity of a buffer without a maximum.
+    static constexpr size_t parallelChunk = 4 * 1024 * 1024;   // The unit of parallel reads and writes.
+    static constexpr size_t streamChunk = 256 * 1024;          // The unit of readFrom.
+    static constexpr size_t compressedBlock = 64 * 1024;       // The unit of compressed storage.
+    static constexpr size_t cachedBlocks = 8;                  // Decompressed blocks kept by a compressed object.
+    
+    // Called by loadMany with the index of a path, its bytes and whether it could be read.
+    typedef std::function<void(size_t index, data &d, bool loaded)> loadCallback;
+    static constexpr size_t notFound = SIZE_MAX;    // Returned by the searches when nothing matches.
     
     class range {
     public:
-        range(int l, int u);
+        range(size_t l, size_t u);
         // Postcondition: lower bound must be less than upper bound.
         
-        int lowerBound();
+        size_t lowerBound();
         // Postcondition: Returns the lower bound of the range.
         
-        int upperBound();
+        size_t upperBound();
         // Postcondition: Returns the upper bound of the range.
         
-        int rangeDistance();
+        size_t rangeDistance();
         // Postcondition: Returns the distance between the lower and upper bound.
+    
+    private:
+        size_t lower;       // Lower bound.
+        size_t upper;       // Upper bound.
+        size_t distance;    // Distance between the lower and upper bound.
+    };
+    
+    class view {
+    public:
+        view();
+        // Postcondition: Creates an empty view.
+        
+        view(const byte *b, size_t n);
+        // Postcondition: Views the n bytes starting at b without copying them.
+        
+        size_t size() const;
+        // Postcondition: Returns the amount of bytes in the view.
         
+        bool empty() const;
+        // Postcondition: Returns true if the view has no bytes.
+        
+        const byte *begin() const;
+        // Postcondition: Returns a pointer to the first byte.
+        
+        const byte *end() const;
+        // Postcondition: Returns a pointer one past the last byte.
+        
+        byte operator[](size_t i) const;
+        // Precondition: i must be less than size(). It is not checked.
+        // Postcondition: Returns the byte in the specified index.
+        
+        view slice(size_t i, size_t n) const;
+        // Precondition: i + n must not exceed size().
+        // Postcondition: Returns a view of the n bytes starting at i.
+        
+        size_t find(view needle, size_t from = 0) const;
+        // Postcondition: Returns the index of the first occurrence of needle starting at or after
+        //                from, or notFound.
+        
+        size_t rfind(view needle, size_t before = notFound) const;
+        // Postcondition: Returns the index of the last occurrence of needle starting at or before
+        //                before, or notFound.
+        
+        std::string digest() const;
+        // Postcondition: Returns a string of the viewed bytes.
+        
+        bool operator==(const view &v) const;
+        bool operator!=(const view &v) const;
+        bool operator<(const view &v) const;
+        // Postcondition: Compares the viewed bytes lexicographically.
+    
     private:
-        int lower;      // Lower bound.
-        int upper;      // Upper bound.
-        int distance;   // Distance between the lower and upper bound.
+        const byte *first;  // The first viewed byte.
+        size_t length;      // The amount of viewed bytes.
+    };
+    
+    class sharedView {
+    public:
+        sharedView();
+        // Postcondition: Creates an empty shared view.
+        
+        size_t size() const;
+        // Postcondition: Returns the amount of bytes in the view.
+        
+        bool empty() const;
+        // Postcondition: Returns true if the view has no bytes.
+        
+        const byte *begin() const;
+        // Postcondition: Returns a pointer to the first byte.
+        
+        const byte *end() const;
+        // Postcondition: Returns a pointer one past the last byte.
+        
+        byte operator[](size_t i) const;
+        // Precondition: i must be less than size(). It is not checked.
+        // Postcondition: Returns the byte in the specified index.
+        
+        sharedView slice(size_t i, size_t n) const;
+        // Precondition: i + n must not exceed size().
+        // Postcondition: Returns a shared view of the n bytes starting at i.
+        
+        view asView() const;
+        // Postcondition: Returns a plain view of the bytes, valid while this shared view lives.
+        
+        std::string digest() const;
+        // Postcondition: Returns a string of the viewed bytes.
+        
+        bool operator==(const sharedView &v) const;
+        bool operator!=(const sharedView &v) const;
+        bool operator<(const sharedView &v) const;
+        // Postcondition: Compares the viewed bytes lexicographically.
+    
+    private:
+        friend class data;
+        struct block;
+        
+        std::shared_ptr<block> owner;   // Keeps the viewed storage alive.
+        view bytes;                     // The viewed bytes.
+    };
+    
+    class editBatch {
+    public:
+        editBatch();
+        // Postcondition: Creates an empty batch. Every offset given to a batch refers to the bytes
+        //                as they are before the batch is applied, whatever the other edits do.
+        
+        void insertBytes(const byte *b, size_t n, size_t i);
+        // Postcondition: Records inserting n bytes before the byte at i (or at the end if i is the
+        //                size). Inserts at the same offset keep the order they were recorded in.
+        
+        void overrideBytes(const byte *b, size_t n, range r);
+        // Postcondition: Records replacing the bytes in the range (including both bounds) with n bytes.
+        
+        void overrideBytes(const byte *b, size_t n, size_t i);
+        // Postcondition: Records overwriting the n bytes starting at i.
+        
+        void removeBytesIn(range r);
+        // Postcondition: Records removing the bytes in the range (including both bounds).
+        
+        void removeByteAt(size_t i);
+        // Postcondition: Records removing the byte at i.
+        
+        size_t size() const;
+        // Postcondition: Returns the amount of recorded edits.
+        
+        bool empty() const;
+        // Postcondition: Returns true if no edit was recorded.
+        
+        void clear();
+        // Postcondition: Forgets every recorded edit.
+    
+    private:
+        friend class data;
+        friend class concurrentData;
+        
+        struct edit {
+            size_t begin;       // The first replaced byte.
+            size_t end;         // One past the last replaced byte; begin for inserts.
+            size_t offset;      // Where the new bytes start in added.
+            size_t length;      // The amount of new bytes.
+        };
+        
+        void record(const byte *b, size_t n, size_t begin, size_t end);
+        // Postcondition: Records replacing the bytes in [begin, end) with the n bytes of b.
+        
+        bool sorted(size_t n, std::vector<edit> &ordered);
+        // Precondition: Every edit must be within the first n bytes.
+        // Postcondition: Copies the edits into ordered by where they start, inserts first at the same
+        //                offset and in the order they were recorded otherwise. Returns false (and
+        //                prints an error) if edits overlap.
+        
+        std::vector<edit> edits;    // Every edit, in the order it was recorded.
+        std::vector<byte> added;    // The new bytes of every edit.
     };
     
     /*** Constructors & Destructors ***/
     data();
     // Postcondition: Creates an empty data object.
     
-    data(std::string fpath);
+    explicit data(std::pmr::memory_resource *resource);
+    // Postcondition: Creates an empty data object whose buffers come from resource. Every constructor
+    //                but the copy constructor takes one; it defaults to std::pmr::get_default_resource().
+    
+    data(std::string fpath, loadMode mode = automatic, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
     // Precondition: A file must exist in the specified path.
-    // Postcondition: Loaded the content of the file in the specified path.
+    // Postcondition: Loaded the content of the file in the specified path. Regular files may be mapped
+    //                read-only instead of copied; the first mutation copies them into owned storage.
+    //                In writable mode a regular file stays mapped and edits change its pages in the
+    //                page cache: same-size overrides (and writes through mutableBytes) cost only the
+    //                pages they touch, and batches of edits are applied in place. Edits that grow the
+    //                bytes extend the file to the page holding the last one, while the capacity only
+    //                reserves address space for the mapping to grow into (reserve makes no file
+    //                longer). save() flushes the pages changed since the last save and cuts the
+    //                file down to the bytes; saving to another file, or with atomicReplace, writes
+    //                that file whole and moves the mapping onto it. Piece tables, shared views and
+    //                ring buffers copy the bytes into owned storage first, leaving the file as it
+    //                was edited so far. Other files are read as in buffered mode.
+    
+    data(const byte *b, size_t n, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    // Postcondition: Loads the buffer of passed bytes.
     
-    data(byte *b, int n);
+    data(const std::byte *b, size_t n, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
     // Postcondition: Loads the buffer of passed bytes.
+
+#if DATA_HAS_SPAN
+    data(std::span<const byte> s, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    // Postcondition: Loads the bytes viewed by s.
+#endif
+
+    data(const data &d);
+    // Postcondition: Copies the content of the data object "d" into buffers from the default resource.
+    //                The copy's first save writes the whole file.
     
-    data(data &d);
-    // Postcondition: Copies the content of the data object "d".
+    data(const data &d, std::pmr::memory_resource *resource);
+    // Postcondition: Copies the content of the data object "d" into buffers from resource.
     
-    data(int n);
-    // Precondition: Must be > 0 or == -1.
-    // Postcondition: Sets maximum capacity to n, or no limitations if n = -1.
+    data(data &&d) noexcept;
+    // Postcondition: Takes over the content and the resource of the data object "d", leaving it empty.
+    
+    data(size_t n, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    // Precondition: Must be > 0.
+    // Postcondition: Sets maximum capacity to n, or no limitations if n = unlimited (or -1).
     
     ~data();
     // Postcondition: Destroys the buffer of bytes and prevents memory leaks.
     
+    data & operator=(const data &d);
+    // Postcondition: Replaces the content with a copy of the data object "d", keeping the resource.
+    
+    data & operator=(data &&d) noexcept;
+    // Postcondition: Replaces the content and the resource with those of "d", leaving it empty.
+    
+    void swap(data &d) noexcept;
+    // Postcondition: Exchanges the content and the resources of both data objects.
+    
     /*** Representation of buffer of bytes ***/
     std::string digest();
     // Postcontidition: Returns a string of bytes.
@@ -67,23 +319,180 @@ public:
     std::string hexDigest();
     // Postcontidition: Returns a string of bytes in hex format.
     
+    std::string base64Digest();
+    // Postcontidition: Returns a string of bytes in base64 format.
+    
+    void hexDump(std::ostream &out);
+    // Postcondition: Writes the bytes to out in the format of xxd, as hexDump(out, viewAll()).
+    
+    /*** Encoding ***/
+    static constexpr size_t encodingError = SIZE_MAX;  // Returned by the decoders for invalid text.
+    
+    static size_t hexEncode(const byte *src, size_t n, char *dst);
+    // Precondition: dst must have room for 2 * n characters.
+    // Postcondition: Writes n bytes as lowercase hex into dst and returns the amount of characters.
+    
+    static size_t hexDecode(const char *src, size_t n, byte *dst);
+    // Precondition: dst must have room for n / 2 bytes.
+    // Postcondition: Decodes n hex characters (either case) into dst and returns the amount of
+    //                bytes, or encodingError if the text is not valid hex.
+    
+    static size_t base64Length(size_t n);
+    // Postcondition: Returns the amount of characters (with padding) that n bytes encode to.
+    
+    static size_t base64Encode(const byte *src, size_t n, char *dst);
+    // Precondition: dst must have room for base64Length(n) characters.
+    // Postcondition: Writes n bytes as padded base64 into dst and returns the amount of characters.
+    
+    static size_t base64Decode(const char *src, size_t n, byte *dst);
+    // Precondition: dst must have room for n / 4 * 3 bytes.
+    // Postcondition: Decodes n padded base64 characters into dst and returns the amount of bytes,
+    //                or encodingError if the text is not valid base64.
+    
+    static data fromHex(const std::string &text);
+    // Postcondition: Returns a data object with the bytes encoded in text, or an empty one (and
+    //                prints an error) if the text is not valid hex.
+    
+    static data fromBase64(const std::string &text);
+    // Postcondition: Same as above for base64 text.
+    
+    static void hexDump(std::ostream &out, view v, size_t offset = 0);
+    // Postcondition: Writes the bytes of v to out in the format of xxd: lines of 16 bytes, each
+    //                with the offset of its first byte (counting from offset), the bytes in hex
+    //                pairs and as text, with a dot for every byte that is not printable ASCII.
+    //                Lines are formatted through tables into a block that is written at once.
+    
+    /*** Hashing ***/
+    uint32_t crc32c();
+    // Postcondition: Returns the CRC-32C checksum of the bytes.
+    
+    uint64_t xxh64();
+    // Postcondition: Returns the XXH64 hash of the bytes.
+    
+    uint64_t xxh3();
+    // Postcondition: Returns the 64 bit XXH3 hash of the bytes.
+    
+    std::string sha256();
+    // Postcondition: Returns the SHA-256 hash of the bytes in hex format.
+    
+    /*** Searching ***/
+    size_t find(const byte *needle, size_t n, size_t from = 0);
+    // Postcondition: Returns the index of the first occurrence of the n bytes of needle starting at
+    //                or after from, or notFound. An empty needle matches at from. Pending piece
+    //                table edits are flattened first, as for every search.
+    
+    size_t rfind(const byte *needle, size_t n, size_t before = notFound);
+    // Postcondition: Returns the index of the last occurrence of the n bytes of needle starting at
+    //                or before before, or notFound.
+    
+    std::vector<size_t> findAll(const byte *needle, size_t n);
+    // Precondition: n must be greater than 0.
+    // Postcondition: Returns the indices of every occurrence of needle, overlapping ones included.
+    
+    size_t countOf(const byte *needle, size_t n);
+    // Precondition: n must be greater than 0.
+    // Postcondition: Returns the amount of occurrences of needle, overlapping ones included.
+    
+    /*** Deltas ***/
+    static data diff(data &base, data &target, deltaMode mode = blockMatching, unsigned threads = 0);
+    // Postcondition: Returns a delta that rebuilds target from base: copies from base and the bytes
+    //                of target found nowhere in base, with both lengths and hashes. The target is
+    //                scanned in segments on up to threads threads (all cores if 0). suffixMatching
+    //                finds shorter and unaligned matches, making smaller deltas, but is slower and
+    //                takes about 4 bytes of memory per byte of base; bases of 4 GB and more use
+    //                blockMatching.
+    
+    static data applyDelta(data &base, data &delta);
+    // Postcondition: Returns the target the delta was made for, built in a single buffer sized by
+    //                its checked instructions, or an empty data object (and prints an error) if the
+    //                delta is invalid or was made for another base.
+    
+    static bool applyDelta(data &base, data &delta, std::ostream &out);
+    // Postcondition: Writes the target into out as the delta is read, without holding it in
+    //                memory. Returns false (and prints an error) under the same conditions, in
+    //                which case part of the target may have been written already.
+    
     /*** File manipulation ***/
-    void save();
+    void save(saveMode mode = inPlace);
     // Precondition: Must have been loaded from a file.
-    // Postcondition: Overrides the currently loaded file with the new bytes.
+    // Postcondition: Overrides the currently loaded file with the new bytes. If the file is the one
+    //                loaded or last saved, and its length is unchanged, only the extents modified
+    //                since then are written (from the first shifted byte on after an insertion or
+    //                removal) and the file is truncated or extended to fit. Anything else rewrites
+    //                the whole file. While another mapping of the file is alive anywhere in the
+    //                process (another object's, or views shared from one), the file is replaced as
+    //                with atomicReplace instead, so those keep the bytes they saw. Files loaded as
+    //                compressedFile, or last saved in compressedFormat, are rewritten whole in that
+    //                format.
     
-    void saveToPath(std::string fpath);
+    void saveToPath(std::string fpath, saveMode mode = inPlace, saveFormat format = plainFormat);
     // Precondition: A valid filePath must be passed.
     // Postcondition: Creates a new file in the specified path and saves it with the content of the data obj.
+    //                In compressedFormat, the blocks of compressed bytes are written as they are, and
+    //                other bytes are compressed for it with fastCompression.
     
     /*** Bytes retrieval ***/
-    byte operator[](int i);
+    byte operator[](size_t i);
     // Precondition: The passed index must be <= than the buffer of bytes in the object.
+    // Postcondition: Returns the byte in the specified index. An index out of bounds is fatal.
+    
+    bool at(size_t i, byte &b);
+    // Postcondition: Sets b to the byte in the specified index and returns true, or returns false
+    //                (and prints an error) if the index is out of bounds.
+    
+    byte atUnchecked(size_t i);
+    // Precondition: i must be less than size(). It is not checked.
     // Postcondition: Returns the byte in the specified index.
     
+    const byte *begin();
+    // Postcondition: Returns a pointer to the first byte, which with end() makes a contiguous range
+    //                for range-based for loops and the standard algorithms. Pending piece table
+    //                edits are flattened first. The pointer is invalidated by the next mutation.
+    
+    const byte *end();
+    // Postcondition: Returns a pointer one past the last byte, with the same validity as begin().
+    
+    const byte *rawBytes();
+    // Postcondition: Same as begin().
+    
+    byte *mutableBytes();
+    // Postcondition: Returns a pointer to the first byte that may be written through, after making
+    //                the bytes owned (copying them out of a mapped file or shared buffer). The whole
+    //                buffer is considered modified for the next save. Pointers taken before are
+    //                invalidated, so it must be called before begin() when reading and writing the
+    //                same object.
+
+#if DATA_HAS_SPAN
+    std::span<const byte> asSpan();
+    // Postcondition: Returns a span of every byte, with the same validity as begin().
+    
+    std::span<const std::byte> asByteSpan();
+    // Postcondition: Same as above as std::byte.
+#endif
+
     byte *bytesInRange(range &r);
     // Precondition: The range must be between 0 and buffer of bytes - 1.
-    // Postcondition: Returns a buffer of bytes in the specified range.
+    // Postcondition: Returns a copy of the bytes in the specified range (including both bounds),
+    //                which the caller must delete [].
+    
+    view viewAll();
+    // Postcondition: Returns a view of every byte without copying. Pending piece table edits are
+    //                flattened first. The view is invalidated by the next mutation.
+    
+    view viewInRange(range &r);
+    // Precondition: The range must be between 0 and buffer of bytes - 1.
+    // Postcondition: Returns a view of the bytes in the specified range (including both bounds)
+    //                without copying. The view is invalidated by the next mutation. While the bytes
+    //                are compressed, it is a view of the blocks it spans decompressed, valid until
+    //                the next access to the bytes.
+    
+    sharedView shareAll();
+    // Postcondition: Returns a reference counted view of every byte. It keeps the bytes alive and
+    //                unchanged; the next mutation of this object copies its bytes instead.
+    
+    sharedView shareRange(range &r);
+    // Precondition: The range must be between 0 and buffer of bytes - 1.
+    // Postcondition: Same as above for the bytes in the specified range (including both bounds).
     
     /*** Bytes manipulation ***/
     void appendByte(byte b);
@@ -94,17 +503,33 @@ public:
     // Postcondition: Prepends a given byte to the beginning of the buffer.
     //                And resizes if necessary (and there is no capacity limit).
     
-    void insertBytes(byte *b, int n, int i);
+    void insertBytes(const byte *b, size_t n, size_t i);
     // Precondition: The given index must not be larger than the size of the buffer.
     // Postcondition: Inserts a given buffer of bytes in position i, by pushing existing bytes to the right.
     //                And resizes if necessary (and there is no capacity limit).
     
-    void overrideBytes(byte *b, int n, range &r);
+    void insertBytes(const std::byte *b, size_t n, size_t i);
+    // Postcondition: Same as above for std::byte buffers.
+
+#if DATA_HAS_SPAN
+    void insertBytes(std::span<const byte> s, size_t i);
+    // Postcondition: Same as above for the bytes viewed by s.
+#endif
+
+    void overrideBytes(const byte *b, size_t n, range &r);
     // Precondition: The range must be between 0 and buffer of bytes - 1.
     // Postcondition: Overrides the bytes in the range with the passed bytes.
     //                And resizes if necessary (and there is no capacity limit).
     
-    void removeByteAt(int i);
+    void overrideBytes(const std::byte *b, size_t n, range &r);
+    // Postcondition: Same as above for std::byte buffers.
+
+#if DATA_HAS_SPAN
+    void overrideBytes(std::span<const byte> s, range &r);
+    // Postcondition: Same as above for the bytes viewed by s.
+#endif
+
+    void removeByteAt(size_t i);
     // Precondition: i must be between 0 and the amount of bytes in the buffer
     // Postcondition: Removes the byte located at bytes[i].
     
@@ -112,14 +537,65 @@ public:
     // Precondition: The specified upper bound of the range must be not exceed the amount of bytes in the buffer.
     // Postcondition: Removes the buffer of bytes in the specified range.
     
-    void setCapacity(int n);
-    // Precondition: Capacity must be -1 (for no limit), or greater than 0.
+    bool applyEdits(editBatch &batch);
+    // Precondition: Every edit must be within the bytes.
+    // Postcondition: Applies every edit of the batch at once, with a single new buffer and one
+    //                pass over the bytes (or through the piece table when it is in use). A ring
+    //                buffer is edited in place and stays a ring. Returns false, changing nothing,
+    //                if edits overlap or the result would exceed the capacity, as it does for an
+    //                overwriting ring too. Edits overlap when they replace a common byte, or when
+    //                a byte is inserted strictly inside a replaced range.
+    
+    void setCapacity(size_t n);
+    // Precondition: Capacity must be unlimited (or -1) for no limit, or greater than 0.
     // Postcondition: Sets a maximum capacity or no limits. If capacity is less than the current buffer
     //                the extra bytes lost after resizing. Contents of old buffer is copied into new
     //                buffer of bytes with capacity n.
     
+    void reserve(size_t n);
+    // Postcondition: Grows the buffer to hold at least n bytes (up to the maximum capacity) with a
+    //                single allocation, so that appending up to n bytes does not reallocate. Pending
+    //                piece table edits are flattened first.
+    
+    void shrinkToFit();
+    // Postcondition: Releases the unused capacity of an owned buffer. Rings keep their size.
+    
+    void setGrowthPolicy(growthPolicy policy, size_t step = 64 * 1024);
+    // Precondition: step must be greater than 0 for fixedStep.
+    // Postcondition: Sets how the buffer grows when it runs out of room. Growth never passes the
+    //                maximum capacity. Buffers of 1 MB and more from the new/delete resource grow
+    //                and shrink with mremap instead of being copied.
+    
+    /*** Ring buffer ***/
+    bool useRingBuffer(size_t n, bool overwrite = true);
+    // Precondition: n must be greater than 0.
+    // Postcondition: Turns the buffer into a ring of at least n bytes (rounded up to a multiple of
+    //                mirrorGranularity()), which is also the maximum capacity, keeping the newest
+    //                bytes. Appending to a full ring drops the oldest bytes when overwrite is true,
+    //                and fails like on any full buffer otherwise. The ring is mapped twice in a row,
+    //                so the bytes stay contiguous however they wrap. setCapacity, piece tables and
+    //                shared views turn it back into an ordinary buffer with the same maximum capacity.
+    //                Returns false if the ring cannot be mapped.
+    
+    bool isRingBuffer();
+    // Postcondition: Returns true if the bytes live in a ring.
+    
+    size_t popFront(size_t n);
+    // Postcondition: Removes the first n bytes (or every byte, if there are fewer) and returns how
+    //                many were removed. In a ring this is O(1), as is removing every mapped,
+    //                shared or compressed byte.
+    
+    byte * appendSpace(size_t n);
+    // Postcondition: Returns room for n bytes right after the last one, growing the buffer (or, in
+    //                an overwriting ring, dropping the oldest bytes) as needed, or nullptr if they
+    //                cannot fit the capacity. The room stays valid until the next change.
+    
+    void commitAppend(size_t n);
+    // Precondition: n must not exceed the room last returned by appendSpace.
+    // Postcondition: Appends the first n bytes written into that room.
+    
     /*** Size information ***/
-    unsigned int size();
+    size_t size();
     // Postcondition: Returns the size in bytes of the data obj.
     
     double kSize();
@@ -131,19 +607,327 @@ public:
     double gSize();
     // Postcondition: Returns the size in gigabytes of the data obj.
     
-    int bufferCapacity();
-    // Postcondition: Returns the capacity of the buffer, or -1 if there is no maximum capacity.
+    size_t bufferCapacity();
+    // Postcondition: Returns the capacity of the buffer, or unlimited if there is no maximum capacity.
+    
+    size_t capacity();
+    // Postcondition: Returns the amount of bytes the buffer holds before it has to grow.
+    
+    bool isMapped();
+    // Postcondition: Returns true if the bytes are still served from a file mapping.
+    
+    std::pmr::memory_resource *memoryResource();
+    // Postcondition: Returns the resource the buffers come from.
+    
+    /*** Editing representation ***/
+    void usePieceTable(bool enable);
+    // Postcondition: When enabled, edits are recorded in a piece table over the current (possibly
+    //                mapped) bytes and an append-only add buffer, costing O(log pieces) instead of a
+    //                full copy. The bytes are flattened lazily by digest, hexDigest, save and
+    //                setCapacity, or right away when disabled.
+    
+    bool isPieceTable();
+    // Postcondition: Returns true if edits go through a piece table.
+    
+    /*** Compressed storage ***/
+    void compress(compressionLevel level = fastCompression);
+    // Postcondition: Holds the bytes compressed in blocks of compressedBlock bytes, releasing their
+    //                buffer (and any mapping or ring), for data that is seldom read but must stay
+    //                in memory. operator[], at, atUnchecked, bytesInRange, viewInRange and saves
+    //                decompress only the blocks they touch, keeping the last cachedBlocks of them.
+    //                Edits, and whatever needs every byte contiguous (begin, viewAll, digests,
+    //                hashes, searches, shared views), decompress the whole buffer first. Compressing
+    //                compressed bytes releases their cached blocks. Bytes that fit inline are left
+    //                as they are.
+    
+    void decompress();
+    // Postcondition: Turns compressed bytes back into an ordinary buffer.
+    
+    bool isCompressed();
+    // Postcondition: Returns true if the bytes are compressed.
+    
+    size_t compressedSize();
+    // Postcondition: Returns the memory taken by the compressed blocks, without the cached ones, or
+    //                0 if the bytes are not compressed.
+    
+    /*** Batched loading ***/
+    static void loadMany(const std::vector<std::string> &paths, const loadCallback &done, bool uring = true,
+                         std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    // Postcondition: Loads every file into an owned buffer, as in buffered mode, and calls done
+    //                once per path as soon as it is loaded, with the data object to move from.
+    //                Files that cannot be read are reported as errors and passed as empty objects
+    //                with loaded false. Up to 128 files are in flight at once on io_uring, which
+    //                opens, stats, reads and closes them without a system call per step; where
+    //                the kernel lacks it (or uring is false) a pool of 16 threads loads them
+    //                instead, and done may then be called from several threads at once. Returns
+    //                once every file was passed to done.
+    
+    static std::vector<std::future<data>> loadMany(const std::vector<std::string> &paths,
+                                                   std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    // Postcondition: Same as above on a thread of its own, returning at once with a future per
+    //                path. Files that cannot be read give empty objects. The loads go on if the
+    //                futures are dropped, and the program waits for them when it exits, so the
+    //                resource must outlive them.
     
+    /*** Streaming ***/
+    size_t readFrom(std::istream &in, size_t limit = unlimited);
+    // Postcondition: Appends up to limit bytes read from in, stopping at the end of the stream
+    //                (which sets eofbit) or once the maximum capacity is reached, and returns the
+    //                amount of bytes appended. The bytes are read in chunks of streamChunk right
+    //                into the buffer, which grows by the growth policy as they arrive; an
+    //                overwriting ring keeps only the newest bytes, so it reads any amount of
+    //                input in bounded memory.
+    
+    size_t readFrom(int fd, size_t limit = unlimited);
+    // Postcondition: Same as above reading from a descriptor, such as a pipe or a socket. Also
+    //                stops, without an error, when a non-blocking descriptor has nothing more to
+    //                read for now. A failing read is reported as an error.
+    
+    /*** Parallel I/O ***/
+    void useParallelIO(unsigned threads = 0, bool direct = false);
+    // Postcondition: Makes saves write extents of at least two chunks as parallelChunk sized
+    //                pieces on up to threads threads (all cores if 0, none if 1) with pwrite.
+    //                With direct, the block-aligned part of every piece goes through O_DIRECT,
+    //                bypassing the page cache; file systems that refuse it, and unaligned ends,
+    //                fall back to ordinary writes. Loading in parallel or parallelDirect mode
+    //                turns this on with all cores.
+    
+    /*** Statistics ***/
+    dataStats statistics();
+    // Postcondition: Returns the allocation, copy and latency counters of this object, which are
+    //                all 0 unless built with DATA_STATS. They stay with the object when its
+    //                content moves to another one.
+    
+    void resetStatistics();
+    // Postcondition: Sets the counters of this object to 0.
+
 protected:
-    void allocate();
-    // Postcondition: Doubles the capacity of the buffer.
+    void allocate(size_t needed);
+    // Precondition: needed must not exceed the maximum capacity.
+    // Postcondition: Grows the capacity of the buffer following the growth policy, to at least
+    //                needed bytes and at most the maximum capacity.
+    
+    void makeRoom(size_t needed);
+    // Precondition: needed must not exceed the maximum capacity.
+    // Postcondition: Makes the first needed bytes writable: grows the capacity if it is smaller,
+    //                and the file behind a writable mapping to the end of the page holding the last
+    //                of them if it is shorter.
     
+    void detach();
+    // Postcondition: Copies mapped or shared bytes into owned storage, so they can be changed.
+    
+    void flatten();
+    // Postcondition: Materializes pending piece table edits or compressed bytes into a single owned
+    //                buffer.
+
 private:
-    byte *bytes;            // A buffer (array) of bytes.
-    int count;              // The amount of bytes.
-    int internalCapacity;   // The current buffer capacity.
-    int maxCapacity;        // The maximum allowed allocation of bytes.
-    std::string filePath;   // An optional filePath if loaded from a file.
+    class pieceTable;
+    class blockStore;
+    
+    pieceTable *editTable();
+    // Postcondition: Returns the piece table, creating one over the current bytes if needed.
+    
+    byte storedAt(size_t i);
+    // Postcondition: Returns the byte at i through the piece table or the compressed blocks.
+    
+    void copyStored(byte *dst, size_t i, size_t n) const;
+    // Precondition: There must be a piece table or compressed blocks.
+    // Postcondition: Copies the n bytes starting at i through them into dst.
+    
+    void readDescriptor(int fd, size_t hint);
+    // Postcondition: Reads everything left in fd into an owned buffer, hint being the expected size.
+    
+    byte * streamSpace(size_t left, size_t &room);
+    // Postcondition: Returns where readFrom reads its next chunk and sets room to the size of the
+    //                chunk (at most left), or returns nullptr if no byte fits.
+    
+    void commitStream(size_t n);
+    // Precondition: n must not exceed the room last set by streamSpace.
+    // Postcondition: Appends the n bytes read into that chunk.
+    
+    void readParallel(int fd, size_t length);
+    // Precondition: fd must be a regular file of length bytes.
+    // Postcondition: Reads it into an owned buffer in chunks on the parallel I/O threads, or
+    //                sequentially if a chunk cannot be read.
+    
+    static bool loadOnUring(const std::vector<std::string> &paths, const loadCallback &done,
+                            std::pmr::memory_resource *resource);
+    // Postcondition: Loads the files for loadMany on io_uring. Returns false, having loaded none,
+    //                if the kernel does not support it. If submitting fails partway, the files not
+    //                loaded yet are loaded on threads.
+    
+    static void loadOnThreads(const std::vector<std::string> &paths, const loadCallback &done,
+                              std::pmr::memory_resource *resource);
+    // Postcondition: Loads the files for loadMany on a pool of threads.
+    
+    bool writeParallel(int fd, size_t begin, size_t end);
+    // Precondition: The bytes must be flat.
+    // Postcondition: Writes the bytes in [begin, end) at the same offset of fd in chunks on the
+    //                parallel I/O threads.
+    
+    void unmap();
+    // Postcondition: Releases the file mapping, if any.
+    
+    void releaseBytes();
+    // Postcondition: Gives up the bytes, whether owned, mapped or shared with views.
+    
+    void share();
+    // Postcondition: Moves the bytes into a block that shared views can keep alive.
+    
+    void initialize();
+    // Postcondition: Sets up an empty object using the inline buffer, without freeing anything.
+    
+    void steal(data &d);
+    // Precondition: This object must be empty and own nothing.
+    // Postcondition: Takes over the content of "d" without allocating and leaves it empty.
+    
+    byte *buffer(size_t n);
+    // Postcondition: Returns room for n bytes: the inline buffer if it fits and is unused,
+    //                otherwise a new array from the resource.
+    
+    byte *allocateBytes(size_t n);
+    // Postcondition: Returns a new array of n bytes from the resource.
+    
+    void deallocateBytes(byte *b, size_t n);
+    // Postcondition: Gives an array of n bytes back to the resource.
+    
+    void resizeBuffer(size_t n);
+    // Precondition: The bytes must be owned and flat, and n must be at least the amount of bytes.
+    // Postcondition: Changes the capacity of the buffer to n, remapping page-backed buffers in place.
+    //                A writable mapping only reserves the address space; makeRoom grows its file.
+    
+    void editInPlace(const std::vector<editBatch::edit> &edits, const byte *added);
+    // Precondition: The edits must be sorted and disjoint, the bytes flat, and there must be room
+    //               for the bytes they leave.
+    // Postcondition: Applies the edits where the bytes are, without another buffer.
+    
+    void markDirty(size_t begin, size_t end);
+    // Postcondition: Records that the bytes in [begin, end) differ from the tracked file.
+    
+    bool shifted();
+    // Postcondition: Returns true if bytes moved since the tracked file was written.
+    
+    bool writeExtent(int fd, size_t begin, size_t end);
+    // Postcondition: Writes the bytes in [begin, end) at the same offset of fd.
+    
+    bool writeChanges(int fd);
+    // Postcondition: Writes the dirty extents into fd and truncates it to the current size.
+    
+    bool patchFile();
+    // Postcondition: Saves in place by writing only the dirty extents.
+    
+    bool rewriteFile();
+    // Postcondition: Saves in place by writing every byte.
+    
+    bool writeWhole(int fd);
+    // Postcondition: Writes every byte to fd in the format of the file.
+    
+    bool replaceFile(bool patch, mode_t permissions);
+    // Postcondition: Saves through a synced temporary file renamed over the target, cloning the
+    //                target and writing only the dirty extents when patch is true and the file
+    //                system supports it.
+    
+    void track(int fd);
+    // Postcondition: Makes the file behind fd the tracked file, with nothing dirty.
+    
+    bool syncFile();
+    // Precondition: The file must be mapped writable.
+    // Postcondition: Flushes the dirty pages of the mapping, truncates the file to the bytes and
+    //                makes it the tracked file.
+    
+    void closeFile();
+    // Postcondition: Copies the bytes of a writable mapping into owned storage, leaving the file
+    //                with the edits made so far.
+    
+    bool remapFile();
+    // Precondition: The bytes must be mapped writable and the file at filePath must hold them.
+    // Postcondition: Moves the mapping onto the file at filePath, leaving the one it leaves cut
+    //                down to the bytes. Returns false, with the bytes copied into owned storage,
+    //                if that file cannot be mapped.
+    
+    static const size_t inlineCapacity = 32;   // Payloads up to this size need no heap allocation.
+    
+    byte *bytes;                // A buffer (array) of bytes. Points into the mapping while mapped.
+    size_t count;               // The amount of bytes.
+    size_t internalCapacity;    // The current buffer capacity.
+    size_t maxCapacity;         // The maximum allowed allocation of bytes, or unlimited.
+    growthPolicy growth;        // How the buffer grows.
+    size_t growthStep;          // The amount of bytes added by the fixedStep policy.
+    std::string filePath;       // An optional filePath if loaded from a file.
+    
+    std::pmr::memory_resource *resource;    // Where the owned buffers come from.
+    
+    unsigned ioThreads;             // Threads for parallel reads and writes; 1 when sequential.
+    bool ioDirect;                  // True if parallel reads and writes try O_DIRECT.
+    
+    const byte *mapping;            // View of the loaded file, or nullptr when owned.
+    size_t mappingLength;           // The length of the mapping.
+    int mappedFile;                 // The file behind a writable mapping, or -1 when read-only.
+    size_t fileLength;              // The length of that file, which the bytes never pass.
+    dev_t mappedDevice;             // Device of the mapped file.
+    ino_t mappedInode;              // Inode of the mapped file.
+    
+    bool tracking;                  // True if the bytes were loaded from or saved to a file.
+    dev_t savedDevice;              // Device of that file.
+    ino_t savedInode;               // Inode of that file.
+    size_t savedLength;             // The length of that file when it was loaded or saved.
+    std::vector<std::pair<size_t, size_t>> dirty;   // Sorted, disjoint [begin, end) extents changed since.
+    
+    byte *ring;                     // The mirrored ring the bytes live in, or nullptr.
+    size_t ringLength;              // Its size, which is also the maximum capacity.
+    bool ringOverwrite;             // True if appending to a full ring drops the oldest bytes.
+    
+    bool pieceEditing;              // True if edits go through a piece table.
+    pieceTable *pieces;             // Pending piece table edits, or nullptr when flat.
+    
+    blockStore *blocks;             // The compressed bytes, or nullptr when not compressed.
+    saveFormat fileFormat;          // The format save writes.
+    
+    std::shared_ptr<sharedView::block> shared;  // Owner of the bytes while shared views exist.
+    
+    byte inlineBytes[inlineCapacity];   // Storage for small payloads.
+
+#if DATA_STATS
+    dataStats stats;                    // Allocation, copy and latency counters.
+#endif
 };
 
+void swap(data &a, data &b) noexcept;
+// Postcondition: Exchanges the content of both data objects.
+
+/** Inline Member Functions **/
+
+// Defined here so that loops over it compile down to plain loads.
+inline byte data::atUnchecked(size_t i)
+{
+    return pieces || blocks ? storedAt(i) : bytes[i];
+}
+
+#if DATA_HAS_SPAN
+// Defined here so that C++20 callers have them whatever standard the library was built with.
+inline data::data(std::span<const byte> s, std::pmr::memory_resource *resource) : data(s.data(), s.size(), resource)
+{
+}
+
+inline std::span<const byte> data::asSpan()
+{
+    return std::span<const byte>(begin(), size());
+}
+
+inline std::span<const std::byte> data::asByteSpan()
+{
+    return std::span<const std::byte>(reinterpret_cast<const std::byte *>(begin()), size());
+}
+
+inline void data::insertBytes(std::span<const byte> s, size_t i)
+{
+    insertBytes(s.data(), s.size(), i);
+}
+
+inline void data::overrideBytes(std::span<const byte> s, range &r)
+{
+    overrideBytes(s.data(), s.size(), r);
+}
+#endif
+
 #endif
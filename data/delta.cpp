@@ -0,0 +1,680 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "data.h"
+#include "hash.h"
+
+// A delta is a header followed by instructions:
+//
+//     'D' 'D' 'L' 'T' 1                        magic and version
+//     varint base length, varint target length
+//     XXH64 of the base, XXH64 of the target   8 bytes each, little endian
+//     instructions until the end
+//
+// Every instruction starts with a varint holding its length shifted left once, with the low bit
+// set for copies. A copy is followed by a zigzag varint: where it starts in the base, relative
+// to where the previous copy ended, so copies that carry on after a few changed bytes cost two
+// or three bytes. Anything else is an add, followed by that many bytes of the target.
+//
+// Both modes split the target into segments matched on their own threads, each producing a
+// sorted list of matches, which are then encoded in order.
+
+/** Delta Format **/
+
+static const byte deltaMagic[5] = {'D', 'D', 'L', 'T', 1};
+
+// Segments of the target matched on one thread are at least this large.
+static const size_t minSegment = 1024 * 1024;
+
+// The shortest new match worth a copy, and the shortest one carrying on the previous copy.
+static const size_t minMatch = 8;
+static const size_t minContinuation = 4;
+
+struct deltaMatch {
+    size_t target;  // Where the match starts in the target.
+    size_t base;    // Where it starts in the base.
+    size_t length;  // The amount of matching bytes.
+};
+
+static void putVarint(std::vector<byte> &out, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<byte>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<byte>(v));
+}
+
+static bool getVarint(const byte *&p, const byte *end, uint64_t &v)
+{
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7)
+    {
+        byte b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static void putHash(std::vector<byte> &out, uint64_t h)
+{
+    for (int i = 0; i < 8; i++)
+        out.push_back(static_cast<byte>(h >> (8 * i)));
+}
+
+static uint64_t getHash(const byte *p)
+{
+    uint64_t h = 0;
+    for (int i = 0; i < 8; i++)
+        h |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return h;
+}
+
+static size_t matchLength(const byte *a, size_t an, const byte *b, size_t bn)
+{
+    size_t n = std::min(an, bn);
+    size_t i = 0;
+    while (i + 8 <= n)
+    {
+        uint64_t x, y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        if (x != y)
+            return i + __builtin_ctzll(x ^ y) / 8;
+        i += 8;
+    }
+    while (i < n && a[i] == b[i])
+        i++;
+    return i;
+}
+
+/** Block Matching **/
+
+// The base is indexed at every multiple of the block size by a polynomial rolling hash, and the
+// target is hashed at every byte. A hit is checked against the base itself (there is no need for
+// a strong hash, as both sides are at hand) and then extended both ways byte by byte.
+
+static const uint64_t rollingFactor = 0x100000001B3ULL;
+
+class blockIndex {
+public:
+    blockIndex(data::view base, size_t blockSize, unsigned threads);
+    
+    size_t block()
+    {
+        return blockSize;
+    }
+    
+    uint64_t hash(const byte *b)
+    {
+        uint64_t h = 0;
+        for (size_t i = 0; i < blockSize; i++)
+            h = h * rollingFactor + b[i];
+        return h;
+    }
+    
+    uint64_t roll(uint64_t h, byte out, byte in)
+    {
+        return (h - out * outFactor) * rollingFactor + in;
+    }
+    
+    size_t find(uint64_t h, const byte *b);
+    // Postcondition: Returns where a block equal to the blockSize bytes at b starts in the base, or
+    //                data::notFound.
+
+private:
+    size_t slotOf(uint64_t h)
+    {
+        return static_cast<size_t>((h * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+    
+    data::view base;
+    size_t blockSize;
+    uint64_t outFactor;             // rollingFactor to the power of blockSize - 1.
+    unsigned shift;                 // 64 minus the log2 of the amount of slots.
+    std::vector<uint64_t> hashes;   // The hash of the block in every slot.
+    std::vector<size_t> blocks;     // The index of the block in every slot plus one, 0 if empty.
+};
+
+blockIndex::blockIndex(data::view b, size_t size, unsigned threads)
+{
+    base = b;
+    blockSize = size;
+    outFactor = 1;
+    for (size_t i = 1; i < blockSize; i++)
+        outFactor *= rollingFactor;
+    
+    size_t n = base.size() / blockSize;
+    size_t slots = 16;
+    while (slots < 2 * n)
+        slots *= 2;
+    shift = 64 - __builtin_ctzll(slots);
+    hashes.assign(slots, 0);
+    blocks.assign(slots, 0);
+    
+    // Hashing the blocks is the expensive part and is spread over the threads.
+    threads = static_cast<unsigned>(std::min<size_t>(threads, 1 + n / 65536));
+    std::vector<uint64_t> h(n);
+    auto work = [&](unsigned t) {
+        for (size_t i = t; i < n; i += threads)
+            h[i] = hash(base.begin() + i * blockSize);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++)
+        pool.emplace_back(work, t);
+    work(0);
+    for (std::thread &t : pool)
+        t.join();
+    
+    // Repeated blocks keep the first occurrence.
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t s = slotOf(h[i]);
+        while (blocks[s] != 0 && hashes[s] != h[i])
+            s = (s + 1) & (slots - 1);
+        if (blocks[s] == 0)
+        {
+            hashes[s] = h[i];
+            blocks[s] = i + 1;
+        }
+    }
+}
+
+size_t blockIndex::find(uint64_t h, const byte *b)
+{
+    for (size_t s = slotOf(h); blocks[s] != 0; s = (s + 1) & (blocks.size() - 1))
+    {
+        if (hashes[s] != h)
+            continue;
+        size_t at = (blocks[s] - 1) * blockSize;
+        if (std::memcmp(base.begin() + at, b, blockSize) == 0)
+            return at;
+        return data::notFound;
+    }
+    return data::notFound;
+}
+
+static void matchBlocks(blockIndex &index, data::view base, data::view target, size_t begin, size_t end,
+                        std::vector<deltaMatch> &matches)
+{
+    const byte *t = target.begin();
+    const byte *b = base.begin();
+    size_t blockSize = index.block();
+    size_t pending = begin;     // The first byte not covered by a match.
+    size_t i = begin;
+    
+    if (end - begin < blockSize)
+        return;
+    uint64_t h = index.hash(t + i);
+    
+    while (i + blockSize <= end)
+    {
+        size_t at = index.find(h, t + i);
+        if (at != data::notFound)
+        {
+            size_t back = 0;
+            while (i - back > pending && at - back > 0 && b[at - back - 1] == t[i - back - 1])
+                back++;
+            size_t length = blockSize + matchLength(b + at + blockSize, base.size() - at - blockSize,
+                                                    t + i + blockSize, end - i - blockSize);
+            matches.push_back({i - back, at - back, back + length});
+            
+            i += length;
+            pending = i;
+            if (i + blockSize <= end)
+                h = index.hash(t + i);
+            continue;
+        }
+        
+        if (i + blockSize < end)
+            h = index.roll(h, t[i], t[i + blockSize]);
+        i++;
+    }
+}
+
+/** Suffix Matching **/
+
+// The suffix array of the base is built with SA-IS, which sorts a few suffixes, induces the
+// order of all the others from them in two linear passes, and recurses on a string at most half
+// as long when the few are not sorted yet. The target is then matched greedily: the previous
+// copy is carried on if at least minContinuation bytes still match (which is how edits inside a
+// copied region stay cheap, as in bsdiff), otherwise the longest match anywhere in the base is
+// taken if it is at least minMatch bytes.
+
+static const uint32_t emptySlot = UINT32_MAX;
+
+static void bucketEdges(const std::vector<uint32_t> &counts, std::vector<uint32_t> &edges, bool ends)
+{
+    uint32_t sum = 0;
+    for (size_t c = 0; c < counts.size(); c++)
+    {
+        sum += counts[c];
+        edges[c] = ends ? sum : sum - counts[c];
+    }
+}
+
+template <class T>
+static void induceSorted(const T *s, uint32_t *sa, size_t n, const std::vector<uint8_t> &small,
+                         const std::vector<uint32_t> &counts, std::vector<uint32_t> &edges)
+{
+    // Larger suffixes from the bucket heads, starting with the last one, which follows the
+    // (implicit) empty suffix.
+    bucketEdges(counts, edges, false);
+    sa[edges[s[n - 1]]++] = static_cast<uint32_t>(n - 1);
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t j = sa[i];
+        if (j != emptySlot && j > 0 && !small[j - 1])
+            sa[edges[s[j - 1]]++] = j - 1;
+    }
+    
+    // Smaller suffixes from the bucket tails.
+    bucketEdges(counts, edges, true);
+    for (size_t i = n; i-- > 0;)
+    {
+        uint32_t j = sa[i];
+        if (j != emptySlot && j > 0 && small[j - 1])
+            sa[--edges[s[j - 1]]] = j - 1;
+    }
+}
+
+template <class T>
+static void sais(const T *s, uint32_t *sa, size_t n, size_t k)
+{
+    if (n == 0)
+        return;
+    if (n == 1)
+    {
+        sa[0] = 0;
+        return;
+    }
+    
+    // A suffix is small if it sorts before the next one; the last one never does. The leftmost
+    // small suffixes of every run are the ones sorted first.
+    std::vector<uint8_t> small(n, 0);
+    for (size_t i = n - 1; i-- > 0;)
+        small[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && small[i + 1]);
+    auto leftmost = [&](size_t i) { return i > 0 && i < n && small[i] && !small[i - 1]; };
+    
+    std::vector<uint32_t> counts(k, 0);
+    std::vector<uint32_t> edges(k);
+    for (size_t i = 0; i < n; i++)
+        counts[s[i]]++;
+    
+    std::fill(sa, sa + n, emptySlot);
+    bucketEdges(counts, edges, true);
+    for (size_t i = 1; i < n; i++)
+        if (leftmost(i))
+            sa[--edges[s[i]]] = static_cast<uint32_t>(i);
+    induceSorted(s, sa, n, small, counts, edges);
+    
+    // The leftmost small suffixes are now sorted by their substrings up to the next one. Equal
+    // substrings get the same name, and the names in text order make the reduced string.
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++)
+        if (leftmost(sa[i]))
+            sa[m++] = sa[i];
+    std::fill(sa + m, sa + n, emptySlot);
+    
+    uint32_t names = 0;
+    size_t previous = n;
+    for (size_t i = 0; i < m; i++)
+    {
+        size_t p = sa[i];
+        bool same = previous != n;
+        for (size_t d = 0; same; d++)
+        {
+            if (p + d == n || previous + d == n || s[p + d] != s[previous + d] || small[p + d] != small[previous + d])
+                same = false;
+            else if (d > 0 && (leftmost(p + d) || leftmost(previous + d)))
+                break;
+        }
+        if (!same)
+            names++;
+        sa[m + p / 2] = names - 1;
+        previous = p;
+    }
+    
+    uint32_t *reduced = sa + n - m;
+    for (size_t i = n, j = n; i-- > m;)
+        if (sa[i] != emptySlot)
+            sa[--j] = sa[i];
+    
+    if (names < m)
+        sais(reduced, sa, m, names);
+    else
+        for (size_t i = 0; i < m; i++)
+            sa[reduced[i]] = static_cast<uint32_t>(i);
+    
+    // Back to positions in s, placed at the bucket tails in sorted order, and induced again.
+    for (size_t i = 1, j = 0; i < n; i++)
+        if (leftmost(i))
+            reduced[j++] = static_cast<uint32_t>(i);
+    for (size_t i = 0; i < m; i++)
+        sa[i] = reduced[sa[i]];
+    std::fill(sa + m, sa + n, emptySlot);
+    
+    bucketEdges(counts, edges, true);
+    for (size_t i = m; i-- > 0;)
+    {
+        uint32_t j = sa[i];
+        sa[i] = emptySlot;
+        sa[--edges[s[j]]] = j;
+    }
+    induceSorted(s, sa, n, small, counts, edges);
+}
+
+static std::vector<uint32_t> suffixArray(data::view base)
+{
+    std::vector<uint32_t> sa(base.size());
+    sais(base.begin(), sa.data(), base.size(), 256);
+    return sa;
+}
+
+struct suffixIndex {
+    std::vector<uint32_t> sa;       // The suffix array.
+    std::vector<uint32_t> buckets;  // Where the suffixes starting with every pair of bytes start in sa.
+};
+
+static void indexSuffixes(data::view base, suffixIndex &index)
+{
+    const byte *b = base.begin();
+    size_t n = base.size();
+    index.sa = suffixArray(base);
+    index.buckets.assign(65537, 0);
+    
+    // The last suffix is a single byte, which sorts like that byte followed by 0.
+    for (size_t s = 0; s < n; s++)
+        index.buckets[(b[s] << 8 | (s + 1 < n ? b[s + 1] : 0)) + 1]++;
+    for (size_t k = 1; k <= 65536; k++)
+        index.buckets[k] += index.buckets[k - 1];
+}
+
+static size_t longestMatch(const suffixIndex &index, data::view base, const byte *t, size_t n, size_t &at)
+{
+    // Only suffixes starting with the same two bytes can make a long enough match.
+    if (n < minMatch)
+        return 0;
+    size_t key = t[0] << 8 | t[1];
+    if (index.buckets[key] == index.buckets[key + 1])
+        return 0;
+    
+    const std::vector<uint32_t> &sa = index.sa;
+    const byte *b = base.begin();
+    size_t lo = index.buckets[key];
+    size_t hi = index.buckets[key + 1] - 1;
+    
+    while (hi - lo > 1)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t s = sa[mid];
+        size_t common = matchLength(b + s, base.size() - s, t, n);
+        bool less = common < n && (s + common == base.size() || b[s + common] < t[common]);
+        if (less)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    
+    size_t x = matchLength(b + sa[lo], base.size() - sa[lo], t, n);
+    size_t y = matchLength(b + sa[hi], base.size() - sa[hi], t, n);
+    at = x >= y ? sa[lo] : sa[hi];
+    return std::max(x, y);
+}
+
+static void matchSuffixes(const suffixIndex &index, data::view base, data::view target, size_t begin,
+                          size_t end, std::vector<deltaMatch> &matches)
+{
+    const byte *t = target.begin();
+    const byte *b = base.begin();
+    size_t i = begin;
+    
+    while (i < end)
+    {
+        if (!matches.empty())
+        {
+            const deltaMatch &last = matches.back();
+            size_t from = last.base + (i - last.target);
+            if (from < base.size())
+            {
+                size_t length = matchLength(b + from, base.size() - from, t + i, end - i);
+                if (length >= minContinuation)
+                {
+                    matches.push_back({i, from, length});
+                    i += length;
+                    continue;
+                }
+            }
+        }
+        
+        size_t at = 0;
+        size_t length = longestMatch(index, base, t + i, end - i, at);
+        if (length >= minMatch)
+        {
+            matches.push_back({i, at, length});
+            i += length;
+        }
+        else
+            i++;
+    }
+}
+
+/** Encoding **/
+
+static void encode(data::view target, const std::vector<deltaMatch> &matches, std::vector<byte> &out)
+{
+    size_t pending = 0;     // The first target byte not written yet.
+    size_t copied = 0;      // Where the previous copy ended in the base.
+    
+    for (size_t m = 0; m <= matches.size(); m++)
+    {
+        size_t next = m < matches.size() ? matches[m].target : target.size();
+        if (next > pending)
+        {
+            putVarint(out, static_cast<uint64_t>(next - pending) << 1);
+            out.insert(out.end(), target.begin() + pending, target.begin() + next);
+        }
+        if (m == matches.size())
+            break;
+        
+        const deltaMatch &c = matches[m];
+        int64_t offset = static_cast<int64_t>(c.base) - static_cast<int64_t>(copied);
+        putVarint(out, static_cast<uint64_t>(c.length) << 1 | 1);
+        putVarint(out, (static_cast<uint64_t>(offset) << 1) ^ static_cast<uint64_t>(offset >> 63));
+        copied = c.base + c.length;
+        pending = c.target + c.length;
+    }
+}
+
+/** Public Member Functions **/
+
+data data::diff(data &base, data &target, deltaMode mode, unsigned threads)
+{
+    view b = base.viewAll();
+    view t = target.viewAll();
+    
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    size_t segments = std::max<size_t>(1, std::min<size_t>(threads, t.size() / minSegment));
+    
+    if (mode == suffixMatching && b.size() >= UINT32_MAX)
+        mode = blockMatching;
+    
+    // Each segment is matched into its own list, on its own thread.
+    std::vector<std::vector<deltaMatch>> found(segments);
+    auto run = [&](auto match) {
+        std::vector<std::thread> pool;
+        for (size_t s = 1; s < segments; s++)
+            pool.emplace_back(match, s);
+        match(0);
+        for (std::thread &p : pool)
+            p.join();
+    };
+    auto bounds = [&](size_t s) {
+        return std::make_pair(t.size() / segments * s, s + 1 == segments ? t.size() : t.size() / segments * (s + 1));
+    };
+    
+    if (b.size() > 0 && t.size() > 0)
+    {
+        if (mode == blockMatching)
+        {
+            // About a million blocks at most, and at least 32 bytes each.
+            size_t blockSize = 32;
+            while (b.size() / blockSize > (1 << 20))
+                blockSize *= 2;
+            
+            if (b.size() >= blockSize)
+            {
+                blockIndex index(b, blockSize, threads);
+                run([&](size_t s) {
+                    std::pair<size_t, size_t> r = bounds(s);
+                    matchBlocks(index, b, t, r.first, r.second, found[s]);
+                });
+            }
+        }
+        else
+        {
+            suffixIndex index;
+            indexSuffixes(b, index);
+            run([&](size_t s) {
+                std::pair<size_t, size_t> r = bounds(s);
+                matchSuffixes(index, b, t, r.first, r.second, found[s]);
+            });
+        }
+    }
+    
+    std::vector<deltaMatch> matches;
+    for (std::vector<deltaMatch> &f : found)
+        matches.insert(matches.end(), f.begin(), f.end());
+    
+    std::vector<byte> out(deltaMagic, deltaMagic + 5);
+    putVarint(out, b.size());
+    putVarint(out, t.size());
+    putHash(out, xxh64Hasher::hash(b));
+    putHash(out, xxh64Hasher::hash(t));
+    encode(t, matches, out);
+    
+    return data(out.data(), out.size());
+}
+
+// Reads the header of a delta, leaving p at its first instruction. Returns false if the delta is
+// malformed or does not belong to the base.
+static bool readHeader(data::view base, data::view delta, const byte *&p, uint64_t &targetLength, uint64_t &targetHash)
+{
+    const byte *end = delta.end();
+    uint64_t baseLength = 0;
+    
+    p = delta.begin();
+    if (delta.size() < 5 || std::memcmp(p, deltaMagic, 5) != 0)
+        return false;
+    p += 5;
+    if (!getVarint(p, end, baseLength) || !getVarint(p, end, targetLength) || end - p < 16)
+        return false;
+    if (baseLength != base.size() || getHash(p) != xxh64Hasher::hash(base))
+        return false;
+    targetHash = getHash(p + 8);
+    p += 16;
+    return true;
+}
+
+// Walks the instructions from p to end, handing every piece of the target to emit. Returns false
+// if one is malformed or they do not add up to targetLength.
+template <class F>
+static bool readInstructions(data::view base, const byte *p, const byte *end, uint64_t targetLength, F emit)
+{
+    uint64_t written = 0;
+    uint64_t copied = 0;
+    while (p < end)
+    {
+        uint64_t tag = 0;
+        if (!getVarint(p, end, tag))
+            return false;
+        uint64_t length = tag >> 1;
+        if (length > targetLength - written)
+            return false;
+        
+        if (tag & 1)
+        {
+            uint64_t zigzag = 0;
+            if (!getVarint(p, end, zigzag))
+                return false;
+            uint64_t from = copied + ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+            if (from > base.size() || length > base.size() - from)
+                return false;
+            emit(base.begin() + from, length);
+            copied = from + length;
+        }
+        else
+        {
+            if (length > static_cast<uint64_t>(end - p))
+                return false;
+            emit(p, length);
+            p += length;
+        }
+        written += length;
+    }
+    
+    return written == targetLength;
+}
+
+data data::applyDelta(data &base, data &delta)
+{
+    view b = base.viewAll();
+    view d = delta.viewAll();
+    const byte *p = nullptr;
+    uint64_t length = 0;
+    uint64_t hash = 0;
+    
+    // The header only claims a length, so the instructions are walked once without copying
+    // before the target is allocated for what they actually add up to.
+    bool valid = readHeader(b, d, p, length, hash) && length <= SIZE_MAX / 2 &&
+                 readInstructions(b, p, d.end(), length, [](const byte *, size_t) {});
+    
+    data target;
+    if (valid)
+    {
+        target.reserve(length);
+        byte *out = target.bytes;
+        size_t written = 0;
+        readInstructions(b, p, d.end(), length, [&](const byte *s, size_t n) {
+            std::memcpy(out + written, s, n);
+            written += n;
+        });
+        target.count = written;
+    }
+    
+    if (!valid || xxh64Hasher::hash(target.viewAll()) != hash)
+    {
+        std::cout << "Error: Attempted to apply an invalid delta, or one made for another base." << std::endl;
+        return data();
+    }
+    return target;
+}
+
+bool data::applyDelta(data &base, data &delta, std::ostream &out)
+{
+    view b = base.viewAll();
+    view d = delta.viewAll();
+    const byte *p = nullptr;
+    uint64_t length = 0;
+    uint64_t hash = 0;
+    xxh64Hasher h;
+    
+    bool valid = readHeader(b, d, p, length, hash) && readInstructions(b, p, d.end(), length, [&](const byte *s, size_t n) {
+        out.write(reinterpret_cast<const char *>(s), n);
+        h.update(s, n);
+    });
+    
+    if (!valid || h.digest() != hash)
+    {
+        std::cout << "Error: Attempted to apply an invalid delta, or one made for another base." << std::endl;
+        return false;
+    }
+    return true;
+}
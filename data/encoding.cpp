@@ -0,0 +1,592 @@
+#include <algorithm>
+#include <cstring>
+#include "data.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DATA_X86 1
+#else
+#define DATA_X86 0
+#endif
+
+// Hex and base64 codecs. Each one has a table driven scalar version and, on x86, SSE4.1 and
+// AVX2 versions that are picked at runtime. The vector loops stop early enough that they never
+// read or write outside the buffers, and the scalar code finishes the tail (and reports errors).
+
+/** Scalar Codecs **/
+
+static const char hexDigits[] = "0123456789abcdef";
+static const char base64Digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+struct decodeTables {
+    byte hex[256];      // Nibble value of each character, or 0xFF.
+    byte base64[256];   // Sextet value of each character, or 0xFF.
+    
+    decodeTables()
+    {
+        std::memset(hex, 0xFF, sizeof(hex));
+        std::memset(base64, 0xFF, sizeof(base64));
+        for (int i = 0; i < 16; i++)
+        {
+            hex[static_cast<byte>(hexDigits[i])] = i;
+            if (i >= 10)
+                hex[static_cast<byte>(hexDigits[i] - 'a' + 'A')] = i;
+        }
+        for (int i = 0; i < 64; i++)
+            base64[static_cast<byte>(base64Digits[i])] = i;
+    }
+};
+
+static const decodeTables tables;
+
+static void hexEncodeScalar(const byte *src, size_t n, char *dst)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        dst[2 * i] = hexDigits[src[i] >> 4];
+        dst[2 * i + 1] = hexDigits[src[i] & 0x0F];
+    }
+}
+
+static bool hexDecodeScalar(const char *src, size_t n, byte *dst)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        byte hi = tables.hex[static_cast<byte>(src[2 * i])];
+        byte lo = tables.hex[static_cast<byte>(src[2 * i + 1])];
+        if ((hi | lo) == 0xFF)
+            return false;
+        dst[i] = (hi << 4) | lo;
+    }
+    return true;
+}
+
+static void base64EncodeScalar(const byte *src, size_t n, char *dst)
+{
+    size_t i = 0;
+    for (; i + 3 <= n; i += 3)
+    {
+        uint32_t v = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+        *dst++ = base64Digits[v >> 18];
+        *dst++ = base64Digits[(v >> 12) & 0x3F];
+        *dst++ = base64Digits[(v >> 6) & 0x3F];
+        *dst++ = base64Digits[v & 0x3F];
+    }
+    
+    if (n - i == 1)
+    {
+        *dst++ = base64Digits[src[i] >> 2];
+        *dst++ = base64Digits[(src[i] & 0x03) << 4];
+        *dst++ = '=';
+        *dst++ = '=';
+    }
+    else if (n - i == 2)
+    {
+        *dst++ = base64Digits[src[i] >> 2];
+        *dst++ = base64Digits[((src[i] & 0x03) << 4) | (src[i + 1] >> 4)];
+        *dst++ = base64Digits[(src[i + 1] & 0x0F) << 2];
+        *dst++ = '=';
+    }
+}
+
+// Decodes n characters (a multiple of 4, padding allowed only in the last quad).
+static size_t base64DecodeScalar(const char *src, size_t n, byte *dst)
+{
+    byte *start = dst;
+    for (size_t i = 0; i < n; i += 4)
+    {
+        byte a = tables.base64[static_cast<byte>(src[i])];
+        byte b = tables.base64[static_cast<byte>(src[i + 1])];
+        if ((a | b) == 0xFF)
+            return data::encodingError;
+        
+        bool last = i + 4 == n;
+        if (last && src[i + 2] == '=' && src[i + 3] == '=')
+        {
+            *dst++ = (a << 2) | (b >> 4);
+            break;
+        }
+        
+        byte c = tables.base64[static_cast<byte>(src[i + 2])];
+        if (c == 0xFF)
+            return data::encodingError;
+        
+        if (last && src[i + 3] == '=')
+        {
+            *dst++ = (a << 2) | (b >> 4);
+            *dst++ = (b << 4) | (c >> 2);
+            break;
+        }
+        
+        byte d = tables.base64[static_cast<byte>(src[i + 3])];
+        if (d == 0xFF)
+            return data::encodingError;
+        
+        *dst++ = (a << 2) | (b >> 4);
+        *dst++ = (b << 4) | (c >> 2);
+        *dst++ = (c << 6) | d;
+    }
+    return dst - start;
+}
+
+/** Vector Codecs **/
+
+#if DATA_X86
+
+// Each vector routine handles a prefix of the input and returns how many source bytes (or
+// characters) it consumed; decoders stop at the first block with an invalid character.
+
+__attribute__((target("sse4.1")))
+static size_t hexEncodeSSE(const byte *src, size_t n, char *dst)
+{
+    const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hexDigits));
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+        __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(in, nibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t hexEncodeAVX2(const byte *src, size_t n, char *dst)
+{
+    const __m256i digits = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hexDigits)));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+        __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(in, nibble));
+        __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2 * i), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2 * i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    return i;
+}
+
+// Turns 16 hex characters into their nibble values, flagging invalid characters in bad.
+__attribute__((target("sse4.1")))
+static inline __m128i hexNibblesSSE(__m128i c, __m128i &bad)
+{
+    __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i isDigit = _mm_cmplt_epi8(_mm_add_epi8(c, _mm_set1_epi8(0x80 - '0')), _mm_set1_epi8(-128 + 10));
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i letter = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+    __m128i isLetter = _mm_cmplt_epi8(_mm_add_epi8(lower, _mm_set1_epi8(0x80 - 'a')), _mm_set1_epi8(-128 + 6));
+    bad = _mm_or_si128(bad, _mm_andnot_si128(_mm_or_si128(isDigit, isLetter), _mm_set1_epi8(-1)));
+    return _mm_blendv_epi8(letter, digit, isDigit);
+}
+
+__attribute__((target("sse4.1")))
+static size_t hexDecodeSSE(const char *src, size_t n, byte *dst)
+{
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    size_t i = 0;
+    
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i bad = _mm_setzero_si128();
+        __m128i a = hexNibblesSSE(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i)), bad);
+        __m128i b = hexNibblesSSE(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i + 16)), bad);
+        if (!_mm_testz_si128(bad, bad))
+            break;
+        __m128i out = _mm_packus_epi16(_mm_maddubs_epi16(a, weights), _mm_maddubs_epi16(b, weights));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), out);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i hexNibblesAVX2(__m256i c, __m256i &bad)
+{
+    __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i isDigit = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 10), _mm256_add_epi8(c, _mm256_set1_epi8(0x80 - '0')));
+    __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    __m256i letter = _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10));
+    __m256i isLetter = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 6), _mm256_add_epi8(lower, _mm256_set1_epi8(0x80 - 'a')));
+    bad = _mm256_or_si256(bad, _mm256_andnot_si256(_mm256_or_si256(isDigit, isLetter), _mm256_set1_epi8(-1)));
+    return _mm256_blendv_epi8(letter, digit, isDigit);
+}
+
+__attribute__((target("avx2")))
+static size_t hexDecodeAVX2(const char *src, size_t n, byte *dst)
+{
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    size_t i = 0;
+    
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i bad = _mm256_setzero_si256();
+        __m256i a = hexNibblesAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 2 * i)), bad);
+        __m256i b = hexNibblesAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 2 * i + 32)), bad);
+        if (!_mm256_testz_si256(bad, bad))
+            break;
+        __m256i out = _mm256_packus_epi16(_mm256_maddubs_epi16(a, weights), _mm256_maddubs_epi16(b, weights));
+        out = _mm256_permute4x64_epi64(out, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), out);
+    }
+    return i;
+}
+
+// Splits 12 bytes (arranged by the caller) into 16 sextets and maps them onto the alphabet.
+__attribute__((target("sse4.1")))
+static inline __m128i base64CharsSSE(__m128i in)
+{
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+    __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+    __m128i sextets = _mm_or_si128(t0, t1);
+    
+    __m128i offset = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+    offset = _mm_or_si128(offset, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), sextets), _mm_set1_epi8(13)));
+    const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                        '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(shift, offset), sextets);
+}
+
+__attribute__((target("sse4.1")))
+static size_t base64EncodeSSE(const byte *src, size_t n, char *dst)
+{
+    size_t i = 0;
+    
+    // 16 bytes are loaded for every 12 encoded.
+    for (; i + 16 <= n; i += 12, dst += 16)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                         base64CharsSSE(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i))));
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t base64EncodeAVX2(const byte *src, size_t n, char *dst)
+{
+    const __m256i arrange = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i shift = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                           '/' - 63, 'A', 0, 0,
+                                           'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                           '/' - 63, 'A', 0, 0);
+    size_t i = 0;
+    
+    // Each lane loads 16 bytes for 12 encoded, so the second lane reads up to byte 28.
+    for (; i + 28 <= n; i += 24, dst += 32)
+    {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 12));
+        __m256i in = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), arrange);
+        
+        __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+        __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+        __m256i sextets = _mm256_or_si256(t0, t1);
+        
+        __m256i offset = _mm256_subs_epu8(sextets, _mm256_set1_epi8(51));
+        offset = _mm256_or_si256(offset, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), sextets), _mm256_set1_epi8(13)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_add_epi8(_mm256_shuffle_epi8(shift, offset), sextets));
+    }
+    return i;
+}
+
+// Decodes as many full 16 character blocks as possible. Every store writes 4 bytes past the
+// 12 decoded ones, so the loop keeps at least 8 characters (6 bytes) of real output in reserve.
+__attribute__((target("sse4.1")))
+static size_t base64DecodeSSE(const char *src, size_t n, byte *dst)
+{
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+    size_t i = 0;
+    
+    for (; i + 24 <= n; i += 16, dst += 12)
+    {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+        __m128i lo = _mm_shuffle_epi8(lutLo, _mm_and_si128(in, mask2F));
+        __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        if (!_mm_testz_si128(lo, hi))
+            break;
+        
+        __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(in, mask2F), hiNibbles));
+        in = _mm_add_epi8(in, roll);
+        
+        __m128i merged = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+        __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        packed = _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), packed);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t base64DecodeAVX2(const char *src, size_t n, byte *dst)
+{
+    const __m256i lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                           0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                           0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                             0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+    const __m256i order = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                           2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i = 0;
+    
+    // Stores write 8 bytes past the 24 decoded ones, hence the 16 character reserve.
+    for (; i + 48 <= n; i += 32, dst += 24)
+    {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask2F);
+        __m256i lo = _mm256_shuffle_epi8(lutLo, _mm256_and_si256(in, mask2F));
+        __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        if (!_mm256_testz_si256(lo, hi))
+            break;
+        
+        __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(in, mask2F), hiNibbles));
+        in = _mm256_add_epi8(in, roll);
+        
+        __m256i merged = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+        __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        packed = _mm256_shuffle_epi8(packed, order);
+        packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), packed);
+    }
+    return i;
+}
+
+#endif
+
+/** Dispatch **/
+
+typedef size_t (*encodeLoop)(const byte *, size_t, char *);
+typedef size_t (*decodeLoop)(const char *, size_t, byte *);
+
+static size_t noEncodeLoop(const byte *, size_t, char *)
+{
+    return 0;
+}
+
+static size_t noDecodeLoop(const char *, size_t, byte *)
+{
+    return 0;
+}
+
+struct codecLoops {
+    encodeLoop hexEncode;
+    decodeLoop hexDecode;
+    encodeLoop base64Encode;
+    decodeLoop base64Decode;
+    
+    codecLoops()
+    {
+        hexEncode = noEncodeLoop;
+        hexDecode = noDecodeLoop;
+        base64Encode = noEncodeLoop;
+        base64Decode = noDecodeLoop;
+
+#if DATA_X86
+        if (__builtin_cpu_supports("avx2"))
+        {
+            hexEncode = hexEncodeAVX2;
+            hexDecode = hexDecodeAVX2;
+            base64Encode = base64EncodeAVX2;
+            base64Decode = base64DecodeAVX2;
+        }
+        else if (__builtin_cpu_supports("sse4.1"))
+        {
+            hexEncode = hexEncodeSSE;
+            hexDecode = hexDecodeSSE;
+            base64Encode = base64EncodeSSE;
+            base64Decode = base64DecodeSSE;
+        }
+#endif
+    }
+};
+
+static const codecLoops &loops()
+{
+    static const codecLoops selected;
+    return selected;
+}
+
+/** Hex Dump **/
+
+static const size_t dumpWidth = 16;         // Bytes per line.
+static const size_t dumpLine = 76;          // The longest line: a 16 digit offset, hex, text and newline.
+static const size_t dumpBlock = 32 * 1024;  // Characters formatted before each write.
+
+struct dumpTables {
+    char pairs[256][2];     // Hex digits of each byte.
+    char text[256];         // Each byte as text, or a dot if it is not printable.
+    
+    dumpTables()
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            pairs[i][0] = hexDigits[i >> 4];
+            pairs[i][1] = hexDigits[i & 0x0F];
+            text[i] = i >= 0x20 && i < 0x7F ? static_cast<char>(i) : '.';
+        }
+    }
+};
+
+static const dumpTables dump;
+
+// Formats the line for the n (at most 16) bytes of src at offset into dst, returning its length.
+static size_t dumpLineAt(const byte *src, size_t n, uint64_t offset, char *dst)
+{
+    int digits = 8;
+    while (digits < 16 && (offset >> (4 * digits)) != 0)
+        digits++;
+    for (int i = digits - 1; i >= 0; i--, offset >>= 4)
+        dst[i] = hexDigits[offset & 0x0F];
+    char *c = dst + digits;
+    *c++ = ':';
+    *c++ = ' ';
+    
+    for (size_t i = 0; i < dumpWidth; i++)
+    {
+        if (i < n)
+        {
+            c[0] = dump.pairs[src[i]][0];
+            c[1] = dump.pairs[src[i]][1];
+        }
+        else
+        {
+            c[0] = ' ';
+            c[1] = ' ';
+        }
+        c += 2;
+        if (i % 2 == 1)
+            *c++ = ' ';
+    }
+    *c++ = ' ';
+    
+    for (size_t i = 0; i < n; i++)
+        *c++ = dump.text[src[i]];
+    *c++ = '\n';
+    return c - dst;
+}
+
+/** Public Member Functions **/
+
+size_t data::hexEncode(const byte *src, size_t n, char *dst)
+{
+    size_t done = loops().hexEncode(src, n, dst);
+    hexEncodeScalar(src + done, n - done, dst + 2 * done);
+    return 2 * n;
+}
+
+size_t data::hexDecode(const char *src, size_t n, byte *dst)
+{
+    if (n % 2 != 0)
+        return encodingError;
+    
+    size_t done = loops().hexDecode(src, n / 2, dst);
+    if (!hexDecodeScalar(src + 2 * done, n / 2 - done, dst + done))
+        return encodingError;
+    return n / 2;
+}
+
+size_t data::base64Length(size_t n)
+{
+    return (n + 2) / 3 * 4;
+}
+
+size_t data::base64Encode(const byte *src, size_t n, char *dst)
+{
+    size_t done = loops().base64Encode(src, n, dst);
+    base64EncodeScalar(src + done, n - done, dst + done / 3 * 4);
+    return base64Length(n);
+}
+
+size_t data::base64Decode(const char *src, size_t n, byte *dst)
+{
+    if (n % 4 != 0)
+        return encodingError;
+    
+    size_t done = loops().base64Decode(src, n, dst);
+    size_t rest = base64DecodeScalar(src + done, n - done, dst + done / 4 * 3);
+    if (rest == encodingError)
+        return encodingError;
+    return done / 4 * 3 + rest;
+}
+
+std::string data::base64Digest()
+{
+    flatten();
+    
+    std::string s(base64Length(size()), '\0');
+    base64Encode(bytes, size(), &s[0]);
+    return s;
+}
+
+void data::hexDump(std::ostream &out, view v, size_t offset)
+{
+    char block[dumpBlock];
+    size_t used = 0;
+    for (size_t i = 0; i < v.size(); i += dumpWidth)
+    {
+        if (used + dumpLine > dumpBlock)
+        {
+            out.write(block, used);
+            used = 0;
+        }
+        used += dumpLineAt(v.begin() + i, std::min(dumpWidth, v.size() - i), offset + i, block + used);
+    }
+    out.write(block, used);
+}
+
+void data::hexDump(std::ostream &out)
+{
+    hexDump(out, viewAll());
+}
+
+data data::fromHex(const std::string &text)
+{
+    data d;
+    d.reserve(text.size() / 2);
+    
+    size_t n = hexDecode(text.data(), text.size(), d.bytes);
+    if (n == encodingError)
+    {
+        std::cout << "Error: Attempted to decode invalid hex text." << std::endl;
+        return data();
+    }
+    
+    d.count = n;
+    return d;
+}
+
+data data::fromBase64(const std::string &text)
+{
+    data d;
+    d.reserve(text.size() / 4 * 3);
+    
+    size_t n = base64Decode(text.data(), text.size(), d.bytes);
+    if (n == encodingError)
+    {
+        std::cout << "Error: Attempted to decode invalid base64 text." << std::endl;
+        return data();
+    }
+    
+    d.count = n;
+    return d;
+}
@@ -0,0 +1,202 @@
+#ifndef FIXED_H
+#define FIXED_H
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include "data.h"
+
+/** fixedData declaration **/
+
+// Up to N bytes stored inline, for small records of known maximum size such as packet headers
+// and keys. A fixedData lives wherever it is declared (on the stack, inside another object) and
+// never touches an allocator. Its capacity is a compile time constant: converting between sizes
+// and concatenating are checked by static_assert, and the checks left in the mutators compare
+// against N rather than a runtime maximum. Everything but the conversions to and from data::view
+// is constexpr, so records can be built at compile time; an out of bounds index or an edit that
+// does not fit then fails to compile, and at runtime it is an error like in data.
+//
+// It is not a data object: views connect the two. asView() gives a data::view that any data
+// function taking bytes accepts, and a fixedData can be built from any view that fits.
+
+template <size_t N>
+class fixedData {
+    static_assert(N > 0, "fixedData must hold at least one byte");
+
+public:
+    /*** Constructors ***/
+    constexpr fixedData() : bytes{}, count(0) {}
+    // Postcondition: Creates an empty object.
+    
+    constexpr fixedData(const byte *b, size_t n) : bytes{}, count(0)
+    {
+        if (n > N)
+            fatal("Fatal error: Attempted to store more bytes than the fixed capacity.");
+        for (size_t i = 0; i < n; i++)
+            bytes[i] = b[i];
+        count = n;
+    }
+    // Precondition: n must not exceed N.
+    // Postcondition: Copies the n bytes of b.
+    
+    template <size_t M>
+    constexpr fixedData(const byte (&b)[M]) : fixedData(b, M)
+    {
+        static_assert(M <= N, "the array does not fit in the fixed capacity");
+    }
+    // Postcondition: Copies the bytes of an array, which must fit at compile time.
+    
+    template <size_t M>
+    constexpr fixedData(const fixedData<M> &d) : fixedData(d.begin(), d.size())
+    {
+        static_assert(M <= N, "the source does not fit in the fixed capacity");
+    }
+    // Postcondition: Copies a smaller (or equal) fixedData.
+    
+    explicit fixedData(data::view v) : fixedData(v.begin(), v.size()) {}
+    // Precondition: The view must not have more than N bytes.
+    // Postcondition: Copies the viewed bytes.
+    
+    /*** Size information ***/
+    static constexpr size_t capacity() { return N; }
+    // Postcondition: Returns N.
+    
+    constexpr size_t size() const { return count; }
+    // Postcondition: Returns the amount of bytes.
+    
+    constexpr bool empty() const { return count == 0; }
+    // Postcondition: Returns true if there are no bytes.
+    
+    constexpr bool full() const { return count == N; }
+    // Postcondition: Returns true if no other byte fits.
+    
+    /*** Bytes retrieval ***/
+    constexpr byte operator[](size_t i) const
+    {
+        if (i >= count)
+            fatal("Fatal error: Index out of bounds.");
+        return bytes[i];
+    }
+    // Precondition: i must be less than size().
+    // Postcondition: Returns the byte in the specified index.
+    
+    constexpr const byte *begin() const { return bytes; }
+    // Postcondition: Returns a pointer to the first byte.
+    
+    constexpr const byte *end() const { return bytes + count; }
+    // Postcondition: Returns a pointer one past the last byte.
+    
+    data::view asView() const { return data::view(bytes, count); }
+    // Postcondition: Returns a view of the bytes, invalidated by the next change.
+    
+    /*** Bytes manipulation ***/
+    constexpr void appendByte(byte b)
+    {
+        if (count == N)
+        {
+            rejected("Error: Attempted to append a byte when the buffer has no more capacity.");
+            return;
+        }
+        bytes[count++] = b;
+    }
+    // Postcondition: Appends a byte at the end if it fits.
+    
+    constexpr void prependByte(byte b)
+    {
+        insertBytes(&b, 1, 0);
+    }
+    // Postcondition: Prepends a byte at the beginning if it fits.
+    
+    constexpr void insertBytes(const byte *b, size_t n, size_t i)
+    {
+        if (i > count)
+            fatal("Fatal error: Index out of bounds.");
+        if (n > N - count)
+        {
+            rejected("Error: Attempted to insert a buffer of bytes when it will exceed the capacity.");
+            return;
+        }
+        for (size_t j = count; j-- > i;)
+            bytes[j + n] = bytes[j];
+        for (size_t j = 0; j < n; j++)
+            bytes[i + j] = b[j];
+        count += n;
+    }
+    // Precondition: i must not exceed size().
+    // Postcondition: Inserts the n bytes of b before the byte at i (or at the end if i is the
+    //                size) if they fit.
+    
+    constexpr void overrideBytes(const byte *b, size_t n, size_t i)
+    {
+        if (i > count || n > count - i)
+            fatal("Fatal error: Index out of bounds.");
+        for (size_t j = 0; j < n; j++)
+            bytes[i + j] = b[j];
+    }
+    // Precondition: The n bytes starting at i must be within the bytes.
+    // Postcondition: Overwrites the n bytes starting at i with those of b.
+    
+    constexpr void removeBytes(size_t i, size_t n)
+    {
+        if (i > count || n > count - i)
+            fatal("Fatal error: Index out of bounds.");
+        for (size_t j = i + n; j < count; j++)
+            bytes[j - n] = bytes[j];
+        count -= n;
+    }
+    // Precondition: The n bytes starting at i must be within the bytes.
+    // Postcondition: Removes the n bytes starting at i.
+    
+    constexpr void removeByteAt(size_t i)
+    {
+        removeBytes(i, 1);
+    }
+    // Precondition: i must be less than size().
+    // Postcondition: Removes the byte at i.
+    
+    constexpr void clear() { count = 0; }
+    // Postcondition: Removes every byte.
+    
+    /*** Comparison ***/
+    template <size_t M>
+    constexpr bool operator==(const fixedData<M> &d) const
+    {
+        if (count != d.size())
+            return false;
+        for (size_t i = 0; i < count; i++)
+            if (bytes[i] != d.begin()[i])
+                return false;
+        return true;
+    }
+    
+    template <size_t M>
+    constexpr bool operator!=(const fixedData<M> &d) const { return !(*this == d); }
+    // Postcondition: Compares the bytes.
+
+private:
+    static void rejected(const char *message)
+    {
+        std::cout << message << std::endl;
+    }
+    // Postcondition: Prints an error. Not constexpr, so that reaching it at compile time fails.
+    
+    static void fatal(const char *message)
+    {
+        std::cout << message << std::endl;
+        exit(1);
+    }
+    // Postcondition: Prints a fatal error and exits. Not constexpr either.
+    
+    byte bytes[N];      // The bytes, inline.
+    size_t count;       // The amount of bytes in use.
+};
+
+template <size_t M, size_t K>
+constexpr fixedData<M + K> operator+(const fixedData<M> &a, const fixedData<K> &b)
+{
+    fixedData<M + K> joined(a);
+    joined.insertBytes(b.begin(), b.size(), joined.size());
+    return joined;
+}
+// Postcondition: Returns the bytes of a followed by those of b, in a capacity that always fits them.
+
+#endif
@@ -0,0 +1,685 @@
+#include <cstring>
+#include <algorithm>
+#include "hash.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HASH_X86 1
+#else
+#define HASH_X86 0
+#endif
+
+/** Helpers **/
+
+static inline uint32_t read32(const byte *p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint64_t read64(const byte *p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t rotl64(uint64_t v, int r)
+{
+    return (v << r) | (v >> (64 - r));
+}
+
+static inline uint32_t rotr32(uint32_t v, int r)
+{
+    return (v >> r) | (v << (32 - r));
+}
+
+static inline void writeLittle(uint64_t v, byte *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = static_cast<byte>(v >> (8 * i));
+}
+
+/** hasher **/
+
+hasher::hasher()
+{
+    followed = 0;
+}
+
+hasher::~hasher()
+{
+}
+
+void hasher::update(const byte *b, size_t n)
+{
+    if (n > 0)
+        absorb(b, n);
+}
+
+void hasher::update(data::view v)
+{
+    update(v.begin(), v.size());
+}
+
+void hasher::follow(data &d)
+{
+    if (d.size() < followed)
+    {
+        std::cout << "Error: Attempted to follow a data object that shrank since it was last hashed." << std::endl;
+        return;
+    }
+    
+    if (d.size() == followed)
+        return;
+    
+    update(d.viewAll().slice(followed, d.size() - followed));
+    followed = d.size();
+}
+
+void hasher::reset()
+{
+    followed = 0;
+    restart();
+}
+
+/** crc32cHasher **/
+
+// Tables for the slicing-by-8 software fallback.
+struct crc32cTables {
+    uint32_t t[8][256];
+    
+    crc32cTables()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1)));
+            t[0][i] = c;
+        }
+        for (int s = 1; s < 8; s++)
+            for (int i = 0; i < 256; i++)
+                t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+    }
+};
+
+static uint32_t crc32cSoftware(uint32_t crc, const byte *b, size_t n)
+{
+    static const crc32cTables tables;
+    
+    for (; n >= 8; n -= 8, b += 8)
+    {
+        uint32_t lo = read32(b) ^ crc;
+        uint32_t hi = read32(b + 4);
+        crc = tables.t[7][lo & 0xFF] ^ tables.t[6][(lo >> 8) & 0xFF] ^ tables.t[5][(lo >> 16) & 0xFF] ^
+              tables.t[4][lo >> 24] ^ tables.t[3][hi & 0xFF] ^ tables.t[2][(hi >> 8) & 0xFF] ^
+              tables.t[1][(hi >> 16) & 0xFF] ^ tables.t[0][hi >> 24];
+    }
+    for (; n > 0; n--, b++)
+        crc = (crc >> 8) ^ tables.t[0][(crc ^ *b) & 0xFF];
+    return crc;
+}
+
+#if HASH_X86
+__attribute__((target("sse4.2")))
+static uint32_t crc32cHardware(uint32_t crc, const byte *b, size_t n)
+{
+    uint64_t c = crc;
+    for (; n >= 8; n -= 8, b += 8)
+        c = _mm_crc32_u64(c, read64(b));
+    for (; n > 0; n--, b++)
+        c = _mm_crc32_u8(static_cast<uint32_t>(c), *b);
+    return static_cast<uint32_t>(c);
+}
+#endif
+
+static uint32_t (*selectCrc32c())(uint32_t, const byte *, size_t)
+{
+#if HASH_X86
+    if (__builtin_cpu_supports("sse4.2"))
+        return crc32cHardware;
+#endif
+    return crc32cSoftware;
+}
+
+crc32cHasher::crc32cHasher()
+{
+    restart();
+}
+
+crc32cHasher::digestType crc32cHasher::digest()
+{
+    return ~state;
+}
+
+crc32cHasher::digestType crc32cHasher::hash(data::view v)
+{
+    crc32cHasher h;
+    h.update(v);
+    return h.digest();
+}
+
+void crc32cHasher::digestBytes(digestType d, byte *out)
+{
+    writeLittle(d, out, digestSize);
+}
+
+void crc32cHasher::absorb(const byte *b, size_t n)
+{
+    static uint32_t (*const crc)(uint32_t, const byte *, size_t) = selectCrc32c();
+    state = crc(state, b, n);
+}
+
+void crc32cHasher::restart()
+{
+    state = 0xFFFFFFFFu;
+}
+
+/** xxh64Hasher **/
+
+static const uint64_t prime64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t prime64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t prime64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t prime64_5 = 0x27D4EB2F165667C5ULL;
+static const uint32_t prime32_1 = 0x9E3779B1U;
+static const uint32_t prime32_2 = 0x85EBCA77U;
+static const uint32_t prime32_3 = 0xC2B2AE3DU;
+
+static inline uint64_t xxh64Round(uint64_t acc, uint64_t input)
+{
+    acc += input * prime64_2;
+    acc = rotl64(acc, 31);
+    return acc * prime64_1;
+}
+
+static inline uint64_t xxh64Merge(uint64_t acc, uint64_t lane)
+{
+    acc ^= xxh64Round(0, lane);
+    return acc * prime64_1 + prime64_4;
+}
+
+static inline uint64_t xxh64Avalanche(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= prime64_2;
+    h ^= h >> 29;
+    h *= prime64_3;
+    return h ^ (h >> 32);
+}
+
+xxh64Hasher::xxh64Hasher()
+{
+    restart();
+}
+
+xxh64Hasher::digestType xxh64Hasher::digest()
+{
+    uint64_t h;
+    if (total >= 32)
+    {
+        h = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+        for (int i = 0; i < 4; i++)
+            h = xxh64Merge(h, lanes[i]);
+    }
+    else
+    {
+        h = prime64_5;
+    }
+    h += total;
+    
+    const byte *p = stripe;
+    size_t n = buffered;
+    for (; n >= 8; n -= 8, p += 8)
+        h = rotl64(h ^ xxh64Round(0, read64(p)), 27) * prime64_1 + prime64_4;
+    if (n >= 4)
+    {
+        h = rotl64(h ^ (read32(p) * prime64_1), 23) * prime64_2 + prime64_3;
+        n -= 4;
+        p += 4;
+    }
+    for (; n > 0; n--, p++)
+        h = rotl64(h ^ (*p * prime64_5), 11) * prime64_1;
+    
+    return xxh64Avalanche(h);
+}
+
+xxh64Hasher::digestType xxh64Hasher::hash(data::view v)
+{
+    xxh64Hasher h;
+    h.update(v);
+    return h.digest();
+}
+
+void xxh64Hasher::digestBytes(digestType d, byte *out)
+{
+    writeLittle(d, out, digestSize);
+}
+
+void xxh64Hasher::absorb(const byte *b, size_t n)
+{
+    total += n;
+    
+    if (buffered + n < 32)
+    {
+        std::memcpy(stripe + buffered, b, n);
+        buffered += n;
+        return;
+    }
+    
+    if (buffered > 0)
+    {
+        size_t fill = 32 - buffered;
+        std::memcpy(stripe + buffered, b, fill);
+        for (int i = 0; i < 4; i++)
+            lanes[i] = xxh64Round(lanes[i], read64(stripe + 8 * i));
+        b += fill;
+        n -= fill;
+        buffered = 0;
+    }
+    
+    for (; n >= 32; n -= 32, b += 32)
+    {
+        lanes[0] = xxh64Round(lanes[0], read64(b));
+        lanes[1] = xxh64Round(lanes[1], read64(b + 8));
+        lanes[2] = xxh64Round(lanes[2], read64(b + 16));
+        lanes[3] = xxh64Round(lanes[3], read64(b + 24));
+    }
+    
+    std::memcpy(stripe, b, n);
+    buffered = n;
+}
+
+void xxh64Hasher::restart()
+{
+    lanes[0] = prime64_1 + prime64_2;
+    lanes[1] = prime64_2;
+    lanes[2] = 0;
+    lanes[3] = 0 - prime64_1;
+    buffered = 0;
+    total = 0;
+}
+
+/** xxh3Hasher **/
+
+static const byte xxh3Secret[192] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static const size_t xxh3StripesPerBlock = (sizeof(xxh3Secret) - 64) / 8;
+
+static inline uint64_t mulFold(uint64_t a, uint64_t b)
+{
+    unsigned __int128 p = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(p) ^ static_cast<uint64_t>(p >> 64);
+}
+
+static inline uint64_t xxh3Avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    return h ^ (h >> 32);
+}
+
+static inline uint64_t xxh3Mix16(const byte *p, const byte *secret)
+{
+    return mulFold(read64(p) ^ read64(secret), read64(p + 8) ^ read64(secret + 8));
+}
+
+static inline void xxh3Accumulate(uint64_t *acc, const byte *p, const byte *secret)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        uint64_t value = read64(p + 8 * i);
+        uint64_t key = value ^ read64(secret + 8 * i);
+        acc[i ^ 1] += value;
+        acc[i] += (key & 0xFFFFFFFFu) * (key >> 32);
+    }
+}
+
+static inline void xxh3Scramble(uint64_t *acc, const byte *secret)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= read64(secret + 8 * i);
+        acc[i] = a * prime32_1;
+    }
+}
+
+// Accumulates n stripes, scrambling at the end of every block.
+static void xxh3Consume(uint64_t *acc, size_t &stripes, const byte *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++, p += 64)
+    {
+        xxh3Accumulate(acc, p, xxh3Secret + 8 * stripes);
+        if (++stripes == xxh3StripesPerBlock)
+        {
+            xxh3Scramble(acc, xxh3Secret + sizeof(xxh3Secret) - 64);
+            stripes = 0;
+        }
+    }
+}
+
+static uint64_t xxh3Merge(const uint64_t *acc, uint64_t length)
+{
+    uint64_t result = length * prime64_1;
+    for (int i = 0; i < 4; i++)
+        result += mulFold(acc[2 * i] ^ read64(xxh3Secret + 11 + 16 * i), acc[2 * i + 1] ^ read64(xxh3Secret + 11 + 16 * i + 8));
+    return xxh3Avalanche(result);
+}
+
+// The one-shot hash of inputs of up to 240 bytes.
+static uint64_t xxh3Short(const byte *p, size_t n)
+{
+    const byte *s = xxh3Secret;
+    
+    if (n == 0)
+        return xxh64Avalanche(read64(s + 56) ^ read64(s + 64));
+    
+    if (n <= 3)
+    {
+        uint32_t combined = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[n >> 1]) << 24) |
+                            p[n - 1] | (static_cast<uint32_t>(n) << 8);
+        return xxh64Avalanche(combined ^ static_cast<uint64_t>(read32(s) ^ read32(s + 4)));
+    }
+    
+    if (n <= 8)
+    {
+        uint64_t input = read32(p + n - 4) + (static_cast<uint64_t>(read32(p)) << 32);
+        uint64_t h = input ^ (read64(s + 8) ^ read64(s + 16));
+        h ^= rotl64(h, 49) ^ rotl64(h, 24);
+        h *= 0x9FB21C651E98DF25ULL;
+        h ^= (h >> 35) + n;
+        h *= 0x9FB21C651E98DF25ULL;
+        return h ^ (h >> 28);
+    }
+    
+    if (n <= 16)
+    {
+        uint64_t lo = read64(p) ^ (read64(s + 24) ^ read64(s + 32));
+        uint64_t hi = read64(p + n - 8) ^ (read64(s + 40) ^ read64(s + 48));
+        return xxh3Avalanche(n + __builtin_bswap64(lo) + hi + mulFold(lo, hi));
+    }
+    
+    uint64_t acc = n * prime64_1;
+    
+    if (n <= 128)
+    {
+        if (n > 32)
+        {
+            if (n > 64)
+            {
+                if (n > 96)
+                {
+                    acc += xxh3Mix16(p + 48, s + 96);
+                    acc += xxh3Mix16(p + n - 64, s + 112);
+                }
+                acc += xxh3Mix16(p + 32, s + 64);
+                acc += xxh3Mix16(p + n - 48, s + 80);
+            }
+            acc += xxh3Mix16(p + 16, s + 32);
+            acc += xxh3Mix16(p + n - 32, s + 48);
+        }
+        acc += xxh3Mix16(p, s);
+        acc += xxh3Mix16(p + n - 16, s + 16);
+        return xxh3Avalanche(acc);
+    }
+    
+    for (size_t i = 0; i < 8; i++)
+        acc += xxh3Mix16(p + 16 * i, s + 16 * i);
+    acc = xxh3Avalanche(acc);
+    for (size_t i = 8; i < n / 16; i++)
+        acc += xxh3Mix16(p + 16 * i, s + 16 * (i - 8) + 3);
+    acc += xxh3Mix16(p + n - 16, s + 136 - 17);
+    return xxh3Avalanche(acc);
+}
+
+xxh3Hasher::xxh3Hasher()
+{
+    restart();
+}
+
+xxh3Hasher::digestType xxh3Hasher::digest()
+{
+    if (total <= 240)
+        return xxh3Short(pending, total);
+    
+    uint64_t a[8];
+    std::memcpy(a, acc, sizeof(a));
+    size_t s = stripes;
+    
+    // The final stripe is always the last 64 bytes, which may reach back into consumed input.
+    byte last[64];
+    const byte *lastStripe;
+    if (buffered >= 64)
+    {
+        xxh3Consume(a, s, pending, (buffered - 1) / 64);
+        lastStripe = pending + buffered - 64;
+    }
+    else
+    {
+        size_t catchup = 64 - buffered;
+        std::memcpy(last, pending + sizeof(pending) - catchup, catchup);
+        std::memcpy(last + catchup, pending, buffered);
+        lastStripe = last;
+    }
+    
+    xxh3Accumulate(a, lastStripe, xxh3Secret + sizeof(xxh3Secret) - 64 - 7);
+    return xxh3Merge(a, total);
+}
+
+xxh3Hasher::digestType xxh3Hasher::hash(data::view v)
+{
+    xxh3Hasher h;
+    h.update(v);
+    return h.digest();
+}
+
+void xxh3Hasher::digestBytes(digestType d, byte *out)
+{
+    writeLittle(d, out, digestSize);
+}
+
+void xxh3Hasher::absorb(const byte *b, size_t n)
+{
+    total += n;
+    
+    // Input is only consumed once more follows it, so the last stripe is never consumed early
+    // and inputs of up to 240 bytes stay whole for the short path.
+    if (buffered + n <= sizeof(pending))
+    {
+        std::memcpy(pending + buffered, b, n);
+        buffered += n;
+        return;
+    }
+    
+    if (buffered > 0)
+    {
+        size_t fill = sizeof(pending) - buffered;
+        std::memcpy(pending + buffered, b, fill);
+        xxh3Consume(acc, stripes, pending, sizeof(pending) / 64);
+        b += fill;
+        n -= fill;
+    }
+    
+    if (n > sizeof(pending))
+    {
+        for (; n > sizeof(pending); n -= sizeof(pending), b += sizeof(pending))
+            xxh3Consume(acc, stripes, b, sizeof(pending) / 64);
+        std::memcpy(pending + sizeof(pending) - 64, b - 64, 64);
+    }
+    
+    std::memcpy(pending, b, n);
+    buffered = n;
+}
+
+void xxh3Hasher::restart()
+{
+    acc[0] = prime32_3;
+    acc[1] = prime64_1;
+    acc[2] = prime64_2;
+    acc[3] = prime64_3;
+    acc[4] = prime64_4;
+    acc[5] = prime32_2;
+    acc[6] = prime64_5;
+    acc[7] = prime32_1;
+    buffered = 0;
+    stripes = 0;
+    total = 0;
+}
+
+/** sha256Hasher **/
+
+static const uint32_t sha256Rounds[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+sha256Hasher::sha256Hasher()
+{
+    restart();
+}
+
+sha256Hasher::digestType sha256Hasher::digest()
+{
+    sha256Hasher copy(*this);
+    
+    byte tail[72] = {0x80};
+    size_t padding = (buffered < 56 ? 56 : 120) - buffered;
+    writeLittle(__builtin_bswap64(total * 8), tail + padding, 8);
+    copy.absorb(tail, padding + 8);
+    
+    digestType d;
+    for (int i = 0; i < 8; i++)
+        writeLittle(__builtin_bswap32(copy.h[i]), &d[4 * i], 4);
+    return d;
+}
+
+sha256Hasher::digestType sha256Hasher::hash(data::view v)
+{
+    sha256Hasher h;
+    h.update(v);
+    return h.digest();
+}
+
+void sha256Hasher::digestBytes(digestType d, byte *out)
+{
+    std::memcpy(out, d.data(), digestSize);
+}
+
+void sha256Hasher::absorb(const byte *b, size_t n)
+{
+    total += n;
+    
+    if (buffered > 0)
+    {
+        size_t fill = std::min(64 - buffered, n);
+        std::memcpy(block + buffered, b, fill);
+        buffered += fill;
+        b += fill;
+        n -= fill;
+        if (buffered < 64)
+            return;
+        compress(block);
+        buffered = 0;
+    }
+    
+    for (; n >= 64; n -= 64, b += 64)
+        compress(b);
+    
+    std::memcpy(block, b, n);
+    buffered = n;
+}
+
+void sha256Hasher::restart()
+{
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    std::memcpy(h, initial, sizeof(h));
+    buffered = 0;
+    total = 0;
+}
+
+void sha256Hasher::compress(const byte *p)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++)
+        w[i] = __builtin_bswap32(read32(p + 4 * i));
+    for (int i = 16; i < 64; i++)
+    {
+        uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 64; i++)
+    {
+        uint32_t t1 = k + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + sha256Rounds[i] + w[i];
+        uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        k = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += k;
+}
+
+/** data Member Functions **/
+
+uint32_t data::crc32c()
+{
+    return crc32cHasher::hash(viewAll());
+}
+
+uint64_t data::xxh64()
+{
+    return xxh64Hasher::hash(viewAll());
+}
+
+uint64_t data::xxh3()
+{
+    return xxh3Hasher::hash(viewAll());
+}
+
+std::string data::sha256()
+{
+    sha256Hasher::digestType d = sha256Hasher::hash(viewAll());
+    std::string s(2 * d.size(), '\0');
+    hexEncode(d.data(), d.size(), &s[0]);
+    return s;
+}
@@ -0,0 +1,207 @@
+#ifndef HASH_H
+#define HASH_H
+#include <algorithm>
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+#include "data.h"
+
+/** hasher declaration **/
+
+// Base of the streaming hashers. Bytes are fed with update(), either as a buffer or a view, or
+// with follow(), which hashes whatever was appended to a data object since the previous call.
+
+class hasher {
+public:
+    hasher();
+    virtual ~hasher();
+    
+    void update(const byte *b, size_t n);
+    // Postcondition: Hashes n more bytes.
+    
+    void update(data::view v);
+    // Postcondition: Hashes the viewed bytes.
+    
+    void follow(data &d);
+    // Precondition: d must only have grown at the end since the previous call.
+    // Postcondition: Hashes the bytes appended to d since the previous call (all of d the first time).
+    
+    void reset();
+    // Postcondition: Starts over as if nothing had been hashed.
+
+protected:
+    virtual void absorb(const byte *b, size_t n) = 0;
+    // Postcondition: Mixes n bytes into the state.
+    
+    virtual void restart() = 0;
+    // Postcondition: Resets the state of the algorithm.
+
+private:
+    size_t followed;    // The amount of bytes of the followed data already hashed.
+};
+
+/** crc32cHasher declaration **/
+
+// CRC-32C (Castagnoli), using the SSE4.2 crc32 instruction when the CPU has it.
+
+class crc32cHasher : public hasher {
+public:
+    typedef uint32_t digestType;
+    static const size_t digestSize = 4;
+    
+    crc32cHasher();
+    
+    digestType digest();
+    // Postcondition: Returns the checksum of the bytes hashed so far.
+    
+    static digestType hash(data::view v);
+    // Postcondition: Returns the checksum of the viewed bytes.
+    
+    static void digestBytes(digestType d, byte *out);
+    // Postcondition: Writes the digest into out (little endian).
+
+protected:
+    void absorb(const byte *b, size_t n);
+    void restart();
+
+private:
+    uint32_t state;
+};
+
+/** xxh64Hasher declaration **/
+
+// XXH64 with a seed of 0.
+
+class xxh64Hasher : public hasher {
+public:
+    typedef uint64_t digestType;
+    static const size_t digestSize = 8;
+    
+    xxh64Hasher();
+    
+    digestType digest();
+    // Postcondition: Returns the hash of the bytes hashed so far.
+    
+    static digestType hash(data::view v);
+    // Postcondition: Returns the hash of the viewed bytes.
+    
+    static void digestBytes(digestType d, byte *out);
+    // Postcondition: Writes the digest into out (little endian).
+
+protected:
+    void absorb(const byte *b, size_t n);
+    void restart();
+
+private:
+    uint64_t lanes[4];  // The four accumulators.
+    byte stripe[32];    // Bytes waiting for a full stripe.
+    size_t buffered;    // The amount of bytes in stripe.
+    uint64_t total;     // The amount of bytes hashed.
+};
+
+/** xxh3Hasher declaration **/
+
+// XXH3 (64 bit) with a seed of 0 and the default secret.
+
+class xxh3Hasher : public hasher {
+public:
+    typedef uint64_t digestType;
+    static const size_t digestSize = 8;
+    
+    xxh3Hasher();
+    
+    digestType digest();
+    // Postcondition: Returns the hash of the bytes hashed so far.
+    
+    static digestType hash(data::view v);
+    // Postcondition: Returns the hash of the viewed bytes.
+    
+    static void digestBytes(digestType d, byte *out);
+    // Postcondition: Writes the digest into out (little endian).
+
+protected:
+    void absorb(const byte *b, size_t n);
+    void restart();
+
+private:
+    uint64_t acc[8];        // The accumulators of the long input path.
+    byte pending[256];      // Bytes not consumed yet; its tail keeps the last consumed stripe.
+    size_t buffered;        // The amount of bytes in pending.
+    size_t stripes;         // Stripes consumed in the current block.
+    uint64_t total;         // The amount of bytes hashed.
+};
+
+/** sha256Hasher declaration **/
+
+class sha256Hasher : public hasher {
+public:
+    typedef std::array<byte, 32> digestType;
+    static const size_t digestSize = 32;
+    
+    sha256Hasher();
+    
+    digestType digest();
+    // Postcondition: Returns the hash of the bytes hashed so far.
+    
+    static digestType hash(data::view v);
+    // Postcondition: Returns the hash of the viewed bytes.
+    
+    static void digestBytes(digestType d, byte *out);
+    // Postcondition: Writes the digest into out.
+
+protected:
+    void absorb(const byte *b, size_t n);
+    void restart();
+
+private:
+    void compress(const byte *block);
+    
+    uint32_t h[8];      // The chaining state.
+    byte block[64];     // Bytes waiting for a full block.
+    size_t buffered;    // The amount of bytes in block.
+    uint64_t total;     // The amount of bytes hashed.
+};
+
+/** Tree Hashing **/
+
+template <class H>
+typename H::digestType treeHash(data::view v, size_t chunk = 1 << 20, unsigned threads = 0)
+// Precondition: chunk must be greater than 0.
+// Postcondition: Splits the bytes into chunks, hashes them on up to threads threads (all cores
+//                if 0) and returns the hash of the chunk digests followed by the length and the
+//                chunk size. The result depends on chunk but not on threads, and differs from
+//                hashing the bytes in one stream.
+{
+    size_t leaves = v.size() / chunk + (v.size() % chunk != 0);
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    if (threads > leaves)
+        threads = leaves > 0 ? static_cast<unsigned>(leaves) : 1;
+    
+    std::vector<byte> digests(leaves * H::digestSize + 16);
+    auto work = [&](unsigned t) {
+        for (size_t i = t; i < leaves; i += threads)
+        {
+            size_t n = std::min(chunk, v.size() - i * chunk);
+            H::digestBytes(H::hash(v.slice(i * chunk, n)), &digests[i * H::digestSize]);
+        }
+    };
+    
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++)
+        pool.emplace_back(work, t);
+    work(0);
+    for (std::thread &t : pool)
+        t.join();
+    
+    uint64_t sizes[2] = {v.size(), chunk};
+    for (int i = 0; i < 16; i++)
+        digests[leaves * H::digestSize + i] = static_cast<byte>(sizes[i / 8] >> (8 * (i % 8)));
+    
+    return H::hash(data::view(digests.data(), digests.size()));
+}
+
+#endif
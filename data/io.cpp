@@ -0,0 +1,694 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#include "data.h"
+
+// Large reads and writes are split into parallelChunk sized pieces at fixed offsets, which a
+// pool of threads takes one at a time with pread and pwrite. With O_DIRECT the block-aligned
+// part of a piece goes through a second descriptor that bypasses the page cache, and whatever
+// it leaves (unaligned ends, a refusal) goes through the ordinary one, so every file system
+// gets the same bytes.
+
+// O_DIRECT needs the buffer, offset and length aligned to the logical block size, which this
+// covers on every common device.
+static const size_t directAlignment = 4096;
+
+/** Helpers **/
+
+// Opens the file behind fd again with O_DIRECT, or returns -1 where that is not allowed.
+static int reopenDirect(int fd, int flags)
+{
+#ifdef O_DIRECT
+    std::string path = "/proc/self/fd/" + std::to_string(fd);
+    return open(path.c_str(), flags | O_DIRECT);
+#else
+    (void)fd;
+    (void)flags;
+    return -1;
+#endif
+}
+
+// Reads (or writes) the bytes of b in [begin, end) at the same offset of fd and returns where it
+// stopped, which is end unless an error or the end of the file came first.
+static size_t transfer(int fd, byte *b, size_t begin, size_t end, bool writing)
+{
+    while (begin < end)
+    {
+        ssize_t r = writing ? pwrite(fd, b + begin, end - begin, static_cast<off_t>(begin))
+                            : pread(fd, b + begin, end - begin, static_cast<off_t>(begin));
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            break;
+        begin += static_cast<size_t>(r);
+    }
+    return begin;
+}
+
+// Transfers [begin, end), its block-aligned part through direct when that is open.
+static bool transferChunk(int fd, int direct, byte *b, size_t begin, size_t end, bool writing)
+{
+    size_t done = begin;
+    if (direct >= 0 && begin % directAlignment == 0)
+        done = transfer(direct, b, begin, begin + (end - begin) / directAlignment * directAlignment, writing);
+    return transfer(fd, b, done, end, writing) == end;
+}
+
+// Calls f on every chunk of the non-empty [begin, end) on up to threads threads and returns true
+// if every call did.
+static bool forEachChunk(size_t begin, size_t end, unsigned threads, const std::function<bool(size_t, size_t)> &f)
+{
+    // Chunks start at multiples of parallelChunk, so that all but the first stay aligned.
+    size_t first = begin / data::parallelChunk;
+    size_t chunks = (end - 1) / data::parallelChunk + 1 - first;
+    threads = static_cast<unsigned>(std::min<size_t>(threads, chunks));
+    
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    auto work = [&]() {
+        for (size_t i = next++; i < chunks && !failed.load(std::memory_order_relaxed); i = next++)
+        {
+            size_t b = std::max(begin, (first + i) * data::parallelChunk);
+            size_t e = std::min(end, (first + i + 1) * data::parallelChunk);
+            if (!f(b, e))
+                failed = true;
+        }
+    };
+    
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++)
+        pool.emplace_back(work);
+    work();
+    for (std::thread &t : pool)
+        t.join();
+    
+    return !failed;
+}
+
+/** io_uring **/
+
+// loadMany keeps this many files in flight on io_uring, or loads this many at once on threads.
+static const unsigned uringDepth = 128;
+static const unsigned loadThreads = 16;
+
+// The submission and completion rings of an io_uring instance, mapped straight from the kernel
+// without liburing. Entries are filled with next() and handed to the kernel by submitAndWait();
+// only the thread that set it up touches it.
+class uring {
+public:
+    uring(unsigned entries);
+    ~uring();
+    
+    bool ready()
+    {
+        return fd >= 0;
+    }
+    
+    io_uring_sqe * next();
+    // Precondition: Fewer than entries operations may be in flight.
+    // Postcondition: Returns a cleared entry that the next submitAndWait() submits.
+    
+    bool submitAndWait();
+    // Postcondition: Submits the new entries and waits for at least one completion.
+    
+    bool reap(io_uring_cqe &c);
+    // Postcondition: Takes the oldest completion into c, or returns false if there is none.
+    
+    void release();
+    // Postcondition: Unmaps the rings and closes the instance, which cancels the operations still
+    //                in flight.
+
+private:
+    bool supports(std::initializer_list<int> ops);
+    // Postcondition: Returns true if the kernel knows every one of the operations.
+    
+    int fd;                     // The instance, or -1 if it could not be set up.
+    void *sqMap;                // The submission ring mapping.
+    void *cqMap;                // The completion ring mapping, the same one on newer kernels.
+    io_uring_sqe *sqes;         // The submission entries.
+    size_t sqLength;
+    size_t cqLength;
+    unsigned entries;
+    
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    io_uring_cqe *cqes;
+    
+    unsigned tail;              // The submission tail including entries not yet submitted.
+    unsigned queued;            // The amount of those.
+};
+
+uring::uring(unsigned n) : fd(-1), sqMap(MAP_FAILED), cqMap(MAP_FAILED), sqes(nullptr), queued(0)
+{
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    int f = static_cast<int>(syscall(__NR_io_uring_setup, n, &p));
+    if (f < 0)
+        return;
+    
+    entries = p.sq_entries;
+    sqLength = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqLength = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single)
+        sqLength = cqLength = std::max(sqLength, cqLength);
+    
+    sqMap = mmap(nullptr, sqLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, f, IORING_OFF_SQ_RING);
+    cqMap = single ? sqMap : mmap(nullptr, cqLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, f, IORING_OFF_CQ_RING);
+    void *s = mmap(nullptr, entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, f,
+                   IORING_OFF_SQES);
+    if (s != MAP_FAILED)
+        sqes = static_cast<io_uring_sqe *>(s);
+    
+    fd = f;
+    if (sqMap == MAP_FAILED || cqMap == MAP_FAILED || sqes == nullptr ||
+        !supports({IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE}))
+    {
+        release();
+        return;
+    }
+    
+    byte *sq = static_cast<byte *>(sqMap);
+    sqHead = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+    byte *cq = static_cast<byte *>(cqMap);
+    cqHead = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+    tail = *sqTail;
+}
+
+uring::~uring()
+{
+    release();
+}
+
+void uring::release()
+{
+    if (sqes)
+        munmap(sqes, entries * sizeof(io_uring_sqe));
+    if (cqMap != MAP_FAILED && cqMap != sqMap)
+        munmap(cqMap, cqLength);
+    if (sqMap != MAP_FAILED)
+        munmap(sqMap, sqLength);
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+    sqMap = cqMap = MAP_FAILED;
+    sqes = nullptr;
+}
+
+io_uring_sqe * uring::next()
+{
+    unsigned i = tail & *sqMask;
+    io_uring_sqe *s = &sqes[i];
+    std::memset(s, 0, sizeof(*s));
+    sqArray[i] = i;
+    tail++;
+    queued++;
+    return s;
+}
+
+bool uring::submitAndWait()
+{
+    // The kernel reads the new entries once it sees the tail move past them.
+    __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+    
+    long r;
+    do
+        r = syscall(__NR_io_uring_enter, fd, queued, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    while (r < 0 && errno == EINTR);
+    
+    queued = 0;
+    return r >= 0;
+}
+
+bool uring::reap(io_uring_cqe &c)
+{
+    unsigned head = *cqHead;
+    if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+        return false;
+    c = cqes[head & *cqMask];
+    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool uring::supports(std::initializer_list<int> ops)
+{
+    size_t n = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    io_uring_probe *probe = static_cast<io_uring_probe *>(calloc(1, n));
+    bool known = probe && syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) >= 0;
+    for (int op : ops)
+        known = known && op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return known;
+}
+
+// A file being loaded on io_uring, which goes through each stage in turn with one operation in
+// flight at a time.
+struct uringFile {
+    enum stage {
+        opening,
+        statting,
+        reading,
+        closing
+    };
+    
+    size_t index;           // Its index in the paths.
+    stage step;             // The operation in flight.
+    int fd;                 // The open file.
+    bool loaded;            // False once an operation failed.
+    bool regular;           // True for non-empty regular files, read up to the size statx gives.
+    size_t length;          // That size.
+    struct statx st;        // Filled in by the statx operation.
+    data d;                 // The bytes.
+};
+
+/** Loader Threads **/
+
+// The threads of the loadMany overload returning futures. Finished ones are joined whenever
+// another starts and the rest when the program exits, so none is left running past main with
+// the statics it uses being destroyed. Being a function-local static, it is destroyed before
+// every static that existed when the first loader started.
+class loaderThreads {
+public:
+    ~loaderThreads()
+    {
+        for (loader &l : loaders)
+            l.thread.join();
+    }
+    
+    void start(std::function<void()> work)
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        for (loader &l : loaders)
+            if (l.finished->load())
+                l.thread.join();
+        loaders.erase(std::remove_if(loaders.begin(), loaders.end(), [](const loader &l) {
+            return !l.thread.joinable();
+        }), loaders.end());
+        
+        auto finished = std::make_shared<std::atomic<bool>>(false);
+        loaders.push_back({std::thread([work, finished]() {
+            work();
+            finished->store(true);
+        }), finished});
+    }
+    // Postcondition: Runs work on a thread of its own, joining the loaders that finished.
+
+private:
+    struct loader {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> finished;    // Set once the work returned.
+    };
+    
+    std::mutex lock;                // Guards loaders.
+    std::vector<loader> loaders;    // Every thread not joined yet.
+};
+
+// Returns the loader threads, created on first use.
+static loaderThreads & loaders()
+{
+    static loaderThreads threads;
+    return threads;
+}
+
+/** Public Member Functions **/
+
+void data::useParallelIO(unsigned threads, bool direct)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    ioThreads = threads > 0 ? threads : 1;
+    ioDirect = direct;
+}
+
+void data::loadMany(const std::vector<std::string> &paths, const loadCallback &done, bool uring,
+                    std::pmr::memory_resource *resource)
+{
+    if (paths.empty())
+        return;
+    if (uring && loadOnUring(paths, done, resource))
+        return;
+    loadOnThreads(paths, done, resource);
+}
+
+std::vector<std::future<data>> data::loadMany(const std::vector<std::string> &paths,
+                                              std::pmr::memory_resource *resource)
+{
+    auto promises = std::make_shared<std::vector<std::promise<data>>>(paths.size());
+    std::vector<std::future<data>> futures;
+    for (std::promise<data> &p : *promises)
+        futures.push_back(p.get_future());
+    
+    // The thread owns copies of everything it needs, so it may outlive the caller's arguments.
+    loaders().start([paths, promises, resource]() {
+        loadMany(paths, [&](size_t i, data &d, bool) { (*promises)[i].set_value(std::move(d)); }, true, resource);
+    });
+    
+    return futures;
+}
+
+size_t data::readFrom(std::istream &in, size_t limit)
+{
+    std::istream::sentry ready(in, true);
+    if (!ready)
+        return 0;
+    
+    size_t total = 0;
+    size_t room;
+    byte *b;
+    while (total < limit && (b = streamSpace(limit - total, room)) != nullptr)
+    {
+        std::streamsize r = in.rdbuf()->sgetn(reinterpret_cast<char *>(b), static_cast<std::streamsize>(room));
+        if (r <= 0)
+        {
+            in.setstate(std::ios::eofbit);
+            break;
+        }
+        commitStream(static_cast<size_t>(r));
+        total += r;
+    }
+    return total;
+}
+
+size_t data::readFrom(int fd, size_t limit)
+{
+    size_t total = 0;
+    size_t room;
+    byte *b;
+    while (total < limit && (b = streamSpace(limit - total, room)) != nullptr)
+    {
+        ssize_t r = read(fd, b, room);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+            std::cout << "Error: Could not read from file descriptor " << fd << "." << std::endl;
+        if (r <= 0)
+            break;
+        commitStream(static_cast<size_t>(r));
+        total += r;
+    }
+    return total;
+}
+
+/** Private Member Functions **/
+
+bool data::loadOnUring(const std::vector<std::string> &paths, const loadCallback &done,
+                       std::pmr::memory_resource *resource)
+{
+    // Every slot holds one file with one operation in flight, so the rings never overflow. The
+    // slots are declared first so that the ring, and whatever it still reads into them, goes first.
+    std::vector<uringFile> slots(std::min<size_t>(uringDepth, paths.size()));
+    ::uring ring(uringDepth);
+    if (!ring.ready())
+        return false;
+    
+    std::vector<size_t> freeSlots;
+    for (size_t i = slots.size(); i-- > 0;)
+        freeSlots.push_back(i);
+    
+    size_t next = 0;
+    size_t active = 0;
+    
+    auto read = [&](uringFile &f, size_t slot) {
+        if (f.d.count == f.d.internalCapacity)
+            f.d.resizeBuffer(f.d.internalCapacity * 2);
+        io_uring_sqe *s = ring.next();
+        s->opcode = IORING_OP_READ;
+        s->fd = f.fd;
+        s->addr = reinterpret_cast<uint64_t>(f.d.bytes + f.d.count);
+        s->len = static_cast<uint32_t>(std::min<size_t>(f.d.internalCapacity - f.d.count, UINT32_MAX));
+        s->off = f.regular ? f.d.count : UINT64_MAX;    // Other files read from where they are.
+        s->user_data = slot;
+    };
+    
+    auto deliver = [&](uringFile &f, size_t slot) {
+        if (!f.loaded)
+        {
+            f.d = data(resource);
+        }
+        else if (f.regular)
+        {
+            f.d.tracking = true;
+            f.d.savedDevice = makedev(f.st.stx_dev_major, f.st.stx_dev_minor);
+            f.d.savedInode = f.st.stx_ino;
+            f.d.savedLength = f.d.count;
+        }
+        done(f.index, f.d, f.loaded);
+        f.d = data();
+        freeSlots.push_back(slot);
+        active--;
+    };
+    
+    auto finish = [&](uringFile &f, size_t slot) {
+        f.step = uringFile::closing;
+        io_uring_sqe *s = ring.next();
+        s->opcode = IORING_OP_CLOSE;
+        s->fd = f.fd;
+        s->user_data = slot;
+    };
+    
+    for (;;)
+    {
+        while (next < paths.size() && !freeSlots.empty())
+        {
+            size_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            uringFile &f = slots[slot];
+            f.index = next++;
+            f.step = uringFile::opening;
+            f.loaded = true;
+            f.regular = false;
+            f.d = data(resource);
+            f.d.filePath = paths[f.index];
+            
+            io_uring_sqe *s = ring.next();
+            s->opcode = IORING_OP_OPENAT;
+            s->fd = AT_FDCWD;
+            s->addr = reinterpret_cast<uint64_t>(paths[f.index].c_str());
+            s->open_flags = O_RDONLY | O_CLOEXEC;
+            s->user_data = slot;
+            active++;
+        }
+        
+        if (active == 0)
+            break;
+        if (!ring.submitAndWait())
+        {
+            // The files in flight start over on threads with those not started yet, once closing
+            // the ring cancelled what the kernel still had of them. Pipes go on from where they
+            // are, without the bytes already taken from them.
+            std::cout << "Error: Could not submit to io_uring, loading the remaining files on threads." << std::endl;
+            std::vector<bool> idle(slots.size(), false);
+            for (size_t slot : freeSlots)
+                idle[slot] = true;
+            ring.release();
+            
+            std::vector<size_t> indices;
+            for (size_t slot = 0; slot < slots.size(); slot++)
+            {
+                if (idle[slot])
+                    continue;
+                if (slots[slot].step == uringFile::statting || slots[slot].step == uringFile::reading)
+                    close(slots[slot].fd);
+                indices.push_back(slots[slot].index);
+            }
+            for (; next < paths.size(); next++)
+                indices.push_back(next);
+            
+            std::vector<std::string> left;
+            for (size_t i : indices)
+                left.push_back(paths[i]);
+            loadOnThreads(left, [&](size_t i, data &d, bool loaded) { done(indices[i], d, loaded); }, resource);
+            return true;
+        }
+        
+        io_uring_cqe c;
+        while (ring.reap(c))
+        {
+            size_t slot = static_cast<size_t>(c.user_data);
+            uringFile &f = slots[slot];
+            
+            // Reads interrupted before moving any byte are simply issued again.
+            if (f.step == uringFile::reading && (c.res == -EINTR || c.res == -EAGAIN))
+            {
+                read(f, slot);
+                continue;
+            }
+            
+            if (c.res < 0 && f.step != uringFile::closing)
+            {
+                std::cout << "Error: Could not read file: " << f.d.filePath << std::endl;
+                f.loaded = false;
+                if (f.step == uringFile::opening)
+                    deliver(f, slot);
+                else
+                    finish(f, slot);
+                continue;
+            }
+            
+            switch (f.step)
+            {
+                case uringFile::opening:
+                {
+                    f.fd = c.res;
+                    f.step = uringFile::statting;
+                    io_uring_sqe *s = ring.next();
+                    s->opcode = IORING_OP_STATX;
+                    s->fd = f.fd;
+                    s->addr = reinterpret_cast<uint64_t>("");
+                    s->len = STATX_TYPE | STATX_SIZE | STATX_INO;
+                    s->off = reinterpret_cast<uint64_t>(&f.st);
+                    s->statx_flags = AT_EMPTY_PATH;
+                    s->user_data = slot;
+                    break;
+                }
+                case uringFile::statting:
+                    // As in the constructor, empty regular files (such as those in /proc) are read
+                    // like pipes, until there is nothing left.
+                    f.regular = S_ISREG(f.st.stx_mode) && f.st.stx_size > 0;
+                    f.length = f.regular ? static_cast<size_t>(f.st.stx_size) : 0;
+                    f.step = uringFile::reading;
+                    f.d.resizeBuffer(f.regular ? f.length : 64 * 1024);
+                    read(f, slot);
+                    break;
+                case uringFile::reading:
+                    f.d.count += static_cast<size_t>(c.res);
+                    if (c.res == 0 || (f.regular && f.d.count == f.length))
+                        finish(f, slot);
+                    else
+                        read(f, slot);
+                    break;
+                case uringFile::closing:
+                    deliver(f, slot);
+                    break;
+            }
+        }
+    }
+    
+    return true;
+}
+
+void data::loadOnThreads(const std::vector<std::string> &paths, const loadCallback &done,
+                         std::pmr::memory_resource *resource)
+{
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < paths.size(); i = next++)
+        {
+            data d(resource);
+            int fd = open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) != 0)
+            {
+                if (fd >= 0)
+                    close(fd);
+                std::cout << "Error: Could not read file: " << paths[i] << std::endl;
+                done(i, d, false);
+                continue;
+            }
+            
+            d.filePath = paths[i];
+            bool regular = S_ISREG(st.st_mode) && st.st_size > 0;
+            d.readDescriptor(fd, regular ? static_cast<size_t>(st.st_size) : 0);
+            if (regular)
+                d.track(fd);
+            close(fd);
+            done(i, d, true);
+        }
+    };
+    
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < std::min<size_t>(loadThreads, paths.size()); t++)
+        pool.emplace_back(work);
+    work();
+    for (std::thread &t : pool)
+        t.join();
+}
+
+byte * data::streamSpace(size_t left, size_t &room)
+{
+    room = std::min(streamChunk, left);
+    
+    // A full overwriting ring is read into right over its oldest bytes, which follow the newest
+    // around the ring, so that only as many are dropped as arrive. Taken from the first copy of
+    // the ring, the room always lies within the mirror.
+    if (ring && ringOverwrite)
+    {
+        room = std::min(room, ringLength);
+        return ring + (bytes - ring + count) % ringLength;
+    }
+    
+    room = std::min(room, maxCapacity - count);
+    return room > 0 ? appendSpace(room) : nullptr;
+}
+
+void data::commitStream(size_t n)
+{
+    if (ring && ringOverwrite && n > maxCapacity - count)
+        popFront(n - (maxCapacity - count));
+    commitAppend(n);
+}
+
+void data::readParallel(int fd, size_t length)
+{
+    // Large owned buffers are page-aligned mappings; anything else skips O_DIRECT.
+    resizeBuffer(length);
+    bool aligned = reinterpret_cast<uintptr_t>(bytes) % directAlignment == 0;
+    int direct = ioDirect && aligned ? reopenDirect(fd, O_RDONLY) : -1;
+    
+    bool complete = forEachChunk(0, length, ioThreads, [&](size_t b, size_t e) {
+        return transferChunk(fd, direct, bytes, b, e, false);
+    });
+    
+    if (direct >= 0)
+        close(direct);
+    
+    // A file that changed while it was read is read again from the start, in one piece.
+    if (!complete)
+    {
+        lseek(fd, 0, SEEK_SET);
+        readDescriptor(fd, length);
+        return;
+    }
+    
+    count = length;
+}
+
+bool data::writeParallel(int fd, size_t begin, size_t end)
+{
+    bool aligned = reinterpret_cast<uintptr_t>(bytes) % directAlignment == 0;
+    int direct = ioDirect && aligned ? reopenDirect(fd, O_WRONLY) : -1;
+    
+    bool written = forEachChunk(begin, end, ioThreads, [&](size_t b, size_t e) {
+        return transferChunk(fd, direct, bytes, b, e, true);
+    });
+    
+    if (direct >= 0)
+        close(direct);
+    return written;
+}
@@ -0,0 +1,245 @@
+#include <cstring>
+#include <algorithm>
+#include "piecetable.h"
+
+/** Public Member Functions **/
+
+data::pieceTable::pieceTable(const byte *o, size_t length, std::pmr::memory_resource *r) : add(r)
+{
+    resource = r;
+    original = o;
+    seed = 2463534242u;
+    root = length > 0 ? makePiece(false, 0, length) : nullptr;
+}
+
+data::pieceTable::~pieceTable()
+{
+    destroy(root);
+}
+
+void data::pieceTable::rebase(const byte *o)
+{
+    original = o;
+}
+
+size_t data::pieceTable::size()
+{
+    return total(root);
+}
+
+size_t data::pieceTable::pieceCount()
+{
+    return countPieces(root);
+}
+
+byte data::pieceTable::at(size_t i)
+{
+    piece *t = root;
+    for (;;)
+    {
+        size_t leftTotal = total(t->left);
+        if (i < leftTotal)
+        {
+            t = t->left;
+        }
+        else if (i < leftTotal + t->length)
+        {
+            size_t offset = t->start + i - leftTotal;
+            return t->added ? add[offset] : original[offset];
+        }
+        else
+        {
+            i -= leftTotal + t->length;
+            t = t->right;
+        }
+    }
+}
+
+void data::pieceTable::copyTo(byte *dst, size_t i, size_t n)
+{
+    copyPieces(root, dst, i, n);
+}
+
+void data::pieceTable::insert(size_t i, const byte *b, size_t n)
+{
+    if (n == 0)
+        return;
+    
+    size_t start = add.size();
+    add.insert(add.end(), b, b + n);
+    
+    piece *a, *c;
+    split(root, i, a, c);
+    
+    // Consecutive inserts (typing, appending) grow the last add piece instead of adding nodes.
+    if (!extendLast(a, start, n))
+        a = merge(a, makePiece(true, start, n));
+    
+    root = merge(a, c);
+}
+
+void data::pieceTable::remove(size_t i, size_t n)
+{
+    piece *a, *rest, *mid, *c;
+    split(root, i, a, rest);
+    split(rest, n, mid, c);
+    destroy(mid);
+    root = merge(a, c);
+}
+
+/** Private Member Functions **/
+
+data::pieceTable::piece * data::pieceTable::makePiece(bool added, size_t start, size_t length)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    
+    piece *p = new (resource->allocate(sizeof(piece), alignof(piece))) piece;
+    p->added = added;
+    p->start = start;
+    p->length = length;
+    p->total = length;
+    p->priority = seed;
+    p->left = nullptr;
+    p->right = nullptr;
+    return p;
+}
+
+size_t data::pieceTable::total(piece *p)
+{
+    return p ? p->total : 0;
+}
+
+void data::pieceTable::update(piece *p)
+{
+    p->total = total(p->left) + p->length + total(p->right);
+}
+
+data::pieceTable::piece * data::pieceTable::merge(piece *a, piece *b)
+{
+    if (a == nullptr)
+        return b;
+    if (b == nullptr)
+        return a;
+    
+    if (a->priority > b->priority)
+    {
+        a->right = merge(a->right, b);
+        update(a);
+        return a;
+    }
+    
+    b->left = merge(a, b->left);
+    update(b);
+    return b;
+}
+
+void data::pieceTable::split(piece *t, size_t k, piece *&a, piece *&b)
+{
+    if (t == nullptr)
+    {
+        a = b = nullptr;
+        return;
+    }
+    
+    size_t leftTotal = total(t->left);
+    
+    if (k <= leftTotal)
+    {
+        split(t->left, k, a, t->left);
+        update(t);
+        b = t;
+    }
+    else if (k >= leftTotal + t->length)
+    {
+        split(t->right, k - leftTotal - t->length, t->right, b);
+        update(t);
+        a = t;
+    }
+    else
+    {
+        // k falls inside this piece, so it is cut in two.
+        size_t offset = k - leftTotal;
+        piece *tail = makePiece(t->added, t->start + offset, t->length - offset);
+        piece *right = t->right;
+        
+        t->length = offset;
+        t->right = nullptr;
+        update(t);
+        
+        a = t;
+        b = merge(tail, right);
+    }
+}
+
+void data::pieceTable::copyPieces(piece *t, byte *&dst, size_t &skip, size_t &n)
+{
+    if (t == nullptr || n == 0)
+        return;
+    
+    if (skip >= t->total)
+    {
+        skip -= t->total;
+        return;
+    }
+    
+    copyPieces(t->left, dst, skip, n);
+    
+    if (n > 0)
+    {
+        if (skip >= t->length)
+        {
+            skip -= t->length;
+        }
+        else
+        {
+            size_t amount = std::min(t->length - skip, n);
+            const byte *src = (t->added ? add.data() : original) + t->start + skip;
+            std::memcpy(dst, src, amount);
+            dst += amount;
+            n -= amount;
+            skip = 0;
+        }
+    }
+    
+    copyPieces(t->right, dst, skip, n);
+}
+
+bool data::pieceTable::extendLast(piece *t, size_t end, size_t n)
+{
+    if (t == nullptr)
+        return false;
+    
+    if (t->right)
+    {
+        if (!extendLast(t->right, end, n))
+            return false;
+    }
+    else if (!t->added || t->start + t->length != end)
+    {
+        return false;
+    }
+    else
+    {
+        t->length += n;
+    }
+    
+    t->total += n;
+    return true;
+}
+
+size_t data::pieceTable::countPieces(piece *t)
+{
+    return t ? countPieces(t->left) + 1 + countPieces(t->right) : 0;
+}
+
+void data::pieceTable::destroy(piece *t)
+{
+    if (t == nullptr)
+        return;
+    
+    destroy(t->left);
+    destroy(t->right);
+    resource->deallocate(t, sizeof(piece), alignof(piece));
+}
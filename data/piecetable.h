@@ -0,0 +1,80 @@
+#ifndef PIECETABLE_H
+#define PIECETABLE_H
+#include <memory_resource>
+#include <vector>
+#include "data.h"
+
+/** data::pieceTable declaration **/
+
+// A piece table over a read-only original buffer and an append-only add buffer. The pieces
+// are kept in a treap ordered by position and augmented with subtree lengths, so locating,
+// inserting and removing bytes costs O(log pieces) no matter how large the buffer is.
+
+class data::pieceTable {
+public:
+    pieceTable(const byte *original, size_t length, std::pmr::memory_resource *resource);
+    // Precondition: original must stay valid and unchanged for the lifetime of the table.
+    // Postcondition: Creates a table with a single piece spanning the original buffer. The pieces
+    //                and the add buffer are allocated from resource.
+    
+    ~pieceTable();
+    // Postcondition: Releases every piece.
+    
+    size_t size();
+    // Postcondition: Returns the logical amount of bytes.
+    
+    size_t pieceCount();
+    // Postcondition: Returns the amount of pieces in the table.
+    
+    byte at(size_t i);
+    // Precondition: i must be less than size().
+    // Postcondition: Returns the byte at logical position i.
+    
+    void copyTo(byte *dst, size_t i, size_t n);
+    // Precondition: i + n must not exceed size().
+    // Postcondition: Copies n logical bytes starting at i into dst.
+    
+    void insert(size_t i, const byte *b, size_t n);
+    // Precondition: i must not exceed size().
+    // Postcondition: Inserts n bytes at logical position i.
+    
+    void remove(size_t i, size_t n);
+    // Precondition: i + n must not exceed size().
+    // Postcondition: Removes n bytes starting at logical position i.
+    
+    void rebase(const byte *o);
+    // Precondition: o must hold the same bytes as the original buffer.
+    // Postcondition: Reads the original bytes from o from now on. Never throws.
+
+private:
+    struct piece {
+        bool added;         // True if the bytes live in the add buffer.
+        size_t start;       // Offset of the first byte in its buffer.
+        size_t length;      // Amount of bytes in this piece.
+        size_t total;       // Amount of bytes in this subtree.
+        unsigned priority;  // Heap priority of the treap.
+        piece *left;
+        piece *right;
+    };
+    
+    pieceTable(const pieceTable &);
+    pieceTable & operator=(const pieceTable &);
+    
+    piece *makePiece(bool added, size_t start, size_t length);
+    static size_t total(piece *p);
+    static void update(piece *p);
+    static piece *merge(piece *a, piece *b);
+    void split(piece *t, size_t k, piece *&a, piece *&b);
+    void copyPieces(piece *t, byte *&dst, size_t &skip, size_t &n);
+    static bool extendLast(piece *t, size_t end, size_t n);
+    static size_t countPieces(piece *t);
+    void destroy(piece *t);
+    
+    std::pmr::memory_resource *resource;    // Where pieces and the add buffer come from.
+    const byte *original;                   // The read-only original segment.
+    std::pmr::vector<byte> add;             // The append-only add buffer.
+    piece *root;                            // The root of the treap.
+    unsigned seed;                          // State of the priority generator.
+};
+
+#endif
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+#include "resource.h"
+
+// Chunks of an arena grow geometrically up to this size.
+static const size_t maxChunk = 64 * 1024 * 1024;
+
+// The smallest size class of a pool, and the least amount of bytes carved per slab.
+static const size_t smallestClass = 32;
+static const size_t slabSize = 64 * 1024;
+
+static inline size_t padding(const void *p, size_t alignment)
+{
+    return (alignment - reinterpret_cast<uintptr_t>(p) % alignment) % alignment;
+}
+
+/** arenaResource **/
+
+arenaResource::arenaResource(size_t chunkSize, std::pmr::memory_resource *u)
+{
+    upstream = u;
+    cursor = nullptr;
+    left = 0;
+    nextChunk = chunkSize > 0 ? chunkSize : 1;
+}
+
+arenaResource::~arenaResource()
+{
+    release();
+    if (!chunks.empty())
+        upstream->deallocate(chunks[0].first, chunks[0].second, alignof(std::max_align_t));
+}
+
+void arenaResource::release()
+{
+    if (chunks.empty())
+        return;
+    
+    // The largest chunk stays, so a request after the first one starts on warm memory.
+    std::vector<std::pair<void *, size_t>>::iterator largest = std::max_element(chunks.begin(), chunks.end(),
+        [](const std::pair<void *, size_t> &a, const std::pair<void *, size_t> &b) { return a.second < b.second; });
+    std::pair<void *, size_t> kept = *largest;
+    
+    for (const std::pair<void *, size_t> &c : chunks)
+        if (c.first != kept.first)
+            upstream->deallocate(c.first, c.second, alignof(std::max_align_t));
+    
+    chunks.assign(1, kept);
+    cursor = static_cast<char *>(kept.first);
+    left = kept.second;
+}
+
+size_t arenaResource::bytesReserved()
+{
+    size_t n = 0;
+    for (const std::pair<void *, size_t> &c : chunks)
+        n += c.second;
+    return n;
+}
+
+void * arenaResource::do_allocate(size_t bytes, size_t alignment)
+{
+    size_t pad = cursor ? padding(cursor, alignment) : 0;
+    
+    if (cursor == nullptr || pad + bytes > left)
+    {
+        size_t size = std::max(nextChunk, bytes + alignment);
+        void *c = upstream->allocate(size, alignof(std::max_align_t));
+        chunks.push_back(std::make_pair(c, size));
+        cursor = static_cast<char *>(c);
+        left = size;
+        nextChunk = std::max(nextChunk, std::min(nextChunk * 2, maxChunk));
+        pad = padding(cursor, alignment);
+    }
+    
+    char *p = cursor + pad;
+    cursor = p + bytes;
+    left -= pad + bytes;
+    return p;
+}
+
+void arenaResource::do_deallocate(void *p, size_t bytes, size_t)
+{
+    // Only the latest allocation can be given back, which is enough for a buffer that grows last.
+    if (static_cast<char *>(p) + bytes == cursor)
+    {
+        cursor = static_cast<char *>(p);
+        left += bytes;
+    }
+}
+
+bool arenaResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+/** poolResource **/
+
+poolResource::poolResource(size_t largestPooled, std::pmr::memory_resource *u)
+{
+    upstream = u;
+    largest = smallestClass;
+    while (largest < largestPooled)
+        largest *= 2;
+    freeLists.assign(classOf(largest) + 1, nullptr);
+}
+
+poolResource::~poolResource()
+{
+    release();
+}
+
+void poolResource::release()
+{
+    for (const std::pair<void *, size_t> &s : slabs)
+        upstream->deallocate(s.first, s.second, alignof(std::max_align_t));
+    slabs.clear();
+    std::fill(freeLists.begin(), freeLists.end(), nullptr);
+}
+
+void * poolResource::do_allocate(size_t bytes, size_t alignment)
+{
+    if (!pooled(bytes, alignment))
+        return upstream->allocate(bytes, alignment);
+    
+    size_t c = classOf(bytes);
+    if (freeLists[c] == nullptr)
+    {
+        size_t size = smallestClass << c;
+        size_t n = std::max(slabSize, 4 * size);
+        char *slab = static_cast<char *>(upstream->allocate(n, alignof(std::max_align_t)));
+        slabs.push_back(std::make_pair(static_cast<void *>(slab), n));
+        
+        // Blocks are linked back to front so they are handed out in address order.
+        for (size_t offset = n; offset >= size; offset -= size)
+        {
+            freeBlock *b = reinterpret_cast<freeBlock *>(slab + offset - size);
+            b->next = freeLists[c];
+            freeLists[c] = b;
+        }
+    }
+    
+    freeBlock *b = freeLists[c];
+    freeLists[c] = b->next;
+    return b;
+}
+
+void poolResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    if (!pooled(bytes, alignment))
+    {
+        upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+    
+    size_t c = classOf(bytes);
+    freeBlock *b = static_cast<freeBlock *>(p);
+    b->next = freeLists[c];
+    freeLists[c] = b;
+}
+
+bool poolResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+size_t poolResource::classOf(size_t bytes)
+{
+    if (bytes <= smallestClass)
+        return 0;
+    return 64 - __builtin_clzll(bytes - 1) - 5;
+}
+
+bool poolResource::pooled(size_t bytes, size_t alignment)
+{
+    return bytes <= largest && alignment <= alignof(std::max_align_t);
+}
+
+/** hugePageResource **/
+
+static inline size_t roundToHugePage(size_t n)
+{
+    return (n + hugePageResource::hugePageSize - 1) / hugePageResource::hugePageSize * hugePageResource::hugePageSize;
+}
+
+hugePageResource::hugePageResource(size_t t, std::pmr::memory_resource *u)
+{
+    upstream = u;
+    threshold = t;
+}
+
+void * hugePageResource::do_allocate(size_t bytes, size_t alignment)
+{
+    if (bytes < threshold)
+        return upstream->allocate(bytes, alignment);
+    
+    size_t length = roundToHugePage(bytes);
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    // Reserved huge pages are used when the system has any left.
+    void *reserved = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+    if (reserved != MAP_FAILED)
+        return reserved;
+#endif
+
+    // Transparent huge pages need a 2 MB aligned range, so the mapping is over-allocated and trimmed.
+    void *m = mmap(nullptr, length + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED)
+        throw std::bad_alloc();
+    
+    char *raw = static_cast<char *>(m);
+    size_t head = padding(raw, hugePageSize);
+    if (head > 0)
+        munmap(raw, head);
+    if (hugePageSize - head > 0)
+        munmap(raw + head + length, hugePageSize - head);
+
+#ifdef MADV_HUGEPAGE
+    madvise(raw + head, length, MADV_HUGEPAGE);
+#endif
+    return raw + head;
+}
+
+void hugePageResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    if (bytes < threshold)
+        upstream->deallocate(p, bytes, alignment);
+    else
+        munmap(p, roundToHugePage(bytes));
+}
+
+bool hugePageResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
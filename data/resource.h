@@ -0,0 +1,113 @@
+#ifndef RESOURCE_H
+#define RESOURCE_H
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+// Memory resources tuned for the buffers of data objects. Any std::pmr::memory_resource can be
+// passed to data; these cover the common cases. None of them is thread safe.
+
+/** arenaResource declaration **/
+
+// A monotonic arena for request-scoped work. Allocations bump a pointer through chunks taken from
+// the upstream resource and deallocations do nothing, so thousands of short-lived buffers cost a
+// few chunk allocations, all dropped at once by release() or the destructor.
+
+class arenaResource : public std::pmr::memory_resource {
+public:
+    arenaResource(size_t chunkSize = 64 * 1024, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+    // Postcondition: Creates an empty arena whose first chunk will hold chunkSize bytes.
+    
+    ~arenaResource();
+    // Postcondition: Returns every chunk to the upstream resource.
+    
+    void release();
+    // Postcondition: Makes every byte available again, keeping the largest chunk and returning the
+    //                others to the upstream resource. Buffers handed out before are invalid.
+    
+    size_t bytesReserved();
+    // Postcondition: Returns the amount of bytes held in chunks.
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+private:
+    arenaResource(const arenaResource &);
+    arenaResource & operator=(const arenaResource &);
+    
+    std::pmr::memory_resource *upstream;            // Where chunks come from.
+    std::vector<std::pair<void *, size_t>> chunks;  // Every chunk and its size.
+    char *cursor;                                   // The next free byte of the last chunk.
+    size_t left;                                    // The free bytes after cursor.
+    size_t nextChunk;                               // The size of the next chunk.
+};
+
+/** poolResource declaration **/
+
+// Size-class pools for byte buffers. Requests up to largestPooled bytes are rounded up to a power
+// of two (at least 32) and served from a free list per class, refilled from slabs taken from the
+// upstream resource. Larger requests go straight upstream.
+
+class poolResource : public std::pmr::memory_resource {
+public:
+    poolResource(size_t largestPooled = 64 * 1024, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+    // Postcondition: Creates empty pools for every class up to largestPooled bytes.
+    
+    ~poolResource();
+    // Postcondition: Releases every slab.
+    
+    void release();
+    // Postcondition: Returns every slab to the upstream resource. Pooled buffers handed out before are invalid.
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+private:
+    poolResource(const poolResource &);
+    poolResource & operator=(const poolResource &);
+    
+    struct freeBlock {
+        freeBlock *next;
+    };
+    
+    size_t classOf(size_t bytes);
+    // Postcondition: Returns the index of the smallest class holding the given amount of bytes.
+    
+    bool pooled(size_t bytes, size_t alignment);
+    // Postcondition: Returns true if such a request is served from the pools.
+    
+    std::pmr::memory_resource *upstream;            // Where slabs and large buffers come from.
+    std::vector<freeBlock *> freeLists;             // The free blocks of each class.
+    std::vector<std::pair<void *, size_t>> slabs;   // Every slab and its size.
+    size_t largest;                                 // The size of the largest class.
+};
+
+/** hugePageResource declaration **/
+
+// Backs buffers of at least threshold bytes with anonymous mappings aligned to and rounded up to
+// 2 MB, using reserved huge pages when there are any and transparent huge pages otherwise.
+// Smaller buffers go to the upstream resource.
+
+class hugePageResource : public std::pmr::memory_resource {
+public:
+    static const size_t hugePageSize = 2 * 1024 * 1024;
+    
+    hugePageResource(size_t threshold = hugePageSize, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+    // Postcondition: Creates a resource mapping huge pages for buffers of threshold bytes or more.
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+private:
+    std::pmr::memory_resource *upstream;    // Where small buffers come from.
+    size_t threshold;                       // The smallest buffer backed by huge pages.
+};
+
+#endif
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "ring.h"
+
+// Waiting threads spin this many times before going to sleep.
+static const int spinLimit = 64;
+
+/** Mirrored Memory **/
+
+size_t mirrorGranularity()
+{
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return page;
+}
+
+byte * mapMirrored(size_t n)
+{
+    if (n == 0 || n % mirrorGranularity() != 0)
+        return nullptr;
+    
+    int fd = memfd_create("data ring", MFD_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+    if (ftruncate(fd, n) != 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+    
+    // Reserve both halves at once, then map the same memory over each of them.
+    void *m = mmap(nullptr, 2 * n, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    byte *b = static_cast<byte *>(m);
+    if (m == MAP_FAILED ||
+        mmap(b, n, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(b + n, n, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        if (m != MAP_FAILED)
+            munmap(m, 2 * n);
+        close(fd);
+        return nullptr;
+    }
+    
+    close(fd);
+    return b;
+}
+
+void unmapMirrored(byte *b, size_t n)
+{
+    munmap(b, 2 * n);
+}
+
+/** ringBuffer **/
+
+ringBuffer::ringBuffer(size_t n) : head(0), headEvents(0), producerWaiting(0), tail(0), tailEvents(0),
+                                   consumerWaiting(0), finished(false)
+{
+    if (n == 0)
+    {
+        std::cout << "Fatal error: Attempted to set an invalid capacity." << std::endl;
+        exit(1);
+    }
+    
+    size_t page = mirrorGranularity();
+    length = (n + page - 1) / page * page;
+    ring = mapMirrored(length);
+    if (ring == nullptr)
+    {
+        std::cout << "Fatal error: Could not map a ring buffer of " << length << " bytes." << std::endl;
+        exit(1);
+    }
+}
+
+ringBuffer::~ringBuffer()
+{
+    unmapMirrored(ring, length);
+}
+
+size_t ringBuffer::capacity() const
+{
+    return length;
+}
+
+size_t ringBuffer::size() const
+{
+    uint64_t h = head.load(std::memory_order_acquire);
+    return static_cast<size_t>(tail.load(std::memory_order_acquire) - h);
+}
+
+/*** Producer ***/
+
+byte * ringBuffer::writeSpan(size_t &n)
+{
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    n = length - static_cast<size_t>(t - head.load(std::memory_order_acquire));
+    return ring + t % length;
+}
+
+void ringBuffer::commitWrite(size_t n)
+{
+    tail.store(tail.load(std::memory_order_relaxed) + n);
+    notify(tailEvents, consumerWaiting);
+}
+
+size_t ringBuffer::tryWrite(const byte *b, size_t n)
+{
+    size_t room;
+    byte *span = writeSpan(room);
+    n = std::min(n, room);
+    if (n == 0)
+        return 0;
+    std::memcpy(span, b, n);
+    commitWrite(n);
+    return n;
+}
+
+void ringBuffer::write(const byte *b, size_t n)
+{
+    while (n > 0)
+    {
+        size_t k = tryWrite(b, n);
+        b += k;
+        n -= k;
+        if (n > 0)
+            waitFor(headEvents, producerWaiting, true);
+    }
+}
+
+void ringBuffer::close()
+{
+    finished.store(true);
+    tailEvents.fetch_add(1);
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&tailEvents), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+/*** Consumer ***/
+
+data::view ringBuffer::readSpan()
+{
+    uint64_t h = head.load(std::memory_order_relaxed);
+    size_t n = static_cast<size_t>(tail.load(std::memory_order_acquire) - h);
+    return data::view(ring + h % length, n);
+}
+
+void ringBuffer::consume(size_t n)
+{
+    head.store(head.load(std::memory_order_relaxed) + n);
+    notify(headEvents, producerWaiting);
+}
+
+size_t ringBuffer::tryRead(byte *out, size_t n)
+{
+    data::view v = readSpan();
+    n = std::min(n, v.size());
+    if (n == 0)
+        return 0;
+    std::memcpy(out, v.begin(), n);
+    consume(n);
+    return n;
+}
+
+size_t ringBuffer::read(byte *out, size_t n)
+{
+    size_t done = 0;
+    while (done < n)
+    {
+        // Closing comes after the last write, so if it was closed before an empty read, it is over.
+        bool last = finished.load();
+        size_t k = tryRead(out + done, n - done);
+        done += k;
+        if (k == 0)
+        {
+            if (last)
+                break;
+            waitFor(tailEvents, consumerWaiting, false);
+        }
+    }
+    return done;
+}
+
+bool ringBuffer::closed() const
+{
+    return finished.load();
+}
+
+/** Private Member Functions **/
+
+void ringBuffer::waitFor(std::atomic<uint32_t> &events, std::atomic<uint32_t> &waiting, bool producer)
+{
+    auto ready = [&]() {
+        return producer ? size() < length : size() > 0 || finished.load();
+    };
+    
+    for (int i = 0; i < spinLimit; i++)
+    {
+        if (ready())
+            return;
+        std::this_thread::yield();
+    }
+    
+    // Announcing the wait before checking again pairs with the other side moving its position
+    // before checking for waiters: either this check sees the move, or the other side sees the
+    // announcement and changes events, which stops the futex from sleeping.
+    uint32_t e = events.load();
+    waiting.store(1);
+    if (!ready())
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&events), FUTEX_WAIT_PRIVATE, e, nullptr, nullptr, 0);
+    waiting.store(0);
+}
+
+void ringBuffer::notify(std::atomic<uint32_t> &events, std::atomic<uint32_t> &waiting)
+{
+    if (waiting.load() == 0)
+        return;
+    events.fetch_add(1);
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&events), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
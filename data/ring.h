@@ -0,0 +1,112 @@
+#ifndef RING_H
+#define RING_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "data.h"
+
+/** Mirrored Memory **/
+
+// A ring of n bytes mapped twice in a row, so that the byte at i + n is the byte at i. Any n
+// consecutive bytes starting in the first half are contiguous in memory, however they wrap, and
+// can be read or written with a single memcpy. Used by the ring buffer mode of data and by
+// ringBuffer.
+
+size_t mirrorGranularity();
+// Postcondition: Returns the size that the length of a mirrored ring must be a multiple of.
+
+byte * mapMirrored(size_t n);
+// Precondition: n must be a multiple of mirrorGranularity().
+// Postcondition: Returns 2n bytes of address space whose second half maps the same memory as the
+//                first, or nullptr if the system does not allow it.
+
+void unmapMirrored(byte *b, size_t n);
+// Postcondition: Releases a ring returned by mapMirrored(n).
+
+/** ringBuffer declaration **/
+
+// A lock-free single-producer, single-consumer byte queue for streaming between two threads,
+// such as a capture thread and the thread writing it out. The producer appends at the tail and
+// the consumer takes from the head; each side only writes its own position, so neither ever takes
+// a lock. Over the mirrored ring both sides get contiguous spans to write into and read from,
+// even where the bytes wrap around.
+//
+// Writing to a full buffer blocks (or, with tryWrite, writes what fits) and reading from an empty
+// one blocks until bytes arrive or the producer closes the buffer. Blocked threads sleep on a
+// futex, which the other side only touches when someone is waiting.
+
+class ringBuffer {
+public:
+    ringBuffer(size_t n);
+    // Precondition: n must be greater than 0.
+    // Postcondition: Creates an empty buffer holding at least n bytes, rounded up to a multiple of
+    //                mirrorGranularity().
+    
+    ~ringBuffer();
+    // Postcondition: Releases the ring.
+    
+    size_t capacity() const;
+    // Postcondition: Returns the amount of bytes the buffer holds.
+    
+    size_t size() const;
+    // Postcondition: Returns the amount of bytes waiting to be read, as seen when called.
+    
+    /*** Producer ***/
+    byte * writeSpan(size_t &n);
+    // Postcondition: Returns where the next bytes go and sets n to how many fit there right now.
+    
+    void commitWrite(size_t n);
+    // Precondition: n must not exceed the room last returned by writeSpan.
+    // Postcondition: Makes the n bytes written into the span available to the consumer.
+    
+    size_t tryWrite(const byte *b, size_t n);
+    // Postcondition: Writes as many of the n bytes of b as fit without waiting and returns how many.
+    
+    void write(const byte *b, size_t n);
+    // Postcondition: Writes the n bytes of b, waiting for the consumer to make room as needed.
+    
+    void close();
+    // Postcondition: Tells the consumer that nothing else will be written.
+    
+    /*** Consumer ***/
+    data::view readSpan();
+    // Postcondition: Returns a view of every byte waiting to be read, valid until they are consumed.
+    
+    void consume(size_t n);
+    // Precondition: n must not exceed the size of the last span returned by readSpan.
+    // Postcondition: Frees the first n waiting bytes for the producer.
+    
+    size_t tryRead(byte *out, size_t n);
+    // Postcondition: Reads up to n waiting bytes into out without waiting and returns how many.
+    
+    size_t read(byte *out, size_t n);
+    // Postcondition: Reads n bytes into out, waiting for the producer as needed. Returns fewer
+    //                only if the buffer was closed and ran out of bytes.
+    
+    bool closed() const;
+    // Postcondition: Returns true if the producer closed the buffer.
+
+private:
+    ringBuffer(const ringBuffer &);
+    ringBuffer & operator=(const ringBuffer &);
+    
+    void waitFor(std::atomic<uint32_t> &events, std::atomic<uint32_t> &waiting, bool producer);
+    // Postcondition: Sleeps until the other side moves (or closes), unless it already did.
+    
+    void notify(std::atomic<uint32_t> &events, std::atomic<uint32_t> &waiting);
+    // Postcondition: Wakes the other side if it is waiting.
+    
+    byte *ring;         // The mirrored ring.
+    size_t length;      // Its size.
+    
+    // Positions only grow; the byte at position p is at ring[p % length].
+    alignas(64) std::atomic<uint64_t> head;         // Bytes consumed, written by the consumer.
+    std::atomic<uint32_t> headEvents;               // Bumped when head moves while the producer waits.
+    std::atomic<uint32_t> producerWaiting;          // 1 while the producer waits for room.
+    alignas(64) std::atomic<uint64_t> tail;         // Bytes produced, written by the producer.
+    std::atomic<uint32_t> tailEvents;               // Bumped when tail moves while the consumer waits.
+    std::atomic<uint32_t> consumerWaiting;          // 1 while the consumer waits for bytes.
+    std::atomic<bool> finished;                     // Set by close.
+};
+
+#endif
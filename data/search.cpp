@@ -0,0 +1,496 @@
+#include <algorithm>
+#include <cstring>
+#include "search.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DATA_X86 1
+#else
+#define DATA_X86 0
+#endif
+
+// Single sequences are searched by filtering candidate positions 16 or 32 at a time: a position
+// is only compared in full if the bytes there and needle length - 1 further match the first and
+// last bytes of the needle. On inputs where that filter keeps failing (long runs of a repeated
+// byte, say) the forward search hands over to memmem, whose two-way algorithm is linear. Single
+// bytes go straight to memchr and memrchr.
+
+/** Vector Loops **/
+
+// The forward loops give up once this many candidates (plus one per 8 positions) failed.
+static const size_t falsePositiveAllowance = 4096;
+
+#if DATA_X86
+
+__attribute__((target("sse2")))
+static size_t forwardSSE2(const byte *h, size_t n, const byte *needle, size_t m, size_t &i)
+{
+    __m128i first = _mm_set1_epi8(static_cast<char>(needle[0]));
+    __m128i last = _mm_set1_epi8(static_cast<char>(needle[m - 1]));
+    size_t start = i;
+    size_t misses = 0;
+    
+    for (; i + m - 1 + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i + m - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        for (; mask != 0; mask &= mask - 1)
+        {
+            size_t p = i + __builtin_ctz(mask);
+            if (memcmp(h + p + 1, needle + 1, m - 2) == 0)
+                return p;
+            misses++;
+        }
+        if (misses > falsePositiveAllowance + (i - start) / 8)
+            break;
+    }
+    return data::notFound;
+}
+
+__attribute__((target("avx2")))
+static size_t forwardAVX2(const byte *h, size_t n, const byte *needle, size_t m, size_t &i)
+{
+    __m256i first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+    __m256i last = _mm256_set1_epi8(static_cast<char>(needle[m - 1]));
+    size_t start = i;
+    size_t misses = 0;
+    
+    for (; i + m - 1 + 32 <= n; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i + m - 1));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        for (; mask != 0; mask &= mask - 1)
+        {
+            size_t p = i + __builtin_ctz(mask);
+            if (memcmp(h + p + 1, needle + 1, m - 2) == 0)
+                return p;
+            misses++;
+        }
+        if (misses > falsePositiveAllowance + (i - start) / 8)
+            break;
+    }
+    return data::notFound;
+}
+
+// The backward loops check the candidates below i, highest first, and leave i at the lowest
+// candidate they did not check.
+
+__attribute__((target("sse2")))
+static size_t backwardSSE2(const byte *h, const byte *needle, size_t m, size_t &i)
+{
+    __m128i first = _mm_set1_epi8(static_cast<char>(needle[0]));
+    __m128i last = _mm_set1_epi8(static_cast<char>(needle[m - 1]));
+    
+    for (; i >= 16; i -= 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i - 16));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(h + i - 16 + m - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while (mask != 0)
+        {
+            unsigned bit = 31 - __builtin_clz(mask);
+            size_t p = i - 16 + bit;
+            if (memcmp(h + p + 1, needle + 1, m - 2) == 0)
+                return p;
+            mask ^= 1u << bit;
+        }
+    }
+    return data::notFound;
+}
+
+__attribute__((target("avx2")))
+static size_t backwardAVX2(const byte *h, const byte *needle, size_t m, size_t &i)
+{
+    __m256i first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+    __m256i last = _mm256_set1_epi8(static_cast<char>(needle[m - 1]));
+    
+    for (; i >= 32; i -= 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i - 32));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(h + i - 32 + m - 1));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        while (mask != 0)
+        {
+            unsigned bit = 31 - __builtin_clz(mask);
+            size_t p = i - 32 + bit;
+            if (memcmp(h + p + 1, needle + 1, m - 2) == 0)
+                return p;
+            mask ^= 1u << bit;
+        }
+    }
+    return data::notFound;
+}
+
+#endif
+
+/** Dispatch **/
+
+typedef size_t (*forwardLoop)(const byte *, size_t, const byte *, size_t, size_t &);
+typedef size_t (*backwardLoop)(const byte *, const byte *, size_t, size_t &);
+
+static size_t noForwardLoop(const byte *, size_t, const byte *, size_t, size_t &)
+{
+    return data::notFound;
+}
+
+static size_t noBackwardLoop(const byte *, const byte *, size_t, size_t &)
+{
+    return data::notFound;
+}
+
+struct searchLoops {
+    forwardLoop forward;
+    backwardLoop backward;
+    
+    searchLoops()
+    {
+        forward = noForwardLoop;
+        backward = noBackwardLoop;
+
+#if DATA_X86
+        if (__builtin_cpu_supports("avx2"))
+        {
+            forward = forwardAVX2;
+            backward = backwardAVX2;
+        }
+        else if (__builtin_cpu_supports("sse2"))
+        {
+            forward = forwardSSE2;
+            backward = backwardSSE2;
+        }
+#endif
+    }
+};
+
+static const searchLoops &loops()
+{
+    static const searchLoops selected;
+    return selected;
+}
+
+/** view Searching **/
+
+size_t data::view::find(view needle, size_t from) const
+{
+    size_t m = needle.size();
+    if (from > length || m > length - from)
+        return notFound;
+    if (m == 0)
+        return from;
+    
+    const byte *h = first;
+    const byte *nd = needle.begin();
+    if (m == 1)
+    {
+        const void *p = memchr(h + from, nd[0], length - from);
+        return p ? static_cast<const byte *>(p) - h : notFound;
+    }
+    
+    size_t i = from;
+    size_t p = loops().forward(h, length, nd, m, i);
+    if (p != notFound)
+        return p;
+    
+    // The tail, or the rest of an input the filter did badly on.
+    const void *q = memmem(h + i, length - i, nd, m);
+    return q ? static_cast<const byte *>(q) - h : notFound;
+}
+
+size_t data::view::rfind(view needle, size_t before) const
+{
+    size_t m = needle.size();
+    if (m > length)
+        return notFound;
+    
+    // The candidates are the positions below i.
+    size_t i = std::min(before, length - m) + 1;
+    if (m == 0)
+        return i - 1;
+    
+    const byte *h = first;
+    const byte *nd = needle.begin();
+    if (m == 1)
+    {
+        const void *p = memrchr(h, nd[0], i);
+        return p ? static_cast<const byte *>(p) - h : notFound;
+    }
+    
+    size_t p = loops().backward(h, nd, m, i);
+    if (p != notFound)
+        return p;
+    
+    while (i > 0)
+    {
+        const void *q = memrchr(h, nd[0], i);
+        if (q == nullptr)
+            break;
+        p = static_cast<const byte *>(q) - h;
+        if (memcmp(h + p + 1, nd + 1, m - 1) == 0)
+            return p;
+        i = p;
+    }
+    return notFound;
+}
+
+/** data Member Functions **/
+
+size_t data::find(const byte *needle, size_t n, size_t from)
+{
+    return viewAll().find(view(needle, n), from);
+}
+
+size_t data::rfind(const byte *needle, size_t n, size_t before)
+{
+    return viewAll().rfind(view(needle, n), before);
+}
+
+std::vector<size_t> data::findAll(const byte *needle, size_t n)
+{
+    std::vector<size_t> found;
+    if (n == 0)
+        return found;
+    
+    view all = viewAll();
+    for (size_t i = all.find(view(needle, n)); i != notFound; i = all.find(view(needle, n), i + 1))
+        found.push_back(i);
+    return found;
+}
+
+size_t data::countOf(const byte *needle, size_t n)
+{
+    if (n == 0)
+        return 0;
+    
+    view all = viewAll();
+    size_t found = 0;
+    for (size_t i = all.find(view(needle, n)); i != notFound; i = all.find(view(needle, n), i + 1))
+        found++;
+    return found;
+}
+
+/** patternScanner **/
+
+patternScanner::patternScanner()
+{
+    compiled = false;
+    classCount = 1;
+    shallowRows = 0;
+    onlyStart = -1;
+    std::fill(classes, classes + 256, 0);
+    std::fill(prefixes, prefixes + 1024, 0);
+}
+
+size_t patternScanner::addPattern(const byte *b, size_t n)
+{
+    if (n == 0)
+    {
+        std::cout << "Fatal error: Patterns can not be empty." << std::endl;
+        exit(1);
+    }
+    
+    patterns.emplace_back(b, b + n);
+    compiled = false;
+    return patterns.size() - 1;
+}
+
+size_t patternScanner::addPattern(const std::string &s)
+{
+    return addPattern(reinterpret_cast<const byte *>(s.data()), s.size());
+}
+
+size_t patternScanner::patternCount()
+{
+    return patterns.size();
+}
+
+size_t patternScanner::patternLength(size_t id)
+{
+    return patterns[id].size();
+}
+
+void patternScanner::compile()
+{
+    static const uint32_t none = UINT32_MAX;
+    
+    // Bytes that no pattern uses share class 0, so rows only need a column per byte in use.
+    bool used[256] = {};
+    for (const std::vector<byte> &p : patterns)
+        for (byte b : p)
+            used[b] = true;
+    size_t distinct = std::count(used, used + 256, true);
+    classCount = distinct == 256 ? 256 : distinct + 1;
+    size_t next = distinct == 256 ? 0 : 1;
+    for (size_t v = 0; v < 256; v++)
+        classes[v] = used[v] ? static_cast<uint8_t>(next++) : 0;
+    
+    // The trie, with states numbered in creation order.
+    std::vector<uint32_t> go(classCount, none);
+    std::vector<std::vector<uint32_t>> ends(1);
+    for (size_t id = 0; id < patterns.size(); id++)
+    {
+        uint32_t s = 0;
+        for (byte b : patterns[id])
+        {
+            size_t t = s * classCount + classes[b];
+            if (go[t] == none)
+            {
+                go[t] = static_cast<uint32_t>(ends.size());
+                go.resize(go.size() + classCount, none);
+                ends.emplace_back();
+            }
+            s = go[t];
+        }
+        ends[s].push_back(static_cast<uint32_t>(id));
+    }
+    
+    size_t states = ends.size();
+    if (states * classCount >= reports)
+    {
+        std::cout << "Fatal error: Too many patterns to compile." << std::endl;
+        exit(1);
+    }
+    
+    // Breadth first, every state takes the reports of its failure state and the missing
+    // transitions become the ones of the failure state, turning the trie into a DFA.
+    std::vector<uint32_t> fail(states, 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(states);
+    for (size_t c = 0; c < classCount; c++)
+    {
+        if (go[c] == none)
+            go[c] = 0;
+        else
+            queue.push_back(go[c]);
+    }
+    size_t depthOne = queue.size();
+    
+    for (size_t q = 0; q < queue.size(); q++)
+    {
+        uint32_t s = queue[q];
+        std::vector<uint32_t> &e = ends[s];
+        e.insert(e.end(), ends[fail[s]].begin(), ends[fail[s]].end());
+        std::sort(e.begin(), e.end());
+        
+        for (size_t c = 0; c < classCount; c++)
+        {
+            uint32_t &t = go[s * classCount + c];
+            uint32_t f = go[fail[s] * classCount + c];
+            if (t == none)
+                t = f;
+            else
+            {
+                fail[t] = f;
+                queue.push_back(t);
+            }
+        }
+    }
+    
+    // States are renumbered breadth first, which keeps the rows of shallow states (where scans
+    // spend most of their time) together, and puts the ones at depth 1 right after the root.
+    std::vector<uint32_t> renumbered(states, 0);
+    for (size_t q = 0; q < queue.size(); q++)
+        renumbered[queue[q]] = static_cast<uint32_t>(q + 1);
+    shallowRows = static_cast<uint32_t>(depthOne * classCount);
+    
+    table.resize(go.size());
+    for (size_t s = 0; s < states; s++)
+        for (size_t c = 0; c < classCount; c++)
+        {
+            uint32_t t = go[s * classCount + c];
+            table[renumbered[s] * classCount + c] = static_cast<uint32_t>(renumbered[t] * classCount) | (ends[t].empty() ? 0 : reports);
+        }
+    
+    outputs.clear();
+    outputStart.assign(1, 0);
+    for (size_t q = 0; q <= queue.size(); q++)
+    {
+        const std::vector<uint32_t> &e = ends[q == 0 ? 0 : queue[q - 1]];
+        outputs.insert(outputs.end(), e.begin(), e.end());
+        outputStart.push_back(static_cast<uint32_t>(outputs.size()));
+    }
+    
+    // A single byte pattern can start a match before any byte.
+    bool starts[256] = {};
+    std::fill(prefixes, prefixes + 1024, 0);
+    for (const std::vector<byte> &p : patterns)
+    {
+        starts[p[0]] = true;
+        for (size_t b = 0; b < 256; b++)
+            if (p.size() == 1 || p[1] == b)
+                prefixes[p[0] * 4 + b / 64] |= uint64_t(1) << (b % 64);
+    }
+    onlyStart = std::count(starts, starts + 256, true) == 1 ? static_cast<int>(std::find(starts, starts + 256, true) - starts) : -1;
+    
+    compiled = true;
+}
+
+template <class F>
+void patternScanner::run(data::view v, F found)
+{
+    if (!compiled)
+        compile();
+    if (patterns.empty())
+        return;
+    
+    const byte *begin = v.begin();
+    const byte *end = v.end();
+    const uint32_t *t = table.data();
+    uint32_t s = 0;
+    
+    for (const byte *p = begin; p < end; p++)
+    {
+        // Nothing is partially matched, so skip to the next position where a match can start.
+        // The last byte is left to the table.
+        if (s == 0)
+        {
+            if (onlyStart >= 0)
+                p = static_cast<const byte *>(memchr(p, onlyStart, end - p));
+            else
+                while (p + 1 < end && !(prefixes[p[0] * 4 + p[1] / 64] >> (p[1] % 64) & 1))
+                    p++;
+            if (p == nullptr)
+                return;
+        }
+        
+        s = t[s + classes[*p]];
+        if (s & reports)
+        {
+            s ^= reports;
+            size_t state = s / classCount;
+            for (uint32_t o = outputStart[state]; o < outputStart[state + 1]; o++)
+                found(static_cast<size_t>(p - begin), outputs[o]);
+        }
+        
+        // At depth 1 only this byte is matched; if no match starts with it and the next byte,
+        // the next byte leads where it would from the root, so the skip above applies again.
+        if (s <= shallowRows && p + 1 < end && !(prefixes[p[0] * 4 + p[1] / 64] >> (p[1] % 64) & 1))
+            s = 0;
+    }
+}
+
+void patternScanner::scan(data::view v, const std::function<void(const match &)> &found)
+{
+    run(v, [&](size_t last, uint32_t id) {
+        match m = {last + 1 - patterns[id].size(), id};
+        found(m);
+    });
+}
+
+std::vector<patternScanner::match> patternScanner::scan(data::view v)
+{
+    std::vector<match> matches;
+    run(v, [&](size_t last, uint32_t id) {
+        match m = {last + 1 - patterns[id].size(), id};
+        matches.push_back(m);
+    });
+    return matches;
+}
+
+size_t patternScanner::countMatches(data::view v)
+{
+    size_t n = 0;
+    run(v, [&](size_t, uint32_t) { n++; });
+    return n;
+}
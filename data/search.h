@@ -0,0 +1,75 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+#include <functional>
+#include <string>
+#include <vector>
+#include "data.h"
+
+// Single sequences are searched with data::find and friends (and view::find). This header adds
+// a scanner for many sequences at once.
+
+/** patternScanner declaration **/
+
+// Finds every occurrence of any of a set of byte patterns in a single pass, with an Aho-Corasick
+// automaton compiled into a dense transition table over the byte classes the patterns use. While
+// no pattern is partially matched, positions where no match can start are skipped without
+// touching the table: with memchr when every pattern starts with the same byte, otherwise by
+// looking up the next two bytes in a bitmap of the pairs that start a pattern.
+
+class patternScanner {
+public:
+    struct match {
+        size_t offset;      // The index of the first matched byte.
+        size_t pattern;     // The id of the matched pattern.
+    };
+    
+    patternScanner();
+    
+    size_t addPattern(const byte *b, size_t n);
+    // Precondition: n must be greater than 0.
+    // Postcondition: Adds a pattern and returns its id, which counts up from 0.
+    
+    size_t addPattern(const std::string &s);
+    // Postcondition: Same as above for the bytes of s.
+    
+    size_t patternCount();
+    // Postcondition: Returns the amount of patterns added.
+    
+    size_t patternLength(size_t id);
+    // Postcondition: Returns the length of the pattern with the given id.
+    
+    void compile();
+    // Postcondition: Builds the automaton for the patterns added so far. The scans call it when
+    //                patterns were added since the last build.
+    
+    void scan(data::view v, const std::function<void(const match &)> &found);
+    // Postcondition: Calls found for every occurrence of every pattern, overlapping ones included,
+    //                in the order they end (and by id for the ones ending at the same byte).
+    
+    std::vector<match> scan(data::view v);
+    // Postcondition: Returns every occurrence, in the same order.
+    
+    size_t countMatches(data::view v);
+    // Postcondition: Returns the amount of occurrences.
+
+private:
+    static const uint32_t reports = 0x80000000;  // Set in the transitions to states that end a pattern.
+    
+    template <class F>
+    void run(data::view v, F found);
+    // Postcondition: Drives the automaton over the bytes, calling found(end, pattern) for matches.
+    
+    std::vector<std::vector<byte>> patterns;    // Every pattern, by id.
+    bool compiled;                              // True if the automaton covers every pattern.
+    
+    uint8_t classes[256];               // The class of every byte value; 0 for bytes no pattern uses.
+    size_t classCount;                  // The amount of classes.
+    std::vector<uint32_t> table;        // The next row offset for every row and class, with reports set.
+    uint32_t shallowRows;               // The largest row offset of a state at depth 1.
+    std::vector<uint32_t> outputs;      // The ids reported by every state, sorted per state.
+    std::vector<uint32_t> outputStart;  // Where the ids of each state start in outputs.
+    uint64_t prefixes[1024];            // A bit for every pair of bytes that can start a match.
+    int onlyStart;                      // The single byte starting every pattern, or -1.
+};
+
+#endif
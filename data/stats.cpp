@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include "stats.h"
+
+/** Process-wide Totals **/
+
+namespace {
+
+struct processCounters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytesAllocated{0};
+    std::atomic<uint64_t> reallocations{0};
+    std::atomic<uint64_t> bytesCopied{0};
+    std::atomic<uint64_t> peakCapacity{0};
+    std::atomic<uint64_t> calls[dataStats::operations] = {};
+    std::atomic<uint64_t> nanoseconds[dataStats::operations] = {};
+    std::atomic<uint64_t> latency[dataStats::operations][dataStats::buckets] = {};
+};
+
+processCounters totals;
+
+void add(std::atomic<uint64_t> &counter, uint64_t n)
+{
+    counter.fetch_add(n, std::memory_order_relaxed);
+}
+
+void raise(std::atomic<uint64_t> &peak, uint64_t n)
+{
+    uint64_t current = peak.load(std::memory_order_relaxed);
+    while (n > current && !peak.compare_exchange_weak(current, n, std::memory_order_relaxed))
+        ;
+}
+
+#if DATA_STATS
+// Writes the totals into the file named by DATA_STATS_DUMP when the process exits.
+struct exitDump {
+    exitDump()
+    {
+        if (std::getenv("DATA_STATS_DUMP"))
+            std::atexit([]() {
+                std::ofstream out(std::getenv("DATA_STATS_DUMP"));
+                dataStats::dumpProcess(out);
+            });
+    }
+} dumpAtExit;
+#endif
+
+}
+
+/** dataStats **/
+
+dataStats::timer::timer(dataStats &s, operation op) : stats(s), op(op), start(std::chrono::steady_clock::now())
+{
+}
+
+dataStats::timer::~timer()
+{
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    stats.recordLatency(op, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+const char * dataStats::operationName(operation op)
+{
+    static const char *names[operations] = {
+        "load", "save", "copy", "append", "prepend", "insert", "override", "remove", "applyEdits",
+        "compress", "decompress"
+    };
+    return names[op];
+}
+
+size_t dataStats::bucketOf(uint64_t ns)
+{
+    size_t k = 63 - __builtin_clzll(ns | 1);
+    return k < buckets ? k : buckets - 1;
+}
+
+void dataStats::recordAllocation(size_t n)
+{
+    allocations++;
+    bytesAllocated += n;
+    peakCapacity = std::max<uint64_t>(peakCapacity, n);
+    add(totals.allocations, 1);
+    add(totals.bytesAllocated, n);
+    raise(totals.peakCapacity, n);
+}
+
+void dataStats::recordReallocation(size_t n)
+{
+    reallocations++;
+    peakCapacity = std::max<uint64_t>(peakCapacity, n);
+    add(totals.reallocations, 1);
+    raise(totals.peakCapacity, n);
+}
+
+void dataStats::recordCopy(size_t n)
+{
+    bytesCopied += n;
+    add(totals.bytesCopied, n);
+}
+
+void dataStats::recordLatency(operation op, uint64_t ns)
+{
+    size_t k = bucketOf(ns);
+    calls[op]++;
+    nanoseconds[op] += ns;
+    latency[op][k]++;
+    add(totals.calls[op], 1);
+    add(totals.nanoseconds[op], ns);
+    add(totals.latency[op][k], 1);
+}
+
+void dataStats::reset()
+{
+    *this = dataStats();
+}
+
+void dataStats::dump(std::ostream &out, const std::string &labels) const
+{
+    std::string plain = labels.empty() ? "" : "{" + labels + "}";
+    std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+    
+    out << "# TYPE data_allocations_total counter\n" << "data_allocations_total" << plain << " " << allocations << "\n";
+    out << "# TYPE data_allocated_bytes_total counter\n" << "data_allocated_bytes_total" << plain << " " << bytesAllocated << "\n";
+    out << "# TYPE data_reallocations_total counter\n" << "data_reallocations_total" << plain << " " << reallocations << "\n";
+    out << "# TYPE data_copied_bytes_total counter\n" << "data_copied_bytes_total" << plain << " " << bytesCopied << "\n";
+    out << "# TYPE data_peak_capacity_bytes gauge\n" << "data_peak_capacity_bytes" << plain << " " << peakCapacity << "\n";
+    
+    out << "# TYPE data_operation_latency_nanoseconds histogram\n";
+    for (size_t op = 0; op < operations; op++)
+    {
+        if (calls[op] == 0)
+            continue;
+        std::string name = prefix + "operation=\"" + operationName(static_cast<operation>(op)) + "\"";
+        uint64_t cumulative = 0;
+        for (size_t k = 0; k + 1 < buckets; k++)
+        {
+            cumulative += latency[op][k];
+            out << "data_operation_latency_nanoseconds_bucket" << name << ",le=\"" << ((uint64_t(2) << k) - 1)
+                << "\"} " << cumulative << "\n";
+        }
+        out << "data_operation_latency_nanoseconds_bucket" << name << ",le=\"+Inf\"} " << calls[op] << "\n";
+        out << "data_operation_latency_nanoseconds_sum" << name << "} " << nanoseconds[op] << "\n";
+        out << "data_operation_latency_nanoseconds_count" << name << "} " << calls[op] << "\n";
+    }
+    out.flush();
+}
+
+dataStats dataStats::process()
+{
+    dataStats s;
+    s.allocations = totals.allocations.load(std::memory_order_relaxed);
+    s.bytesAllocated = totals.bytesAllocated.load(std::memory_order_relaxed);
+    s.reallocations = totals.reallocations.load(std::memory_order_relaxed);
+    s.bytesCopied = totals.bytesCopied.load(std::memory_order_relaxed);
+    s.peakCapacity = totals.peakCapacity.load(std::memory_order_relaxed);
+    for (size_t op = 0; op < operations; op++)
+    {
+        s.calls[op] = totals.calls[op].load(std::memory_order_relaxed);
+        s.nanoseconds[op] = totals.nanoseconds[op].load(std::memory_order_relaxed);
+        for (size_t k = 0; k < buckets; k++)
+            s.latency[op][k] = totals.latency[op][k].load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+void dataStats::resetProcess()
+{
+    totals.allocations = 0;
+    totals.bytesAllocated = 0;
+    totals.reallocations = 0;
+    totals.bytesCopied = 0;
+    totals.peakCapacity = 0;
+    for (size_t op = 0; op < operations; op++)
+    {
+        totals.calls[op] = 0;
+        totals.nanoseconds[op] = 0;
+        for (size_t k = 0; k < buckets; k++)
+            totals.latency[op][k] = 0;
+    }
+}
+
+void dataStats::dumpProcess(std::ostream &out)
+{
+    process().dump(out);
+}
@@ -0,0 +1,111 @@
+#ifndef STATS_H
+#define STATS_H
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Opt-in instrumentation of data objects. Building with DATA_STATS=1 (the CPP_UTILS_DATA_STATS
+// CMake option) gives every data object a dataStats member counting its allocations, the bytes
+// it copies behind the scenes (growing, detaching, shifting bytes for an edit) and the latency of
+// its operations, and adds every event to process-wide totals. Without it the hooks in data.cpp
+// compile to nothing and data objects carry no extra state.
+//
+// The process-wide totals are relaxed atomic counters; per-object counters are as thread safe as
+// the object itself.
+
+#ifndef DATA_STATS
+#define DATA_STATS 0
+#endif
+
+#if DATA_STATS
+#define DATA_STATS_ONLY(statement) statement
+#else
+#define DATA_STATS_ONLY(statement)
+#endif
+
+// Times the rest of the enclosing block as one operation of the object.
+#define DATA_STATS_TIME(op) DATA_STATS_ONLY(dataStats::timer statsTimer(stats, dataStats::op))
+
+/** dataStats declaration **/
+
+struct dataStats {
+    enum operation {
+        loadOp,         // Loading a file.
+        saveOp,         // Saving to a file.
+        copyOp,         // Copying another object.
+        appendOp,       // appendByte.
+        prependOp,      // prependByte.
+        insertOp,       // insertBytes.
+        overrideOp,     // overrideBytes.
+        removeOp,       // removeByteAt and removeBytesIn.
+        applyEditsOp,   // applyEdits.
+        compressOp,     // compress.
+        decompressOp,   // decompress, and whatever decompresses.
+        operations
+    };
+    
+    // Latencies are counted in buckets of powers of two: bucket k holds those of 2^k up to
+    // 2^(k+1) - 1 nanoseconds, and the last bucket everything longer.
+    static const size_t buckets = 40;
+    
+    class timer {
+    public:
+        timer(dataStats &s, operation op);
+        ~timer();
+        // Postcondition: Records the time elapsed since construction as one call of op.
+    
+    private:
+        dataStats &stats;
+        operation op;
+        std::chrono::steady_clock::time_point start;
+    };
+    
+    uint64_t allocations = 0;       // Buffers taken from the memory resource.
+    uint64_t bytesAllocated = 0;    // Their total size.
+    uint64_t reallocations = 0;     // Times the buffer was grown or shrunk.
+    uint64_t bytesCopied = 0;       // Bytes of content copied or shifted within the object.
+    uint64_t peakCapacity = 0;      // The largest buffer held (by any object, process-wide).
+    uint64_t calls[operations] = {};                // Calls of every operation.
+    uint64_t nanoseconds[operations] = {};          // Their total latency.
+    uint64_t latency[operations][buckets] = {};     // Their latency histograms.
+    
+    static const char *operationName(operation op);
+    // Postcondition: Returns the name of op, as used in dumps.
+    
+    static size_t bucketOf(uint64_t ns);
+    // Postcondition: Returns the latency bucket of ns nanoseconds.
+    
+    void recordAllocation(size_t n);
+    // Postcondition: Counts a new buffer of n bytes, here and process-wide.
+    
+    void recordReallocation(size_t n);
+    // Postcondition: Counts a change of the buffer to n bytes, here and process-wide.
+    
+    void recordCopy(size_t n);
+    // Postcondition: Counts n bytes copied, here and process-wide.
+    
+    void recordLatency(operation op, uint64_t ns);
+    // Postcondition: Counts a call of op taking ns nanoseconds, here and process-wide.
+    
+    void reset();
+    // Postcondition: Sets every counter of this object to 0.
+    
+    void dump(std::ostream &out, const std::string &labels = "") const;
+    // Postcondition: Writes the counters in the Prometheus text format, every metric carrying the
+    //                given labels (such as object="cache").
+    
+    static dataStats process();
+    // Postcondition: Returns the totals of every data object since the start (or the last reset).
+    
+    static void resetProcess();
+    // Postcondition: Sets the process-wide totals to 0.
+    
+    static void dumpProcess(std::ostream &out);
+    // Postcondition: Writes the process-wide totals in the Prometheus text format. When the
+    //                DATA_STATS_DUMP environment variable names a file, this also happens into that
+    //                file when the process exits.
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include "check.h"
+#include "../hash.h"
+
+// What the demo prints, checked: byte editing, capacities, piece table saves and the hashes of
+// photo.jpeg, whose expected values come from sha256sum and the reference implementations. Then the
+// standard algorithms over its bytes, through begin() and end().
+
+void testBasics()
+{
+    // Editing
+    byte b1[] = {5, 99, 255, 33, 42, 65, 33};
+    data d(b1, 7);
+    CHECK(d.hexDigest() == "0563ff212a4121");
+    CHECK(d.digest() == std::string("\x05\x63\xff\x21\x2a\x41\x21", 7));
+    
+    byte b2[] = {5, 8, 12};
+    d.insertBytes(b2, 3, 4);
+    CHECK(holds(d, {5, 99, 255, 33, 5, 8, 12, 42, 65, 33}));
+    
+    data::range r(2, 5);
+    byte *copied = d.bytesInRange(r);
+    CHECK(copied[0] == 255 && copied[1] == 33 && copied[2] == 5 && copied[3] == 8);
+    byte inRange[] = {255, 33, 5, 8};
+    CHECK(d.viewInRange(r) == data::view(inRange, 4));
+    delete [] copied;
+    
+    byte b3[] = {11, 33, 22, 55, 44};
+    d.overrideBytes(b3, 5, r);
+    CHECK(holds(d, {5, 99, 11, 33, 22, 55, 44, 12, 42, 65, 33}));
+    
+    byte b;
+    CHECK(d.at(10, b) && b == 33);
+    CHECK(!d.at(11, b));
+    
+    // Capacities
+    data limited(10);
+    CHECK(limited.bufferCapacity() == 10);
+    byte b4[] = {5, 7, 3, 6};
+    byte b5[] = {8, 145, 234, 22, 0, 1};
+    limited.insertBytes(b4, 4, 0);
+    limited.insertBytes(b5, 6, limited.size());
+    CHECK(holds(limited, {5, 7, 3, 6, 8, 145, 234, 22, 0, 1}));
+    limited.appendByte(3);
+    limited.prependByte(3);
+    CHECK(limited.size() == 10);
+    
+    limited.removeByteAt(3);
+    limited.removeByteAt(4);
+    limited.removeBytesIn(data::range(0, 3));
+    CHECK(holds(limited, {234, 22, 0, 1}));
+    limited.appendByte(55);
+    limited.appendByte(66);
+    limited.appendByte(77);
+    limited.setCapacity(5);
+    CHECK(limited.bufferCapacity() == 5);
+    CHECK(holds(limited, {234, 22, 0, 1, 55}));
+    limited.appendByte(3);
+    CHECK(limited.size() == 5);
+    
+    // Piece table saves
+    std::string photo = readFile("photo.jpeg");
+    CHECK(photo.size() == 479789);
+    std::string loaded = scratchPath("piece_loaded.jpeg");
+    std::string saved = scratchPath("piece_saved.jpeg");
+    writeFile(loaded, photo);
+    
+    data pieces(loaded);
+    pieces.usePieceTable(true);
+    byte b6[] = {0xFF, 0xFE, 0x00, 0x04};
+    pieces.insertBytes(b6, 4, 2);
+    pieces.removeBytesIn(data::range(6, 7));
+    std::string expected = photo.substr(0, 2) + std::string("\xFF\xFE\x00\x04", 4) + photo.substr(4);
+    CHECK(pieces.isMapped());
+    CHECK(pieces.size() == expected.size());
+    pieces.saveToPath(saved);
+    CHECK(readFile(saved) == expected);
+    
+    // A byte changed behind its back survives a save that only writes the overridden bytes.
+    size_t far = expected.size() - 10;
+    expected[far] = static_cast<char>(~expected[far]);
+    writeFile(saved, expected);
+    byte b7[] = {0xFF, 0xD9};
+    data::range r4(2, 3);
+    pieces.overrideBytes(b7, 2, r4);
+    pieces.save();
+    expected[2] = static_cast<char>(0xFF);
+    expected[3] = static_cast<char>(0xD9);
+    CHECK(readFile(saved) == expected);
+    
+    // A copy does not share what its original knows about the file, so neither save loses the other's.
+    writeFile(saved, photo);
+    data original(saved);
+    data copy(original);
+    byte b8[] = {1, 2};
+    data::range r5(0, 1);
+    original.overrideBytes(b8, 2, r5);
+    original.save();
+    data::range r6(50, 51);
+    copy.overrideBytes(b8, 2, r6);
+    copy.save();
+    CHECK(readFile(saved) == copy.digest());
+    std::remove(loaded.c_str());
+    std::remove(saved.c_str());
+    
+    // Hashes
+    data hashed("photo.jpeg");
+    CHECK(hashed.crc32c() == 0x9e7cfb82);
+    CHECK(hashed.xxh64() == 0x5b50968d6414462dULL);
+    CHECK(hashed.xxh3() == 0xe228517ad81ee0b8ULL);
+    CHECK(hashed.sha256() == "484124656d8bdee3684e03252e69e5957659793aad532254c4c7fc4b9817c8e3");
+    CHECK(treeHash<xxh3Hasher>(hashed.viewAll(), 64 * 1024, 1) == treeHash<xxh3Hasher>(hashed.viewAll(), 64 * 1024, 4));
+    
+    // Iterators
+    const byte jfif[] = {0xFF, 0xE0};
+    const byte *marker = std::search(hashed.begin(), hashed.end(), jfif, jfif + 2);
+    CHECK(static_cast<size_t>(marker - hashed.begin()) == photo.find("\xFF\xE0"));
+    CHECK(std::count(hashed.begin(), hashed.end(), 0xFF) == std::count(photo.begin(), photo.end(), '\xFF'));
+    CHECK(static_cast<size_t>(hashed.end() - hashed.begin()) == photo.size());
+    CHECK(std::equal(hashed.begin(), hashed.end(), reinterpret_cast<const byte *>(photo.data())));
+}
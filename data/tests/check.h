@@ -0,0 +1,90 @@
+#ifndef CHECK_H
+#define CHECK_H
+#include <initializer_list>
+#include <string>
+#include "../data.h"
+
+// The assertions of the data tests. A failing CHECK prints where it is and the test goes on, so
+// that one run reports every broken check; test.cpp runs every group and fails if any check did.
+// Files are created in the working directory under names unique to the process, and removed.
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+void check(bool passed, const char *expression, const char *file, int line);
+// Postcondition: Counts the check, and prints the expression and where it is if it failed.
+
+bool holds(data &d, std::initializer_list<int> expected);
+// Postcondition: Returns true if the bytes of d are the expected ones.
+
+std::string scratchPath(const std::string &name);
+// Postcondition: Returns a path in the working directory for a file of this process called name.
+
+std::string readFile(const std::string &path);
+// Postcondition: Returns the bytes of the file, or "" if it cannot be read.
+
+void writeFile(const std::string &path, const std::string &bytes);
+// Postcondition: Replaces the file with the bytes.
+
+/** Test groups **/
+void testBasics();
+// Postcondition: Checks byte editing, capacities, piece table saves, and the hashes and iterators
+//                of photo.jpeg.
+
+void testCompression();
+// Postcondition: Checks compressed bytes read, edited, saved and loaded, and damaged containers.
+
+void testConcurrent();
+// Postcondition: Checks that snapshots keep their bytes through edits, reclamation and a writer.
+
+void testDelta();
+// Postcondition: Checks that deltas rebuild their target and that invalid ones are refused.
+
+void testEdits();
+// Postcondition: Checks batches of edits on flat bytes, piece tables and rings.
+
+void testEncoding();
+// Postcondition: Checks hex and base64 encoding, decoding and the rejection of invalid text.
+
+void testFixed();
+// Postcondition: Checks fixedData at runtime; its constexpr edits are checked when compiling.
+
+void testGrowth();
+// Postcondition: Checks the growth policies, reserve and shrinkToFit.
+
+void testHashing();
+// Postcondition: Checks the hashers against known vectors, streamed and in one shot.
+
+void testLoading();
+// Postcondition: Checks loadMany on io_uring and on threads over every kind of file.
+
+void testMoves();
+// Postcondition: Checks moves and swaps, piece tables over inline bytes included.
+
+void testParallel();
+// Postcondition: Checks parallel and O_DIRECT loads and saves.
+
+void testResources();
+// Postcondition: Checks that buffers come from the resource of data, and the resources of resource.h.
+
+void testRing();
+// Postcondition: Checks ringBuffer between a producer and a consumer, and the ring buffer mode of data.
+
+void testSearch();
+// Postcondition: Checks the searches and the pattern scanner against a naive scan.
+
+void testSpan();
+// Postcondition: Checks the std::span overloads, when built as C++20.
+
+void testStats();
+// Postcondition: Checks the statistics counters and histograms, which count nothing without DATA_STATS.
+
+void testStreams();
+// Postcondition: Checks reading streams and pipes into data, and hexDump against xxd.
+
+void testViews();
+// Postcondition: Checks that saving a file leaves every other mapping of it unchanged.
+
+void testWritable();
+// Postcondition: Checks writable mappings: file growth, batches of edits and saves.
+
+#endif
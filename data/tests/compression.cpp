@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "check.h"
+
+// Round trips at both levels over bytes that compress well, badly and not at all, with the block
+// sizes around compressedBlock, reads that cross blocks and evict them from the cached ones, edits,
+// and containers saved, loaded back and damaged. A damaged container is fatal to load, so that is
+// done in a child process whose exit status is checked.
+
+static const size_t block = data::compressedBlock;
+
+// Returns n bytes that no match can shorten.
+static std::string randomBytes(size_t n, uint64_t seed)
+{
+    std::string s(n, '\0');
+    for (size_t i = 0; i < n; i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        s[i] = static_cast<char>(seed & 0xFF);
+    }
+    return s;
+}
+
+// Returns n bytes repeating the first period of them, which compress to matches overlapping
+// themselves (at offset 1 for a period of 1).
+static std::string runs(size_t n, size_t period)
+{
+    std::string s(n, '\0');
+    for (size_t i = 0; i < n; i++)
+        s[i] = static_cast<char>('a' + i % period);
+    return s;
+}
+
+// Returns a data object holding the bytes.
+static data from(const std::string &bytes)
+{
+    return data(reinterpret_cast<const byte *>(bytes.data()), bytes.size());
+}
+
+// Returns true if every byte of d read through operator[] is the expected one.
+static bool indexed(data &d, const std::string &expected)
+{
+    if (d.size() != expected.size())
+        return false;
+    for (size_t i = 0; i < expected.size(); i++)
+        if (d[i] != static_cast<byte>(expected[i]))
+            return false;
+    return true;
+}
+
+// Returns true if the bytes between l and u of d, through a view and a copy, are the expected ones.
+static bool ranged(data &d, const std::string &expected, size_t l, size_t u)
+{
+    data::range r(l, u);
+    std::string wanted = expected.substr(l, u - l + 1);
+    data::view v = d.viewInRange(r);
+    bool viewed = v.digest() == wanted;
+    byte *copy = d.bytesInRange(r);
+    bool copied = std::string(reinterpret_cast<char *>(copy), wanted.size()) == wanted;
+    delete [] copy;
+    return viewed && copied;
+}
+
+// Returns true if loading the file as compressedFile is refused, in a child process with its
+// output discarded.
+static bool refused(const std::string &path)
+{
+    std::cout.flush();
+    pid_t child = fork();
+    if (child == 0)
+    {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        data d(path, data::compressedFile);
+        _exit(0);
+    }
+    int status = 0;
+    if (child < 0 || waitpid(child, &status, 0) != child)
+        return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 1;
+}
+
+void testCompression()
+{
+    std::string photo = readFile("photo.jpeg");
+    std::string random = randomBytes(3 * block + 100, 7);
+    std::string single = runs(5 * block, 1);
+    std::string repeated = runs(5 * block + 3, 7);
+    
+    // Every kind of bytes at both levels, read back whole and byte by byte.
+    for (data::compressionLevel level : {data::fastCompression, data::highCompression})
+    {
+        for (const std::string *bytes : {&photo, &random, &single, &repeated})
+        {
+            data d = from(*bytes);
+            d.compress(level);
+            CHECK(d.isCompressed() && d.size() == bytes->size());
+            CHECK(indexed(d, *bytes));
+            CHECK(ranged(d, *bytes, 0, bytes->size() - 1));
+            d.decompress();
+            CHECK(!d.isCompressed() && d.compressedSize() == 0);
+            CHECK(d.digest() == *bytes);
+        }
+        
+        // Random bytes are kept raw, and runs shrink to a few bytes per block.
+        data r = from(random);
+        r.compress(level);
+        CHECK(r.compressedSize() >= random.size() && r.compressedSize() < random.size() + random.size() / 1000);
+        for (const std::string *bytes : {&single, &repeated})
+        {
+            data run = from(*bytes);
+            run.compress(level);
+            CHECK(run.compressedSize() < bytes->size() / 100);
+            CHECK(run.digest() == *bytes);
+        }
+    }
+    
+    // Sizes around a block, and the inline ones, which are left as they are.
+    for (size_t n : {size_t(0), size_t(1), block - 1, block, block + 1})
+    {
+        std::string bytes = photo.substr(0, n);
+        for (data::compressionLevel level : {data::fastCompression, data::highCompression})
+        {
+            data d = from(bytes);
+            d.compress(level);
+            CHECK(d.isCompressed() == (n > 1));
+            CHECK(d.size() == n && indexed(d, bytes));
+            CHECK(d.digest() == bytes);
+        }
+    }
+    
+    // Reads over more blocks than are cached, going back and forth so that each one is evicted and
+    // decompressed again, and ranges crossing block boundaries.
+    std::string mixed;
+    for (size_t k = 0; k < data::cachedBlocks + 3; k++)
+        mixed += k % 3 == 0 ? randomBytes(block, k + 1) : k % 3 == 1 ? photo.substr(k * 1000, block) : runs(block, k);
+    mixed += photo.substr(0, 1234);
+    {
+        data d = from(mixed);
+        d.compress(data::highCompression);
+        size_t blocks = mixed.size() / block + 1;
+        size_t wrong = 0;
+        for (size_t pass = 0; pass < 3; pass++)
+        {
+            for (size_t k = 0; k < blocks; k++)
+            {
+                size_t b = pass == 1 ? blocks - 1 - k : (k * 5) % blocks;
+                size_t i = std::min(b * block + (pass * 7919 + k * 131) % block, mixed.size() - 1);
+                wrong += d[i] != static_cast<byte>(mixed[i]);
+            }
+        }
+        CHECK(wrong == 0);
+        CHECK(ranged(d, mixed, block - 10, block + 10));
+        CHECK(ranged(d, mixed, 3 * block - 1, 3 * block));
+        CHECK(ranged(d, mixed, block / 2, 9 * block + block / 2));
+        CHECK(ranged(d, mixed, mixed.size() - 1300, mixed.size() - 1));
+        CHECK(ranged(d, mixed, 0, 1));
+        CHECK(d.isCompressed());
+        CHECK(indexed(d, mixed));
+    }
+    
+    // Edits decompress the bytes first.
+    {
+        data d = from(mixed);
+        d.compress();
+        std::string edited = mixed;
+        byte b[] = {1, 2, 3};
+        d.insertBytes(b, 3, block - 1);
+        edited.insert(block - 1, "\x01\x02\x03", 3);
+        CHECK(!d.isCompressed());
+        d.compress();
+        data::range over(2 * block, 2 * block + 2);
+        d.overrideBytes(b, 3, over);
+        edited.replace(2 * block, 3, "\x01\x02\x03", 3);
+        d.compress(data::highCompression);
+        d.removeBytesIn(data::range(10, block + 9));
+        edited.erase(10, block);
+        d.compress();
+        d.appendByte(4);
+        edited += '\x04';
+        CHECK(d.digest() == edited);
+        
+        // Compressing compressed bytes again keeps them.
+        d.compress();
+        d.compress(data::highCompression);
+        CHECK(indexed(d, edited));
+    }
+    
+    // Containers saved and loaded back, from compressed bytes and from plain ones, and saved again.
+    std::string path = scratchPath("container.dcmp");
+    std::string again = scratchPath("again.dcmp");
+    {
+        data d = from(mixed);
+        d.compress(data::highCompression);
+        d.saveToPath(path, data::inPlace, data::compressedFormat);
+        data loaded(path, data::compressedFile);
+        CHECK(loaded.isCompressed() && loaded.size() == mixed.size());
+        CHECK(ranged(loaded, mixed, block - 10, block + 10));
+        CHECK(loaded.digest() == mixed);
+        
+        data plain = from(photo);
+        plain.saveToPath(again, data::inPlace, data::compressedFormat);
+        CHECK(!plain.isCompressed());
+        data back(again, data::compressedFile);
+        CHECK(back.isCompressed() && indexed(back, photo));
+        
+        back.appendByte(9);
+        back.save();
+        data twice(again, data::compressedFile);
+        CHECK(twice.digest() == photo + "\x09");
+        CHECK(!refused(again));
+        
+        data none;
+        none.saveToPath(again, data::inPlace, data::compressedFormat);
+        data empty(again, data::compressedFile);
+        CHECK(empty.size() == 0);
+    }
+    
+    // Containers cut short or with a bit flipped anywhere are refused.
+    std::string container = readFile(path);
+    CHECK(container.size() > 100);
+    for (size_t n : {size_t(0), size_t(3), size_t(5), size_t(12), size_t(25), container.size() / 2, container.size() - 1})
+    {
+        writeFile(again, container.substr(0, n));
+        CHECK(refused(again));
+    }
+    for (size_t i : {size_t(0), size_t(4), size_t(5), size_t(9), size_t(14), size_t(25), container.size() / 3,
+                     container.size() / 2, container.size() - 1})
+    {
+        std::string flipped = container;
+        flipped[i] = static_cast<char>(flipped[i] ^ 0x10);
+        writeFile(again, flipped);
+        CHECK(refused(again));
+    }
+    
+    std::remove(path.c_str());
+    std::remove(again.c_str());
+}
@@ -0,0 +1,248 @@
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "../concurrent.h"
+
+// Snapshots must keep the bytes of their version whatever is published after them, edits that
+// copy part of a chunk, share it or cross into the next one included. Retired versions wait for
+// their readers, and readers running against a writer never see a version halfway.
+
+static const size_t chunk = concurrentData::chunkSize;
+
+// Returns the bytes of the snapshot.
+static std::string contents(const concurrentData::snapshot &s)
+{
+    std::string bytes(s.size(), '\0');
+    s.copyTo(reinterpret_cast<byte *>(&bytes[0]), 0, s.size());
+    return bytes;
+}
+
+// Returns true if the chunks of the snapshot hold its bytes, all but the last one full.
+static bool chunksHold(const concurrentData::snapshot &s, const std::string &expected)
+{
+    std::string joined;
+    for (size_t k = 0; k < s.chunkCount(); k++)
+    {
+        data::view v = s.chunkAt(k);
+        if (k + 1 < s.chunkCount() && v.size() != chunk)
+            return false;
+        joined.append(reinterpret_cast<const char *>(v.begin()), v.size());
+    }
+    return joined == expected;
+}
+
+// Returns n bytes counting up from seed.
+static std::string pattern(size_t n, unsigned seed)
+{
+    std::string s(n, '\0');
+    for (size_t i = 0; i < n; i++)
+        s[i] = static_cast<char>((i * 7 + seed) & 0xFF);
+    return s;
+}
+
+// Returns the bytes of s as bytes.
+static const byte *bytesOf(const std::string &s)
+{
+    return reinterpret_cast<const byte *>(s.data());
+}
+
+// The records the writer keeps rewriting: the same number three times, so a reader seeing parts
+// of two versions would find them differing. 24 bytes do not divide a chunk, so some records
+// cross a chunk boundary.
+static const size_t recordSize = 3 * sizeof(uint64_t);
+
+// Returns the record holding the number n.
+static std::string record(uint64_t n)
+{
+    std::string r(recordSize, '\0');
+    for (size_t i = 0; i < 3; i++)
+        memcpy(&r[i * sizeof(n)], &n, sizeof(n));
+    return r;
+}
+
+// Returns true if the record starting at i of the snapshot holds one number three times.
+static bool whole(const concurrentData::snapshot &s, size_t i)
+{
+    uint64_t n[3];
+    s.copyTo(reinterpret_cast<byte *>(n), i, recordSize);
+    return n[0] == n[1] && n[1] == n[2];
+}
+
+void testConcurrent()
+{
+    // Every kind of edit, each crossing a chunk boundary, with a snapshot kept of every version.
+    {
+        std::string initial = pattern(3 * chunk + 1000, 1);
+        data d(bytesOf(initial), initial.size());
+        concurrentData shared(d);
+        std::vector<std::string> expected;
+        std::vector<concurrentData::snapshot> snapshots;
+        auto keep = [&](const std::string &bytes) {
+            expected.push_back(bytes);
+            snapshots.push_back(shared.read());
+        };
+        keep(initial);
+        
+        std::string current = initial;
+        std::string over = pattern(8, 50);
+        shared.overrideBytes(bytesOf(over), 8, chunk - 4);
+        current.replace(chunk - 4, 8, over);
+        keep(current);
+        
+        std::string appended = pattern(chunk + 10, 90);
+        shared.appendBytes(bytesOf(appended), appended.size());
+        current += appended;
+        keep(current);
+        
+        std::string inserted = pattern(10, 130);
+        shared.insertBytes(bytesOf(inserted), 10, 2 * chunk - 5);
+        current.insert(2 * chunk - 5, inserted);
+        keep(current);
+        
+        shared.removeBytesIn(data::range(chunk - 100, 2 * chunk + 99));
+        current.erase(chunk - 100, chunk + 200);
+        keep(current);
+        
+        // A removal of a whole chunk, after which the chunks line up again and are shared.
+        shared.removeBytesIn(data::range(0, chunk - 1));
+        current.erase(0, chunk);
+        keep(current);
+        
+        data::range r(10, 19);
+        shared.overrideBytes(bytesOf(over), 8, r);
+        current.replace(10, 10, over);
+        keep(current);
+        
+        data::editBatch batch;
+        batch.insertBytes(bytesOf(inserted), 10, 0);
+        batch.overrideBytes(bytesOf(over), 8, chunk - 2);
+        batch.removeBytesIn(data::range(current.size() - 30, current.size() - 1));
+        CHECK(shared.applyEdits(batch));
+        current.erase(current.size() - 30);
+        current.replace(chunk - 2, 8, over);
+        current.insert(0, inserted);
+        keep(current);
+        
+        data::editBatch overlapping;
+        overlapping.removeBytesIn(data::range(0, 9));
+        overlapping.overrideBytes(bytesOf(over), 8, 5);
+        CHECK(!shared.applyEdits(overlapping));
+        CHECK(shared.read().versionNumber() == snapshots.back().versionNumber());
+        
+        for (size_t i = 0; i < snapshots.size(); i++)
+        {
+            CHECK(snapshots[i].versionNumber() == snapshots[0].versionNumber() + i);
+            CHECK(contents(snapshots[i]) == expected[i]);
+            CHECK(chunksHold(snapshots[i], expected[i]));
+        }
+        CHECK(snapshots.back().copy().digest() == current);
+        CHECK(shared.size() == current.size());
+    }
+    
+    // Appending after a shrink, into a last chunk the older versions still use.
+    {
+        std::string initial = pattern(2 * chunk + 100, 3);
+        data d(bytesOf(initial), initial.size());
+        concurrentData shared(d);
+        std::string grown = initial + pattern(50, 7);
+        shared.appendBytes(bytesOf(grown) + initial.size(), 50);
+        concurrentData::snapshot longer = shared.read();
+        
+        shared.removeBytesIn(data::range(grown.size() - 80, grown.size() - 1));
+        concurrentData::snapshot shorter = shared.read();
+        std::string replaced = pattern(200, 11);
+        shared.appendBytes(bytesOf(replaced), replaced.size());
+        std::string current = grown.substr(0, grown.size() - 80) + replaced;
+        
+        // The same after a whole chunk is removed, which shares the last chunk as it is.
+        shared.removeBytesIn(data::range(0, chunk - 1));
+        concurrentData::snapshot aligned = shared.read();
+        shared.appendBytes(bytesOf(replaced), replaced.size());
+        
+        CHECK(contents(longer) == grown);
+        CHECK(contents(shorter) == grown.substr(0, grown.size() - 80));
+        CHECK(contents(aligned) == current.substr(chunk));
+        CHECK(contents(shared.read()) == current.substr(chunk) + replaced);
+    }
+    
+    // Versions wait for their snapshots, and reclaim frees them once those are gone.
+    {
+        std::string initial = pattern(1000, 5);
+        data d(bytesOf(initial), initial.size());
+        concurrentData shared(d);
+        byte b[] = {1};
+        shared.appendBytes(b, 1);
+        CHECK(shared.retiredVersions() == 0);
+        {
+            concurrentData::snapshot held = shared.read();
+            shared.appendBytes(b, 1);
+            shared.appendBytes(b, 1);
+            CHECK(shared.retiredVersions() > 0);
+            CHECK(contents(held) == initial + "\x01");
+        }
+        shared.reclaim();
+        CHECK(shared.retiredVersions() == 0);
+        shared.appendBytes(b, 1);
+        CHECK(shared.retiredVersions() == 0);
+        CHECK(shared.size() == initial.size() + 4);
+    }
+    
+    // Readers taking snapshots while a writer rewrites and appends records.
+    {
+        const size_t records = 2 * chunk / recordSize + 100;
+        std::string initial;
+        for (size_t i = 0; i < records; i++)
+            initial += record(0);
+        data d(bytesOf(initial), initial.size());
+        concurrentData shared(d);
+        
+        std::atomic<bool> writing(true);
+        std::atomic<size_t> torn(0);
+        std::atomic<size_t> reads(0);
+        std::vector<std::thread> readers;
+        for (size_t t = 0; t < 3; t++)
+        {
+            readers.emplace_back([&, t]() {
+                uint64_t last = 0;
+                size_t k = t;
+                while (writing.load())
+                {
+                    concurrentData::snapshot s = shared.read();
+                    if (s.versionNumber() < last || s.size() % recordSize != 0)
+                        torn++;
+                    last = s.versionNumber();
+                    
+                    // The records on the first chunk boundary, and a few others.
+                    size_t n = s.size() / recordSize;
+                    for (size_t i : {chunk / recordSize, (k * 131) % n, n - 1})
+                        if (!whole(s, i * recordSize))
+                            torn++;
+                    k++;
+                    reads++;
+                }
+            });
+        }
+        
+        for (uint64_t n = 1; n <= 300; n++)
+        {
+            std::string r = record(n);
+            shared.overrideBytes(bytesOf(r), recordSize, (chunk / recordSize) * recordSize);
+            shared.overrideBytes(bytesOf(r), recordSize, ((n * 37) % records) * recordSize);
+            if (n % 10 == 0)
+                shared.appendBytes(bytesOf(r), recordSize);
+            std::this_thread::yield();
+        }
+        writing = false;
+        for (std::thread &t : readers)
+            t.join();
+        
+        CHECK(torn == 0);
+        CHECK(reads > 0);
+        CHECK(shared.size() == initial.size() + 30 * recordSize);
+        shared.reclaim();
+        CHECK(shared.retiredVersions() == 0);
+    }
+}
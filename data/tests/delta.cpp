@@ -0,0 +1,86 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "../hash.h"
+
+// Deltas rebuild their target in both modes, in memory and streamed, and anything that is not a
+// delta of the base is refused without allocating what its header claims.
+
+static void putVarint(std::vector<byte> &out, uint64_t v)
+// Postcondition: Appends v the way deltas store lengths.
+{
+    for (; v >= 0x80; v >>= 7)
+        out.push_back(static_cast<byte>(v) | 0x80);
+    out.push_back(static_cast<byte>(v));
+}
+
+static void putHash(std::vector<byte> &out, uint64_t h)
+// Postcondition: Appends h the way deltas store hashes.
+{
+    for (int i = 0; i < 8; i++)
+        out.push_back(static_cast<byte>(h >> (8 * i)));
+}
+
+void testDelta()
+{
+    std::string photo = readFile("photo.jpeg");
+    data base(reinterpret_cast<const byte *>(photo.data()), photo.size());
+    data target(base);
+    byte edit[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    target.insertBytes(edit, 8, 1000);
+    target.removeBytesIn(data::range(200000, 200999));
+    target.insertBytes(edit, 8, target.size());
+    
+    for (data::deltaMode mode : {data::blockMatching, data::suffixMatching})
+    {
+        data delta = data::diff(base, target, mode);
+        CHECK(delta.size() < 10000);
+        data rebuilt = data::applyDelta(base, delta);
+        CHECK(rebuilt.viewAll() == target.viewAll());
+        
+        std::ostringstream out;
+        CHECK(data::applyDelta(base, delta, out));
+        CHECK(out.str() == target.digest());
+        
+        // Another base, and every truncation, are refused.
+        CHECK(data::applyDelta(target, delta).size() == 0);
+        for (size_t n : {size_t(0), size_t(4), size_t(20), delta.size() / 2, delta.size() - 1})
+        {
+            data cut(delta.begin(), n);
+            CHECK(data::applyDelta(base, cut).size() == 0);
+        }
+    }
+    
+    // A short delta of the right base claiming a target of 2^50 bytes.
+    std::vector<byte> forged = {'D', 'D', 'L', 'T', 1};
+    putVarint(forged, base.size());
+    putVarint(forged, uint64_t(1) << 50);
+    putHash(forged, base.xxh64());
+    putHash(forged, 0);
+    putVarint(forged, 3 << 1);
+    forged.insert(forged.end(), {'a', 'b', 'c'});
+    data lying(forged.data(), forged.size());
+    CHECK(lying.size() <= 40);
+    CHECK(data::applyDelta(base, lying).size() == 0);
+    std::ostringstream out;
+    CHECK(!data::applyDelta(base, lying, out));
+    
+    // Copies of the whole base, as many as claimed, add up to a real target.
+    std::vector<byte> repeated = {'D', 'D', 'L', 'T', 1};
+    putVarint(repeated, base.size());
+    putVarint(repeated, 3 * base.size());
+    putHash(repeated, base.xxh64());
+    data thrice(base);
+    thrice.insertBytes(base.begin(), base.size(), thrice.size());
+    thrice.insertBytes(base.begin(), base.size(), thrice.size());
+    putHash(repeated, thrice.xxh64());
+    for (int i = 0; i < 3; i++)
+    {
+        putVarint(repeated, (uint64_t(base.size()) << 1) | 1);
+        putVarint(repeated, i == 0 ? 0 : 2 * base.size() - 1);
+    }
+    data copies(repeated.data(), repeated.size());
+    CHECK(data::applyDelta(base, copies).viewAll() == thrice.viewAll());
+}
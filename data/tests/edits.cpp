@@ -0,0 +1,108 @@
+#include <random>
+#include <string>
+#include "check.h"
+
+// Batches of edits against a string applying the same edits, on flat bytes, piece tables and
+// rings whose bytes wrap around, with inserts, removals and overrides of every size mixed.
+
+static std::string bytesOf(data &d)
+{
+    return d.digest();
+}
+
+static std::string randomBatch(std::mt19937 &random, const std::string &before, data::editBatch &batch)
+// Postcondition: Records disjoint random edits of before into batch, and returns before edited.
+{
+    std::string after;
+    size_t from = 0;
+    size_t at = random() % 40;
+    while (at <= before.size())
+    {
+        // Inserts outweigh removals below 1500 bytes and the other way around above, so the
+        // size wanders around that.
+        std::string added(random() % (before.size() < 1500 ? 90 : 30), '\0');
+        for (char &c : added)
+            c = static_cast<char>(random());
+        size_t removed = std::min<size_t>(random() % 60, before.size() - at);
+        const byte *b = reinterpret_cast<const byte *>(added.data());
+        
+        // Ranges hold two bytes at least, so shorter removals become inserts.
+        switch (removed < 2 ? 0 : random() % 3)
+        {
+            case 0:
+                batch.insertBytes(b, added.size(), at);
+                removed = 0;
+                break;
+            case 1:
+                batch.removeBytesIn(data::range(at, at + removed - 1));
+                added.clear();
+                break;
+            default:
+                batch.overrideBytes(b, added.size(), data::range(at, at + removed - 1));
+                break;
+        }
+        
+        after += before.substr(from, at - from) + added;
+        from = at + removed;
+        at = from + 1 + random() % 200;
+    }
+    return after + before.substr(from);
+}
+
+void testEdits()
+{
+    std::mt19937 random(7);
+    std::string start(1500, '\0');
+    for (char &c : start)
+        c = static_cast<char>(random());
+    const byte *s = reinterpret_cast<const byte *>(start.data());
+    
+    data flat(s, start.size());
+    data pieces(s, start.size());
+    pieces.usePieceTable(true);
+    data ring;
+    CHECK(ring.useRingBuffer(4096));
+    size_t length = ring.capacity();
+    
+    // The ring starts near its end, so the bytes wrap around it.
+    std::string filler(length - 700, 'x');
+    ring.insertBytes(reinterpret_cast<const byte *>(filler.data()), filler.size(), 0);
+    ring.popFront(filler.size());
+    ring.insertBytes(s, start.size(), 0);
+    
+    std::string expected = start;
+    for (int round = 0; round < 200; round++)
+    {
+        data::editBatch batch;
+        std::string after = randomBatch(random, expected, batch);
+        if (after.size() > length)
+            continue;
+        
+        CHECK(flat.applyEdits(batch));
+        CHECK(pieces.applyEdits(batch));
+        CHECK(ring.applyEdits(batch));
+        expected = after;
+        CHECK(bytesOf(flat) == expected);
+        CHECK(bytesOf(pieces) == expected);
+        CHECK(bytesOf(ring) == expected);
+    }
+    
+    // The ring is still one, and still overwrites its oldest bytes.
+    CHECK(ring.isRingBuffer() && ring.capacity() == length);
+    std::string more(length, 'y');
+    ring.insertBytes(reinterpret_cast<const byte *>(more.data()), more.size(), ring.size());
+    CHECK(ring.size() == length && bytesOf(ring) == more);
+    
+    // A batch that would not fit in the ring changes nothing.
+    data::editBatch tooMuch;
+    tooMuch.insertBytes(s, 1, 0);
+    CHECK(!ring.applyEdits(tooMuch));
+    CHECK(ring.isRingBuffer() && bytesOf(ring) == more);
+    
+    // Overlapping edits are refused.
+    data::editBatch overlapping;
+    overlapping.removeBytesIn(data::range(10, 20));
+    overlapping.insertBytes(s, 3, 15);
+    CHECK(!flat.applyEdits(overlapping));
+    CHECK(bytesOf(flat) == expected);
+}
@@ -0,0 +1,76 @@
+#include <string>
+#include <vector>
+#include "check.h"
+
+// Hex and base64 against the RFC 4648 vectors, round trips long enough for the vector loops and
+// every way text can be invalid, in the scalar tail and in the part the vector loops decode.
+
+static data fromString(const std::string &s)
+{
+    return data(reinterpret_cast<const byte *>(s.data()), s.size());
+}
+
+void testEncoding()
+{
+    // Known vectors
+    const char *plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    const char *encoded[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+    for (int i = 0; i < 7; i++)
+    {
+        data d = fromString(plain[i]);
+        CHECK(d.base64Digest() == encoded[i]);
+        CHECK(data::fromBase64(encoded[i]).digest() == plain[i]);
+    }
+    
+    data d = fromString("\x01\xAB\xFF");
+    CHECK(d.hexDigest() == "01abff");
+    CHECK(data::fromHex("01abff").digest() == "\x01\xAB\xFF");
+    CHECK(data::fromHex("DEADbeef").hexDigest() == "deadbeef");
+    CHECK(data::fromHex("").size() == 0);
+    
+    // Round trips of every length up to 300 bytes, and a long one, with every byte value.
+    std::vector<byte> bytes(5000);
+    for (size_t i = 0; i < bytes.size(); i++)
+        bytes[i] = static_cast<byte>(i * 167 + i / 256);
+    for (size_t n = 0; n <= 5000; n = n < 300 ? n + 1 : n + 4700)
+    {
+        data original(bytes.data(), n);
+        std::string hex = original.hexDigest();
+        std::string base64 = original.base64Digest();
+        CHECK(hex.size() == 2 * n && base64.size() == data::base64Length(n));
+        CHECK(data::fromHex(hex).viewAll() == original.viewAll());
+        CHECK(data::fromBase64(base64).viewAll() == original.viewAll());
+    }
+    
+    // Invalid hex
+    CHECK(data::fromHex("abc").size() == 0);
+    CHECK(data::fromHex("0g").size() == 0);
+    CHECK(data::fromHex("0 ").size() == 0);
+    std::string longHex = data(bytes.data(), 200).hexDigest();
+    for (size_t at : {0, 33, 150, 399})
+    {
+        std::string broken = longHex;
+        broken[at] = 'x';
+        CHECK(data::fromHex(broken).size() == 0);
+    }
+    byte out[8];
+    CHECK(data::hexDecode("zz", 2, out) == data::encodingError);
+    
+    // Invalid base64
+    CHECK(data::fromBase64("Zg=").size() == 0);
+    CHECK(data::fromBase64("Zg!=").size() == 0);
+    CHECK(data::fromBase64("Z===").size() == 0);
+    CHECK(data::fromBase64("====").size() == 0);
+    CHECK(data::fromBase64("Zg==Zm9v").size() == 0);
+    CHECK(data::fromBase64("Zm9v\nZm9").size() == 0);
+    std::string longBase64 = data(bytes.data(), 300).base64Digest();
+    for (size_t at : {0, 45, 201, 398})
+    {
+        std::string broken = longBase64;
+        broken[at] = '*';
+        CHECK(data::fromBase64(broken).size() == 0);
+        broken[at] = '=';
+        CHECK(data::fromBase64(broken).size() == 0);
+    }
+    CHECK(data::base64Decode("Zm9", 3, out) == data::encodingError);
+}
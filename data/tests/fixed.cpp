@@ -0,0 +1,75 @@
+#include <string>
+#include "check.h"
+#include "../fixed.h"
+
+// Records built at compile time are checked by static_assert, so this file only compiles if the
+// edits, concatenation and widening are constexpr and right. At runtime, edits that do not fit
+// are rejected and the bytes go to and from data through views.
+
+static constexpr byte letters[] = {'a', 'b', 'c'};
+static constexpr byte digits[] = {'1', '2'};
+
+// Returns "a12C!" built by editing "abc" with every kind of edit.
+static constexpr fixedData<8> edited()
+{
+    fixedData<8> d(letters);
+    byte upper[] = {'C'};
+    d.overrideBytes(upper, 1, 2);
+    d.insertBytes(digits, 2, 1);
+    d.removeByteAt(3);
+    d.prependByte('x');
+    d.removeBytes(0, 1);
+    d.appendByte('!');
+    return d;
+}
+
+static constexpr byte expected[] = {'a', '1', '2', 'C', '!'};
+static_assert(edited() == fixedData<5>(expected), "edits are constexpr");
+static_assert(edited().size() == 5 && edited()[3] == 'C' && !edited().full(), "edits are constexpr");
+
+static constexpr fixedData<5> joined = fixedData<3>(letters) + fixedData<2>(digits);
+static_assert(joined.capacity() == 5 && joined.full(), "operator+ adds the capacities");
+static_assert(joined[0] == 'a' && joined[3] == '1' && joined[4] == '2', "operator+ is constexpr");
+
+static constexpr fixedData<16> widened = fixedData<3>(letters);
+static_assert(widened.capacity() == 16 && widened.size() == 3 && widened == fixedData<3>(letters),
+              "smaller records convert to larger ones");
+static_assert(fixedData<3>(letters) != fixedData<2>(digits) && fixedData<1>().empty(), "comparisons are constexpr");
+
+void testFixed()
+{
+    // A full record rejects every edit that adds bytes, and keeps its own.
+    fixedData<5> full(expected);
+    CHECK(full.full());
+    byte b[] = {9, 9};
+    full.appendByte(9);
+    full.prependByte(9);
+    full.insertBytes(b, 2, 2);
+    CHECK(full == fixedData<5>(expected));
+    full.insertBytes(b, 0, 2);
+    CHECK(full.size() == 5);
+    
+    // One short of full, a single byte fits and two do not.
+    fixedData<4> room(letters);
+    room.insertBytes(b, 2, 0);
+    CHECK(room.size() == 3);
+    room.insertBytes(b, 1, 3);
+    CHECK(room.full() && room[3] == 9);
+    room.clear();
+    CHECK(room.empty());
+    
+    // Through data::view, to and from data.
+    std::string photo = readFile("photo.jpeg");
+    data d(reinterpret_cast<const byte *>(photo.data()), photo.size());
+    fixedData<16> header(d.viewAll().slice(0, 4));
+    CHECK(header.size() == 4 && header[0] == 0xFF && header[1] == 0xD8);
+    CHECK(header.asView() == d.viewAll().slice(0, 4));
+    CHECK(d.viewAll().find(header.asView()) == 0);
+    
+    fixedData<32> record = header + fixedData<2>(digits);
+    data copy(record.begin(), record.size());
+    CHECK(copy.viewAll() == record.asView());
+    CHECK(copy.digest() == photo.substr(0, 4) + "12");
+    copy.insertBytes(widened.begin(), widened.size(), copy.size());
+    CHECK(fixedData<16>(copy.viewAll()) == header + fixedData<2>(digits) + widened);
+}
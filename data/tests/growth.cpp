@@ -0,0 +1,96 @@
+#include <vector>
+#include "check.h"
+
+// How capacity follows the growth policies, reserve and shrinkToFit, and that the bytes survive
+// every reallocation, the ones done with mremap included.
+
+static std::vector<size_t> capacities(data &d, size_t n)
+// Postcondition: Appends bytes until d holds n, and returns every capacity it went through.
+{
+    std::vector<size_t> seen(1, d.capacity());
+    while (d.size() < n)
+    {
+        d.appendByte(static_cast<byte>(d.size() * 13));
+        if (d.capacity() != seen.back())
+            seen.push_back(d.capacity());
+    }
+    return seen;
+}
+
+static bool holdsAppended(data &d, size_t n)
+// Postcondition: Returns true if d holds the n bytes capacities appended.
+{
+    if (d.size() != n)
+        return false;
+    for (size_t i = 0; i < n; i++)
+        if (d[i] != static_cast<byte>(i * 13))
+            return false;
+    return true;
+}
+
+void testGrowth()
+{
+    // Policies
+    data doubled;
+    CHECK(capacities(doubled, 1000) == std::vector<size_t>({32, 64, 128, 256, 512, 1024}));
+    CHECK(holdsAppended(doubled, 1000));
+    
+    data halved;
+    halved.setGrowthPolicy(data::oneAndHalf);
+    CHECK(capacities(halved, 300) == std::vector<size_t>({32, 48, 72, 108, 162, 243, 364}));
+    CHECK(holdsAppended(halved, 300));
+    
+    data stepped;
+    stepped.setGrowthPolicy(data::fixedStep, 100);
+    CHECK(capacities(stepped, 400) == std::vector<size_t>({32, 132, 232, 332, 432}));
+    CHECK(holdsAppended(stepped, 400));
+    
+    // Growth stops at the maximum capacity.
+    data limited;
+    limited.setCapacity(200);
+    capacities(limited, 200);
+    CHECK(limited.capacity() == 200);
+    limited.appendByte(1);
+    CHECK(limited.size() == 200 && limited.capacity() == 200);
+    
+    // Buffers of a megabyte and more grow and shrink with mremap.
+    data large;
+    capacities(large, 5 * 1024 * 1024);
+    CHECK(large.capacity() == 8 * 1024 * 1024);
+    CHECK(holdsAppended(large, 5 * 1024 * 1024));
+    large.shrinkToFit();
+    CHECK(large.capacity() == 5 * 1024 * 1024);
+    CHECK(holdsAppended(large, 5 * 1024 * 1024));
+    
+    // reserve allocates once, for everything appended after it.
+    data reserved;
+    reserved.reserve(10000);
+    CHECK(reserved.capacity() == 10000);
+    CHECK(capacities(reserved, 10000).size() == 1);
+    CHECK(holdsAppended(reserved, 10000));
+    reserved.reserve(10);
+    CHECK(reserved.capacity() == 10000);
+    
+    limited.reserve(1000);
+    CHECK(limited.capacity() == 200);
+    
+    // Pending piece table edits are flattened by reserve.
+    byte b[] = {1, 2, 3};
+    data pieces(b, 3);
+    pieces.usePieceTable(true);
+    pieces.insertBytes(b, 3, 1);
+    pieces.reserve(500);
+    CHECK(pieces.capacity() == 500 && holds(pieces, {1, 1, 2, 3, 2, 3}));
+    
+    // shrinkToFit gives back the unused capacity, moving small payloads to the inline buffer.
+    data shrunk;
+    capacities(shrunk, 3000);
+    CHECK(shrunk.capacity() == 4096);
+    shrunk.shrinkToFit();
+    CHECK(shrunk.capacity() == 3000 && holdsAppended(shrunk, 3000));
+    shrunk.removeBytesIn(data::range(10, 2999));
+    shrunk.shrinkToFit();
+    CHECK(shrunk.capacity() == 10 && holdsAppended(shrunk, 10));
+    shrunk.appendByte(static_cast<byte>(10 * 13));
+    CHECK(holdsAppended(shrunk, 11));
+}
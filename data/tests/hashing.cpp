@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "../hash.h"
+
+// The hashers against published vectors, and against a reference implementation on inputs that
+// take every length path of XXH3. Streaming any split of the bytes must give the one-shot hash.
+
+struct knownHashes {
+    size_t length;      // The amount of bytes (i * 31 + 7) & 0xFF.
+    uint32_t crc32c;
+    uint64_t xxh64;
+    uint64_t xxh3;
+    const char *sha256;
+};
+
+static const knownHashes vectors[] = {
+    {1, 0x86b737ba, 0xa96c7f0ce858bbb7ULL, 0x4c5cca45d0f4811fULL, "ca358758f6d27e6cf45272937977a748fd88391db679ceda7dc7bf1f005ee879"},
+    {3, 0x765a7c83, 0x56e6957632a487f9ULL, 0x15f7093b173d005cULL, "647674a296197442f518bcca323ec605dd8d098b2d4f22ee1fdcdd2bb753a189"},
+    {4, 0x65f1c5dc, 0xc60d15b1e3ff8f04ULL, 0xdca012f95811b6b9ULL, "b999f79c534a332dfb989ab78cda3d1967c16133ca1d668cf62737f8d768962f"},
+    {8, 0x40795c72, 0x3da5c7aa269683e0ULL, 0xdec6a9a43575982eULL, "4fb900ca3f5832fcc475b79bf07217bf0edfe9d39ea10f5cf624246ff68b47de"},
+    {9, 0x6fe35da6, 0x4b17a9ba9e215c09ULL, 0xcbe393399f17ffbdULL, "1a4d14ade81567725e079c6fc24507fefef27d92c7ac4086d9f74b89ef2f0aa4"},
+    {16, 0xcf7845a4, 0xa19ad429b02bc413ULL, 0x7e484c18d74895d0ULL, "f087c7ff57988205ab8885ecbfca8a77c96e91b213bdaba91143fbcd62997713"},
+    {17, 0x10c70233, 0xfe9f0feb7eeedc09ULL, 0x208bde5ee2bed407ULL, "b6ff0191041cc77b1ef514adaed53fdd247fd43221a629d3d7c91d14e21038a3"},
+    {100, 0xe26c441c, 0xefa0ad2d3e70c151ULL, 0x8c97158042fbf926ULL, "c22e490daa445fb2fba44278c022df135310fd278cabca4ad7919eddcccd1dce"},
+    {128, 0xae5b4c7a, 0x725a5b9b3bedfe94ULL, 0xf92b70eaa21a6288ULL, "cc548ca2dec1f6fe4f58b2e27aa9c7521607df1130d140b55a4dad0665302356"},
+    {129, 0x1e952bbb, 0x28fc8362643627d7ULL, 0xf8f76713f2bb60faULL, "81e89a7b2911aaa7795f9e3d4910cb47d6cd2b00d83b8399481527261a1a7519"},
+    {200, 0x80c9feb7, 0x95d9a0c977b4b6fbULL, 0x12fdb864685f344dULL, "44cae5223d431caed4a9e32271d6abf17c3f2f4abac45fcdb48a99fcc6072a09"},
+    {240, 0xb3f70c9f, 0xd430520ae3ed2fc6ULL, 0xccc7375172c41f03ULL, "ba56c3138ebb08e71dc4158f1ecbeda5ea11bfee22514861e2b886bfc8db514e"},
+    {241, 0x5ae1c7ea, 0xd3f50496d5bf27e0ULL, 0x0b3b630948ce4a00ULL, "5ac5b664d57ad40f1666748497f314aabe28d312894f08ae093ddf07b09a020e"},
+    {1024, 0xa5e5b4b5, 0x149aa44972cdae00ULL, 0x23bc880ebf0d29c6ULL, "8d7e566766f6bd1bb4cac87cadfde681197f9243f4d2692a0fd12674092212a7"},
+    {1025, 0x01f6b4db, 0x2c9d0b038b4a4b35ULL, 0xc09fdfbc398c7d82ULL, "15b5bbecf752ad00e85ff42843b5dce9df388bc38ab97cf06e528727f5937413"},
+    {5000, 0x2b79d61e, 0xaa5b264f05aca4d4ULL, 0x559fff92c2b7f8eeULL, "1e92fd98f113aba0a78e0830ca06e2775912370feab112dfc57bf3258b810595"},
+};
+
+static data fromString(const std::string &s)
+{
+    return data(reinterpret_cast<const byte *>(s.data()), s.size());
+}
+
+template <class H>
+static bool streamsLikeOneShot(data::view v)
+// Postcondition: Returns true if hashing v in pieces of 1, 9, 17 and so on up to 97 bytes, and
+//                through follow(), gives the one-shot hash.
+{
+    typename H::digestType expected = H::hash(v);
+    for (size_t step = 1; step < 98; step += 8)
+    {
+        H h;
+        for (size_t i = 0; i < v.size(); i += step)
+            h.update(v.slice(i, std::min(step, v.size() - i)));
+        if (h.digest() != expected)
+            return false;
+    }
+    
+    // follow() hashes what was appended since the previous call, however it was appended.
+    H followed;
+    data growing;
+    for (size_t i = 0; i < v.size(); i += 300)
+    {
+        growing.insertBytes(v.begin() + i, std::min<size_t>(300, v.size() - i), growing.size());
+        followed.follow(growing);
+    }
+    if (followed.digest() != expected)
+        return false;
+    
+    followed.reset();
+    followed.update(v);
+    return followed.digest() == expected;
+}
+
+void testHashing()
+{
+    // Published vectors
+    data digits = fromString("123456789");
+    CHECK(digits.crc32c() == 0xe3069283);
+    data abc = fromString("abc");
+    CHECK(abc.sha256() == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    CHECK(abc.xxh64() == 0x44bc2cf5ad770999ULL);
+    CHECK(abc.xxh3() == 0x78af5f94892f3950ULL);
+    data empty;
+    CHECK(empty.crc32c() == 0);
+    CHECK(empty.xxh64() == 0xef46db3751d8e999ULL);
+    CHECK(empty.xxh3() == 0x2d06800538d394c2ULL);
+    CHECK(empty.sha256() == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    
+    byte le[8];
+    crc32cHasher::digestBytes(0xe3069283, le);
+    CHECK(le[0] == 0x83 && le[3] == 0xe3);
+    
+    // Every length path
+    std::vector<byte> pattern(5000);
+    for (size_t i = 0; i < pattern.size(); i++)
+        pattern[i] = static_cast<byte>((i * 31 + 7) & 0xFF);
+    for (const knownHashes &e : vectors)
+    {
+        data d(pattern.data(), e.length);
+        CHECK(d.crc32c() == e.crc32c);
+        CHECK(d.xxh64() == e.xxh64);
+        CHECK(d.xxh3() == e.xxh3);
+        CHECK(d.sha256() == e.sha256);
+    }
+    
+    // Streaming
+    data::view all(pattern.data(), pattern.size());
+    CHECK(streamsLikeOneShot<crc32cHasher>(all));
+    CHECK(streamsLikeOneShot<xxh64Hasher>(all));
+    CHECK(streamsLikeOneShot<xxh3Hasher>(all));
+    CHECK(streamsLikeOneShot<sha256Hasher>(all));
+    CHECK(streamsLikeOneShot<xxh3Hasher>(all.slice(0, 241)));
+}
@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "check.h"
+
+// loadMany on io_uring and on threads, over every kind of file it treats differently: empty and
+// small regular files, ones larger than a read, missing ones and a FIFO, which is read until its
+// writer closes it. Every index must be passed to the callback exactly once.
+
+// Writes bytes into the FIFO at path once a reader opens it, then closes it.
+static std::thread feed(const std::string &path, const std::string &bytes)
+{
+    return std::thread([path, bytes]() {
+        int fd = open(path.c_str(), O_WRONLY);
+        size_t written = 0;
+        while (fd >= 0 && written < bytes.size())
+        {
+            ssize_t w = write(fd, bytes.data() + written, bytes.size() - written);
+            if (w <= 0)
+                break;
+            written += static_cast<size_t>(w);
+        }
+        if (fd >= 0)
+            close(fd);
+    });
+}
+
+void testLoading()
+{
+    std::string photo = readFile("photo.jpeg");
+    std::string small(100, 'x');
+    std::string large;
+    for (int i = 0; i < 7; i++)
+        large += photo;
+    std::string piped = photo.substr(0, 200000);
+    
+    std::vector<std::string> paths = {scratchPath("empty"), scratchPath("small"), "photo.jpeg", scratchPath("large"),
+                                      scratchPath("missing"), scratchPath("fifo")};
+    std::vector<std::string> expected = {"", small, photo, large, "", piped};
+    writeFile(paths[0], "");
+    writeFile(paths[1], small);
+    writeFile(paths[3], large);
+    std::remove(paths[4].c_str());
+    CHECK(mkfifo(paths[5].c_str(), 0600) == 0);
+    
+    for (bool uring : {true, false})
+    {
+        std::thread writer = feed(paths[5], piped);
+        std::mutex lock;
+        std::vector<int> calls(paths.size(), 0);
+        std::vector<std::string> bytes(paths.size());
+        std::vector<bool> loaded(paths.size(), false);
+        data::loadMany(paths, [&](size_t i, data &d, bool ok) {
+            std::lock_guard<std::mutex> hold(lock);
+            if (i >= paths.size())
+                return;
+            calls[i]++;
+            bytes[i] = d.digest();
+            loaded[i] = ok;
+        }, uring);
+        writer.join();
+        
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            CHECK(calls[i] == 1);
+            CHECK(bytes[i] == expected[i]);
+            CHECK(loaded[i] == (i != 4));
+        }
+    }
+    
+    // The futures, each holding its file, or an empty object for the missing one.
+    std::thread writer = feed(paths[5], piped);
+    std::vector<std::future<data>> futures = data::loadMany(paths);
+    CHECK(futures.size() == paths.size());
+    for (size_t i = 0; i < futures.size(); i++)
+        CHECK(futures[i].get().digest() == expected[i]);
+    writer.join();
+    
+    // No paths, no calls.
+    size_t none = 0;
+    data::loadMany(std::vector<std::string>(), [&](size_t, data &, bool) { none++; });
+    CHECK(none == 0);
+    CHECK(data::loadMany(std::vector<std::string>()).empty());
+    
+    for (const std::string &path : paths)
+        if (path != "photo.jpeg")
+            std::remove(path.c_str());
+}
@@ -56,8 +56,8 @@ int main()
     
     std::cout << "The bytes in that range currently are:" << std::endl;
     byte *bInRange = d2.bytesInRange(r);
-    for(int i = 0; i < r.rangeDistance() + 1; i++)
-        std::cout << bInRange[i] << "  ";
+    for(size_t i = 0; i < r.rangeDistance() + 1; i++)
+        std::cout << static_cast<int>(bInRange[i]) << "  ";
     std::cout << std::endl;
     delete [] bInRange;
     
@@ -112,7 +112,7 @@ int main()
 
 void printDataBuffer(data &d)
 {
-    for (int i = 0; i < d.size(); i++)
-        std::cout << d[i] << "  ";
+    for (size_t i = 0; i < d.size(); i++)
+        std::cout << static_cast<int>(d[i]) << "  ";
     std::cout << std::endl;
 }
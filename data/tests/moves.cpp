@@ -0,0 +1,42 @@
+#include <utility>
+#include "check.h"
+
+// Moves and swaps hand over inline, heap and piece table bytes without copying them through
+// anything that could throw.
+
+void testMoves()
+{
+    // A piece table over inline bytes keeps reading them once they moved, even after the
+    // object they came from is reused.
+    byte small[] = {1, 2, 3, 4, 5, 6, 7};
+    byte more[] = {8, 9};
+    data d(small, 7);
+    d.usePieceTable(true);
+    d.insertBytes(more, 2, 3);
+    data moved(std::move(d));
+    CHECK(d.size() == 0);
+    CHECK(moved.isPieceTable());
+    
+    byte other[] = {0, 0, 0, 0, 0, 0, 0};
+    d.insertBytes(other, 7, 0);
+    CHECK(holds(moved, {1, 2, 3, 8, 9, 4, 5, 6, 7}));
+    moved.removeByteAt(0);
+    CHECK(holds(moved, {2, 3, 8, 9, 4, 5, 6, 7}));
+    
+    data assigned;
+    assigned = std::move(moved);
+    data::range all(0, 6);
+    d.overrideBytes(small, 7, all);
+    CHECK(holds(assigned, {2, 3, 8, 9, 4, 5, 6, 7}));
+    CHECK(assigned.digest() == std::string("\x02\x03\x08\x09\x04\x05\x06\x07", 8));
+    
+    // Swapping exchanges inline and heap bytes alike.
+    std::string longer(100, 'x');
+    data heap(reinterpret_cast<const byte *>(longer.data()), longer.size());
+    data inlined(small, 3);
+    inlined.usePieceTable(true);
+    inlined.appendByte(4);
+    swap(heap, inlined);
+    CHECK(holds(heap, {1, 2, 3, 4}));
+    CHECK(inlined.size() == 100 && inlined[99] == 'x');
+}
@@ -0,0 +1,57 @@
+#include <cstdio>
+#include <string>
+#include "check.h"
+#include "../resource.h"
+
+// Parallel and O_DIRECT reads and writes of files spanning several chunks, with ends and dirty
+// extents off the block boundaries, and buffers that are not aligned for O_DIRECT.
+
+void testParallel()
+{
+    std::string path = scratchPath("parallel.bin");
+    std::string other = scratchPath("parallel_other.bin");
+    size_t length = 3 * data::parallelChunk + 12345;
+    std::string pattern(length, '\0');
+    for (size_t i = 0; i < length; i++)
+        pattern[i] = static_cast<char>(i * 2654435761u >> 13);
+    const byte *p = reinterpret_cast<const byte *>(pattern.data());
+    
+    for (bool direct : {false, true})
+    {
+        // Whole saves
+        data d(p, length);
+        d.useParallelIO(4, direct);
+        d.saveToPath(path);
+        CHECK(readFile(path) == pattern);
+        d.saveToPath(other, data::atomicReplace);
+        CHECK(readFile(other) == pattern);
+        
+        // Loads
+        data loaded(path, direct ? data::parallelDirect : data::parallel);
+        CHECK(!loaded.isMapped() && loaded.digest() == pattern);
+        
+        // A dirty extent from an unaligned offset to the end, written in place.
+        byte b[] = {1, 2, 3};
+        loaded.insertBytes(b, 3, 1001);
+        loaded.save();
+        CHECK(readFile(path) == pattern.substr(0, 1001) + "\x01\x02\x03" + pattern.substr(1001));
+        
+        // Shrinking in place cuts the file.
+        loaded.removeBytesIn(data::range(0, data::parallelChunk - 1));
+        loaded.save();
+        CHECK(readFile(path) == loaded.digest());
+        CHECK(loaded.size() == length + 3 - data::parallelChunk);
+        
+        // A buffer that O_DIRECT cannot use, placed after a byte of the same chunk, is written
+        // the ordinary way.
+        arenaResource arena(2 * length);
+        CHECK(arena.allocate(1, 1) != nullptr);
+        data unaligned(p, length, &arena);
+        unaligned.useParallelIO(4, direct);
+        unaligned.saveToPath(other);
+        CHECK(readFile(other) == pattern);
+    }
+    
+    std::remove(path.c_str());
+    std::remove(other.c_str());
+}
@@ -0,0 +1,158 @@
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "check.h"
+#include "../resource.h"
+
+// The buffers of data come from its resource and go back to it, and the resources of resource.h
+// serve them the way they promise: arenas from a few chunks, pools from reused blocks and large
+// buffers from huge page aligned mappings.
+
+// Counts what passes through to the new/delete resource.
+class countingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;     // The amount of allocations so far.
+    size_t outstanding = 0;     // The bytes allocated and not given back.
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        allocations++;
+        outstanding += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+static void fillPattern(data &d, size_t n)
+// Postcondition: Appends byte i * 7 at every index i from the size of d up to n.
+{
+    for (size_t i = d.size(); i < n; i++)
+        d.appendByte(static_cast<byte>(i * 7));
+}
+
+static bool holdsPattern(data &d, size_t n)
+// Postcondition: Returns true if d holds the first n bytes of that pattern.
+{
+    if (d.size() != n)
+        return false;
+    for (size_t i = 0; i < n; i++)
+        if (d[i] != static_cast<byte>(i * 7))
+            return false;
+    return true;
+}
+
+void testResources()
+{
+    // Every buffer comes from the resource and goes back to it.
+    countingResource counting;
+    {
+        data d(&counting);
+        CHECK(d.memoryResource() == &counting);
+        fillPattern(d, 32);
+        CHECK(counting.allocations == 0);
+        fillPattern(d, 10000);
+        CHECK(counting.allocations > 0 && counting.outstanding >= 10000);
+        
+        data copied(d, &counting);
+        CHECK(copied.memoryResource() == &counting && holdsPattern(copied, 10000));
+        data defaulted(d);
+        CHECK(defaulted.memoryResource() == std::pmr::get_default_resource());
+        
+        data moved(std::move(copied));
+        CHECK(moved.memoryResource() == &counting && holdsPattern(moved, 10000));
+        defaulted = d;
+        CHECK(defaulted.memoryResource() == std::pmr::get_default_resource() && holdsPattern(defaulted, 10000));
+        defaulted = std::move(moved);
+        CHECK(defaulted.memoryResource() == &counting);
+        
+        d.shrinkToFit();
+        CHECK(holdsPattern(d, 10000));
+    }
+    CHECK(counting.outstanding == 0);
+    
+    // Arenas serve many buffers from a few chunks, and take back only the latest one.
+    countingResource upstream;
+    {
+        arenaResource arena(64 * 1024, &upstream);
+        for (int i = 0; i < 100; i++)
+        {
+            data d(&arena);
+            fillPattern(d, 1000);
+            CHECK(holdsPattern(d, 1000));
+        }
+        CHECK(upstream.allocations <= 2);
+        CHECK(arena.bytesReserved() == upstream.outstanding);
+        
+        void *a = arena.allocate(100, 8);
+        void *b = arena.allocate(100, 8);
+        arena.deallocate(b, 100, 8);
+        CHECK(arena.allocate(100, 8) == b);
+        arena.deallocate(a, 100, 8);
+        CHECK(arena.allocate(100, 8) != a);
+        
+        void *big = arena.allocate(1024 * 1024, 64);
+        CHECK(reinterpret_cast<uintptr_t>(big) % 64 == 0);
+        size_t reserved = arena.bytesReserved();
+        arena.release();
+        CHECK(arena.bytesReserved() < reserved && arena.bytesReserved() >= 1024 * 1024);
+    }
+    CHECK(upstream.outstanding == 0);
+    
+    // Pools reuse the blocks of a size class, and send larger buffers upstream.
+    {
+        poolResource pool(4096, &upstream);
+        void *a = pool.allocate(100, 8);
+        pool.deallocate(a, 100, 8);
+        CHECK(pool.allocate(128, 8) == a);
+        
+        size_t slabs = upstream.allocations;
+        std::vector<void *> blocks;
+        for (int i = 0; i < 100; i++)
+            blocks.push_back(pool.allocate(64, 8));
+        CHECK(upstream.allocations - slabs <= 1);
+        for (void *p : blocks)
+            pool.deallocate(p, 64, 8);
+        
+        size_t before = upstream.allocations;
+        void *large = pool.allocate(8192, 8);
+        CHECK(upstream.allocations == before + 1);
+        pool.deallocate(large, 8192, 8);
+        
+        data d(&pool);
+        fillPattern(d, 3000);
+        data e(d, &pool);
+        CHECK(holdsPattern(d, 3000) && holdsPattern(e, 3000));
+    }
+    CHECK(upstream.outstanding == 0);
+    
+    // Huge page buffers are aligned to huge pages; small ones come from upstream.
+    {
+        hugePageResource huge(hugePageResource::hugePageSize, &upstream);
+        void *small = huge.allocate(4096, 8);
+        CHECK(upstream.outstanding == 4096);
+        huge.deallocate(small, 4096, 8);
+        
+        void *p = huge.allocate(3 * 1024 * 1024, 64);
+        CHECK(reinterpret_cast<uintptr_t>(p) % hugePageResource::hugePageSize == 0);
+        CHECK(upstream.outstanding == 0);
+        huge.deallocate(p, 3 * 1024 * 1024, 64);
+        
+        data d(&huge);
+        d.reserve(4 * 1024 * 1024);
+        fillPattern(d, 4 * 1024 * 1024);
+        CHECK(reinterpret_cast<uintptr_t>(d.begin()) % hugePageResource::hugePageSize == 0);
+        CHECK(holdsPattern(d, 4 * 1024 * 1024));
+    }
+    CHECK(upstream.outstanding == 0);
+}
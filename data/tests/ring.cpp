@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <string>
+#include <thread>
+#include "check.h"
+#include "../ring.h"
+
+// A producer streaming many times the capacity of a ringBuffer to a consumer, both in pieces of
+// odd sizes so that every span ends up wrapping over the mirror, and the ring buffer mode of data.
+
+// Returns the byte expected at position p of the stream.
+static byte streamed(uint64_t p)
+{
+    return static_cast<byte>((p * 131 + (p >> 12)) & 0xFF);
+}
+
+void testRing()
+{
+    CHECK(mirrorGranularity() > 0);
+    
+    // A single thread filling the ring, and taking bytes through spans that wrap.
+    {
+        ringBuffer ring(1);
+        size_t length = ring.capacity();
+        CHECK(length == mirrorGranularity());
+        std::string bytes(length + 100, '\0');
+        for (size_t i = 0; i < bytes.size(); i++)
+            bytes[i] = static_cast<char>(streamed(i));
+        const byte *b = reinterpret_cast<const byte *>(bytes.data());
+        
+        CHECK(ring.tryWrite(b, length + 100) == length);
+        CHECK(ring.size() == length && ring.tryWrite(b, 1) == 0);
+        size_t room = 1;
+        ring.writeSpan(room);
+        CHECK(room == 0);
+        
+        byte out[200];
+        CHECK(ring.tryRead(out, 150) == 150);
+        CHECK(std::string(reinterpret_cast<char *>(out), 150) == bytes.substr(0, 150));
+        
+        // The room left after reading spans the end of the ring, and is contiguous anyway.
+        room = 0;
+        byte *span = ring.writeSpan(room);
+        CHECK(room == 150);
+        std::copy(b + length, b + length + 100, span);
+        ring.commitWrite(100);
+        
+        data::view waiting = ring.readSpan();
+        CHECK(waiting.size() == length - 50);
+        CHECK(waiting.digest() == bytes.substr(150, length - 50));
+        ring.consume(waiting.size());
+        CHECK(ring.size() == 0 && ring.tryRead(out, 1) == 0);
+        
+        ring.close();
+        CHECK(ring.closed() && ring.read(out, 10) == 0);
+    }
+    
+    // A producer and a consumer streaming more than ten times the capacity.
+    {
+        ringBuffer ring(1);
+        const uint64_t total = 10 * ring.capacity() + 12345;
+        std::thread producer([&ring, total]() {
+            static const size_t sizes[] = {1, 7, 4093, 4097, 13, 8191, 2};
+            byte chunk[8191];
+            uint64_t p = 0;
+            for (size_t k = 0; p < total; k++)
+            {
+                size_t n = static_cast<size_t>(std::min<uint64_t>(sizes[k % 7], total - p));
+                for (size_t i = 0; i < n; i++)
+                    chunk[i] = streamed(p + i);
+                ring.write(chunk, n);
+                p += n;
+            }
+            ring.close();
+        });
+        
+        static const size_t sizes[] = {3, 5000, 1, 4096, 777};
+        byte out[5000];
+        uint64_t p = 0;
+        size_t wrong = 0;
+        for (size_t k = 0;; k++)
+        {
+            size_t n = ring.read(out, sizes[k % 5]);
+            for (size_t i = 0; i < n; i++)
+                wrong += out[i] != streamed(p + i);
+            p += n;
+            if (n < sizes[k % 5])
+                break;
+        }
+        producer.join();
+        
+        CHECK(p == total);
+        CHECK(wrong == 0);
+        CHECK(ring.closed() && ring.read(out, 1) == 0);
+    }
+    
+    // The ring buffer mode of data keeps the newest bytes, also after dropping and appending some.
+    {
+        std::string photo = readFile("photo.jpeg");
+        data d(reinterpret_cast<const byte *>(photo.data()), photo.size());
+        CHECK(d.useRingBuffer(4096));
+        CHECK(d.isRingBuffer() && d.size() == d.capacity());
+        std::string kept = photo.substr(photo.size() - d.size());
+        CHECK(d.digest() == kept);
+        
+        CHECK(d.popFront(1000) == 1000);
+        kept.erase(0, 1000);
+        for (int i = 0; i < 1500; i++)
+        {
+            d.appendByte(static_cast<byte>(i));
+            kept += static_cast<char>(i);
+        }
+        kept.erase(0, kept.size() - d.capacity());
+        CHECK(d.size() == d.capacity() && d.digest() == kept);
+        
+        data bounded;
+        CHECK(bounded.useRingBuffer(10, false));
+        for (size_t i = 0; i < bounded.capacity(); i++)
+            bounded.appendByte(1);
+        bounded.appendByte(2);
+        CHECK(bounded.size() == bounded.capacity() && bounded[bounded.size() - 1] == 1);
+    }
+}
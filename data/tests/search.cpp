@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "../search.h"
+
+// The searches against a naive scan, with needles of the lengths the vector loops treat
+// differently (memchr for 1 byte, the filter for 2 to 32 and past a whole 32-byte block) at
+// offsets on either side of the 16 and 32-byte blocks, on unaligned views and on inputs where the
+// filter keeps failing. The pattern scanner is compared the same way, in its documented order.
+
+// Returns the first index at or after from where needle starts, or data::notFound.
+static size_t naiveFind(const std::string &h, const std::string &needle, size_t from)
+{
+    for (size_t i = from; i <= h.size() && needle.size() <= h.size() - i; i++)
+    {
+        if (h.compare(i, needle.size(), needle) == 0)
+            return i;
+    }
+    return data::notFound;
+}
+
+// Returns the last index at or before before where needle starts, or data::notFound.
+static size_t naiveRfind(const std::string &h, const std::string &needle, size_t before)
+{
+    if (needle.size() > h.size())
+        return data::notFound;
+    
+    for (size_t i = std::min(before, h.size() - needle.size()) + 1; i-- > 0;)
+    {
+        if (h.compare(i, needle.size(), needle) == 0)
+            return i;
+    }
+    return data::notFound;
+}
+
+// Returns a view of the bytes of s.
+static data::view viewOf(const std::string &s)
+{
+    return data::view(reinterpret_cast<const byte *>(s.data()), s.size());
+}
+
+// Returns n pseudo-random bytes out of the first letters of the alphabet, so partial matches are common.
+static std::string randomText(size_t n, unsigned &seed, int letters)
+{
+    std::string s(n, ' ');
+    for (char &c : s)
+    {
+        seed = seed * 1103515245 + 12345;
+        c = static_cast<char>('a' + (seed >> 16) % letters);
+    }
+    return s;
+}
+
+// Returns true if every search of needle in a view of h agrees with the naive scan.
+static bool agrees(const std::string &h, const std::string &needle)
+{
+    data::view v = viewOf(h);
+    data::view n = viewOf(needle);
+    for (size_t from = 0; from <= h.size() + 1; from++)
+    {
+        if (v.find(n, from) != naiveFind(h, needle, from) || v.rfind(n, from) != naiveRfind(h, needle, from))
+            return false;
+    }
+    return v.rfind(n) == naiveRfind(h, needle, data::notFound);
+}
+
+void testSearch()
+{
+    unsigned seed = 7;
+    std::string h = randomText(200, seed, 3);
+    
+    // Needles taken from the haystack, starting at 0, on both sides of the 16 and 32-byte blocks
+    // and ending at the very last byte.
+    for (size_t m : {1, 2, 16, 32, 33})
+    {
+        for (size_t at : {size_t(0), size_t(15), size_t(16), size_t(31), size_t(32), size_t(63), size_t(64), h.size() - m})
+        {
+            std::string needle = h.substr(at, m);
+            CHECK(agrees(h, needle));
+            CHECK(naiveFind(h, needle, at) == at);
+        }
+        CHECK(agrees(h, std::string(m, 'z')));
+        CHECK(agrees(h, h.substr(0, m - 1) + "z"));
+    }
+    
+    // Matches that only exist at the ends.
+    std::string ends = std::string(100, 'a');
+    ends.replace(0, 33, std::string(33, 'b'));
+    ends.replace(67, 33, std::string(33, 'c'));
+    for (size_t m : {1, 2, 16, 32, 33})
+    {
+        CHECK(agrees(ends, std::string(m, 'b')));
+        CHECK(agrees(ends, std::string(m, 'c')));
+        CHECK(viewOf(ends).find(viewOf(std::string(m, 'c'))) == 67);
+        CHECK(viewOf(ends).rfind(viewOf(std::string(m, 'b'))) == 33 - m);
+    }
+    
+    // The same searches on views that start off the alignment of the haystack.
+    for (size_t skip = 1; skip < 4; skip++)
+    {
+        std::string shifted = h.substr(skip);
+        for (size_t m : {2, 16, 33})
+            CHECK(agrees(shifted, shifted.substr(shifted.size() - m)));
+    }
+    
+    // Long runs where the filter keeps passing and the search hands over to memmem.
+    std::string runs(20000, 'a');
+    runs.back() = 'b';
+    for (size_t m : {2, 16, 32, 33})
+    {
+        std::string needle = std::string(m - 1, 'a') + "b";
+        CHECK(viewOf(runs).find(viewOf(needle)) == runs.size() - m);
+        CHECK(viewOf(runs).rfind(viewOf(needle)) == runs.size() - m);
+        CHECK(viewOf(runs).find(viewOf(std::string(m, 'b'))) == data::notFound);
+    }
+    
+    // Needles longer than the haystack, and empty ones.
+    std::string shortText = "abc";
+    for (const std::string &needle : {std::string("abcd"), h})
+    {
+        CHECK(viewOf(shortText).find(viewOf(needle)) == data::notFound);
+        CHECK(viewOf(shortText).rfind(viewOf(needle)) == data::notFound);
+    }
+    CHECK(agrees(shortText, ""));
+    CHECK(viewOf(shortText).find(data::view(), 3) == 3);
+    CHECK(viewOf(shortText).find(data::view(), 4) == data::notFound);
+    CHECK(viewOf(shortText).rfind(data::view()) == 3);
+    CHECK(data::view().find(data::view()) == 0);
+    
+    // The members of data, which flatten a piece table first.
+    data d(reinterpret_cast<const byte *>(h.data()), h.size());
+    d.usePieceTable(true);
+    byte inserted[] = {'z', 'z'};
+    d.insertBytes(inserted, 2, 100);
+    std::string edited = h.substr(0, 100) + "zz" + h.substr(100);
+    std::string needle = edited.substr(95, 16);
+    const byte *nb = reinterpret_cast<const byte *>(needle.data());
+    std::vector<size_t> all;
+    for (size_t i = naiveFind(edited, needle, 0); i != data::notFound; i = naiveFind(edited, needle, i + 1))
+        all.push_back(i);
+    CHECK(d.find(nb, needle.size()) == naiveFind(edited, needle, 0));
+    CHECK(d.rfind(nb, needle.size()) == naiveRfind(edited, needle, data::notFound));
+    CHECK(d.findAll(nb, needle.size()) == all);
+    CHECK(d.countOf(nb, 1) == static_cast<size_t>(std::count(edited.begin(), edited.end(), needle[0])));
+    CHECK(d.find(nb, 0, 5) == 5);
+    CHECK(d.findAll(nb, 0).empty() && d.countOf(nb, 0) == 0);
+    
+    // A scanner with overlapping patterns and patterns that are prefixes of others, against every
+    // pattern tried at every end, in the order the scans report them.
+    std::vector<std::string> sets[] = {
+        {"he", "she", "his", "hers", "h", "ee", "eee"},
+        {"ab", "abc", "abcab", "a"},
+        {"ba", "ca", "aab", "c"},
+    };
+    for (const std::vector<std::string> &patterns : sets)
+    {
+        patternScanner scanner;
+        for (const std::string &p : patterns)
+            scanner.addPattern(p);
+        CHECK(scanner.patternCount() == patterns.size());
+        CHECK(scanner.patternLength(patterns.size() - 1) == patterns.back().size());
+        
+        std::string text = randomText(3000, seed, 6);
+        for (char &c : text)
+            c = c == 'd' ? 'h' : c == 'f' ? 's' : c;
+        for (size_t skip : {0, 1, 3})
+        {
+            std::string scanned = text.substr(skip);
+            std::vector<patternScanner::match> expected;
+            for (size_t end = 0; end < scanned.size(); end++)
+            {
+                for (size_t id = 0; id < patterns.size(); id++)
+                {
+                    size_t m = patterns[id].size();
+                    if (m <= end + 1 && scanned.compare(end + 1 - m, m, patterns[id]) == 0)
+                        expected.push_back({end + 1 - m, id});
+                }
+            }
+            
+            data source(reinterpret_cast<const byte *>(text.data()), text.size());
+            data::view v = source.viewAll().slice(skip, scanned.size());
+            std::vector<patternScanner::match> found = scanner.scan(v);
+            bool same = found.size() == expected.size();
+            for (size_t i = 0; same && i < found.size(); i++)
+                same = found[i].offset == expected[i].offset && found[i].pattern == expected[i].pattern;
+            CHECK(same);
+            CHECK(scanner.countMatches(v) == expected.size());
+            
+            size_t calls = 0;
+            scanner.scan(v, [&](const patternScanner::match &m) {
+                calls += calls < expected.size() && m.offset == expected[calls].offset && m.pattern == expected[calls].pattern;
+            });
+            CHECK(calls == expected.size());
+        }
+    }
+    
+    // Patterns added after a scan are compiled into the next one.
+    patternScanner late;
+    late.addPattern("x");
+    CHECK(late.countMatches(viewOf("xyxy")) == 2);
+    late.addPattern("xy");
+    CHECK(late.countMatches(viewOf("xyxy")) == 4);
+    CHECK(late.countMatches(data::view()) == 0);
+}
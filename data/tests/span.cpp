@@ -0,0 +1,33 @@
+#include <cstddef>
+#include <vector>
+#include "check.h"
+
+// The span overloads only exist in C++20 code, so only data_test_cpp20 runs these checks.
+
+void testSpan()
+{
+#if DATA_HAS_SPAN
+    std::vector<byte> v = {1, 2, 3, 4};
+    std::span<const byte> all(v);
+    data d(all);
+    CHECK(holds(d, {1, 2, 3, 4}));
+    
+    byte extra[] = {9, 8};
+    d.insertBytes(std::span<const byte>(extra), 2);
+    CHECK(holds(d, {1, 2, 9, 8, 3, 4}));
+    data::range r(0, 1);
+    d.overrideBytes(std::span<const byte>(extra, 1), r);
+    CHECK(holds(d, {9, 9, 8, 3, 4}));
+    
+    std::span<const byte> s = d.asSpan();
+    CHECK(s.size() == 5 && s.data() == d.begin() && s[4] == 4);
+    std::span<const std::byte> bs = d.asByteSpan();
+    CHECK(bs.size() == 5 && bs[0] == std::byte{9});
+    
+    // Spans of a piece table see its edits, flattened.
+    d.usePieceTable(true);
+    d.insertBytes(std::span<const byte>(extra), 5);
+    s = d.asSpan();
+    CHECK(s.size() == 7 && s[5] == 9 && s[6] == 8);
+#endif
+}
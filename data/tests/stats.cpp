@@ -0,0 +1,124 @@
+#include <sstream>
+#include <string>
+#include "check.h"
+
+// The counters after a known sequence of edits, and the histogram they dump. Built without
+// DATA_STATS, data objects count nothing, but the histograms of dataStats itself still dump.
+
+// Returns the value of the line starting with metric in a dump, or -1 if there is none.
+static long long metric(const std::string &dump, const std::string &name)
+{
+    std::istringstream lines(dump);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        if (line.compare(0, name.size() + 1, name + " ") == 0)
+            return std::stoll(line.substr(name.size() + 1));
+    }
+    return -1;
+}
+
+// Returns true if the bucket lines of op in the dump are cumulative and end at its call count.
+static bool cumulative(const std::string &dump, const dataStats &s, dataStats::operation op)
+{
+    std::string name = std::string("{object=\"test\",operation=\"") + dataStats::operationName(op) + "\"";
+    long long previous = 0;
+    for (size_t k = 0; k + 1 < dataStats::buckets; k++)
+    {
+        long long n = metric(dump, "data_operation_latency_nanoseconds_bucket" + name + ",le=\"" +
+                                   std::to_string((uint64_t(2) << k) - 1) + "\"}");
+        if (n < previous)
+            return false;
+        previous = n;
+    }
+    long long all = metric(dump, "data_operation_latency_nanoseconds_bucket" + name + ",le=\"+Inf\"}");
+    return previous <= all && all == static_cast<long long>(s.calls[op]) &&
+           metric(dump, "data_operation_latency_nanoseconds_count" + name + "}") == all &&
+           metric(dump, "data_operation_latency_nanoseconds_sum" + name + "}") == static_cast<long long>(s.nanoseconds[op]);
+}
+
+void testStats()
+{
+    // Known latencies land in the buckets of their power of two, the last one past 2^39 ns.
+    dataStats known;
+    for (uint64_t ns : {uint64_t(0), uint64_t(1), uint64_t(5), uint64_t(1000), uint64_t(1) << 50})
+        known.recordLatency(dataStats::loadOp, ns);
+    std::ostringstream histogram;
+    known.dump(histogram, "object=\"test\"");
+    std::string h = histogram.str();
+    std::string load = "data_operation_latency_nanoseconds_bucket{object=\"test\",operation=\"load\",le=";
+    CHECK(metric(h, load + "\"1\"}") == 2);
+    CHECK(metric(h, load + "\"3\"}") == 2);
+    CHECK(metric(h, load + "\"7\"}") == 3);
+    CHECK(metric(h, load + "\"511\"}") == 3);
+    CHECK(metric(h, load + "\"1023\"}") == 4);
+    CHECK(metric(h, load + "\"549755813887\"}") == 4);
+    CHECK(metric(h, load + "\"+Inf\"}") == 5);
+    CHECK(cumulative(h, known, dataStats::loadOp));
+    CHECK(h.find("operation=\"save\"") == std::string::npos);
+    CHECK(metric(h, "data_allocations_total{object=\"test\"}") == 0);
+    
+    // Appending past the inline bytes, shifting for every edit that is not at the end, and
+    // growing again to take 40 more bytes.
+    data d;
+    dataStats::resetProcess();
+    byte b[40] = {};
+    for (int i = 0; i < 33; i++)
+        d.appendByte(static_cast<byte>(i));
+    d.prependByte(0);
+    d.insertBytes(b, 4, 10);
+    data::range same(0, 3);
+    d.overrideBytes(b, 4, same);
+    data::range shorter(0, 1);
+    d.overrideBytes(b, 4, shorter);
+    d.removeByteAt(0);
+    d.removeBytesIn(data::range(0, 9));
+    d.insertBytes(b, 40, d.size());
+    CHECK(d.size() == 69);
+    
+    dataStats s = d.statistics();
+    std::ostringstream out;
+    s.dump(out, "object=\"test\"");
+    std::string dump = out.str();
+#if DATA_STATS
+    CHECK(s.allocations == 2 && s.bytesAllocated == 64 + 128);
+    CHECK(s.reallocations == 2);
+    CHECK(s.bytesCopied == 32 + 33 + 24 + 36 + 39 + 29 + 29);
+    CHECK(s.peakCapacity == 128);
+    CHECK(s.calls[dataStats::appendOp] == 33);
+    CHECK(s.calls[dataStats::prependOp] == 1);
+    CHECK(s.calls[dataStats::insertOp] == 2);
+    CHECK(s.calls[dataStats::overrideOp] == 2);
+    CHECK(s.calls[dataStats::removeOp] == 2);
+    CHECK(s.calls[dataStats::loadOp] == 0 && s.calls[dataStats::copyOp] == 0);
+    
+    dataStats all = dataStats::process();
+    CHECK(all.allocations == s.allocations && all.bytesCopied == s.bytesCopied);
+    CHECK(all.calls[dataStats::appendOp] == 33);
+    
+    CHECK(metric(dump, "data_allocations_total{object=\"test\"}") == 2);
+    CHECK(metric(dump, "data_reallocations_total{object=\"test\"}") == 2);
+    CHECK(metric(dump, "data_copied_bytes_total{object=\"test\"}") == 222);
+    for (dataStats::operation op : {dataStats::appendOp, dataStats::prependOp, dataStats::insertOp,
+                                    dataStats::overrideOp, dataStats::removeOp})
+        CHECK(cumulative(dump, s, op));
+    CHECK(dump.find("operation=\"load\"") == std::string::npos);
+    
+    // A copy counts its own buffer and bytes; the original keeps its counters.
+    data copy(d);
+    dataStats c = copy.statistics();
+    CHECK(c.allocations == 1 && c.bytesAllocated == 128 && c.bytesCopied == 69);
+    CHECK(c.calls[dataStats::copyOp] == 1 && c.calls[dataStats::appendOp] == 0);
+    CHECK(d.statistics().allocations == 2);
+    
+    // The counters stay with the object when its content moves, and reset to 0.
+    data moved(std::move(d));
+    CHECK(d.statistics().calls[dataStats::appendOp] == 33);
+    CHECK(moved.statistics().calls[dataStats::appendOp] == 0);
+    d.resetStatistics();
+    CHECK(d.statistics().allocations == 0 && d.statistics().calls[dataStats::appendOp] == 0);
+#else
+    CHECK(s.allocations == 0 && s.bytesCopied == 0 && s.calls[dataStats::appendOp] == 0);
+    CHECK(metric(dump, "data_allocations_total{object=\"test\"}") == 0);
+#endif
+}
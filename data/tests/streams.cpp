@@ -0,0 +1,101 @@
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include "check.h"
+#include "../resource.h"
+
+// Reading streams into data with >>: the bytes are replaced, while the ring, the capacity limit
+// and the resource stay as they were. readFrom stops at its limit on streams and pipes, and
+// hexDump matches the lines of xxd.
+
+void testStreams()
+{
+    std::string text(100000, '\0');
+    for (size_t i = 0; i < text.size(); i++)
+        text[i] = static_cast<char>(i * 31 + i / 7);
+    
+    data plain;
+    std::istringstream in(text);
+    CHECK(static_cast<bool>(in >> plain));
+    CHECK(plain.digest() == text);
+    
+    // An overwriting ring keeps the newest bytes, and stays a ring.
+    data ring;
+    CHECK(ring.useRingBuffer(4096));
+    size_t length = ring.capacity();
+    byte old[] = {1, 2, 3};
+    ring.insertBytes(old, 3, 0);
+    std::istringstream toRing(text);
+    toRing >> ring;
+    CHECK(ring.isRingBuffer() && ring.capacity() == length);
+    CHECK(ring.digest() == text.substr(text.size() - length));
+    
+    // A capacity limit stops the read.
+    data limited(100);
+    limited.insertBytes(old, 3, 0);
+    std::istringstream toLimited(text);
+    toLimited >> limited;
+    CHECK(limited.bufferCapacity() == 100 && limited.digest() == text.substr(0, 100));
+    
+    // The resource stays too, and piece tables are dropped with the bytes.
+    arenaResource arena;
+    data pieces(&arena);
+    pieces.usePieceTable(true);
+    pieces.insertBytes(old, 3, 0);
+    std::istringstream toPieces(text);
+    toPieces >> pieces;
+    CHECK(pieces.memoryResource() == &arena && pieces.digest() == text);
+    
+    // Mapped bytes are dropped, not copied out.
+    std::string path = scratchPath("streams.bin");
+    writeFile(path, text);
+    data mapped(path, data::mapped);
+    CHECK(mapped.isMapped());
+    std::istringstream small("abc");
+    small >> mapped;
+    CHECK(!mapped.isMapped() && mapped.digest() == "abc");
+    std::remove(path.c_str());
+    
+    // Nothing left to read fails the stream.
+    std::istringstream empty("");
+    CHECK(!static_cast<bool>(empty >> plain));
+    CHECK(plain.size() == 0);
+    
+    std::ostringstream out;
+    out << limited;
+    CHECK(out.str() == "<100 bytes>");
+    
+    // readFrom takes no more than its limit from a stream, and appends the rest on the next call.
+    data appended;
+    std::istringstream toAppended(text);
+    CHECK(appended.readFrom(toAppended, 300) == 300);
+    CHECK(!toAppended.eof() && appended.digest() == text.substr(0, 300));
+    CHECK(appended.readFrom(toAppended) == text.size() - 300);
+    CHECK(toAppended.eof() && appended.digest() == text);
+    
+    // And from a pipe holding more than the limit.
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    CHECK(write(fds[1], text.data(), 1000) == 1000);
+    close(fds[1]);
+    data piped;
+    CHECK(piped.readFrom(fds[0], 400) == 400);
+    CHECK(piped.digest() == text.substr(0, 400));
+    CHECK(piped.readFrom(fds[0]) == 600);
+    CHECK(piped.digest() == text.substr(0, 1000));
+    CHECK(piped.readFrom(fds[0]) == 0);
+    close(fds[0]);
+    
+    // hexDump against xxd, with a partial last line and offsets that need a ninth digit.
+    std::ostringstream hello;
+    data greeting(reinterpret_cast<const byte *>("Hello, world!\n"), 14);
+    greeting.hexDump(hello);
+    CHECK(hello.str() == "00000000: 4865 6c6c 6f2c 2077 6f72 6c64 210a       Hello, world!.\n");
+    
+    std::string photo = readFile("photo.jpeg");
+    std::ostringstream far;
+    data::hexDump(far, data::view(reinterpret_cast<const byte *>(photo.data()), 20), 0xFFFFFFF8);
+    CHECK(far.str() == "fffffff8: ffd8 ffe0 0010 4a46 4946 0001 0101 012c  ......JFIF.....,\n"
+                       "100000008: 012c 0000                                .,..\n");
+}
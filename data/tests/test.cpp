@@ -0,0 +1,79 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include "check.h"
+
+static size_t checks = 0;      // The amount of checks run.
+static size_t failures = 0;    // The amount of those that failed.
+
+int main()
+{
+    testBasics();
+    testMoves();
+    testEncoding();
+    testHashing();
+    testGrowth();
+    testDelta();
+    testEdits();
+    testParallel();
+    testLoading();
+    testCompression();
+    testConcurrent();
+    testResources();
+    testRing();
+    testFixed();
+    testSearch();
+    testSpan();
+    testStats();
+    testStreams();
+    testViews();
+    testWritable();
+    
+    std::cout << checks << " checks, " << failures << " failed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+void check(bool passed, const char *expression, const char *file, int line)
+{
+    checks++;
+    if (passed)
+        return;
+    
+    failures++;
+    std::cout << "FAILED " << file << ":" << line << ": " << expression << std::endl;
+}
+
+bool holds(data &d, std::initializer_list<int> expected)
+{
+    if (d.size() != expected.size())
+        return false;
+    
+    size_t i = 0;
+    for (int b : expected)
+    {
+        if (d[i++] != b)
+            return false;
+    }
+    return true;
+}
+
+std::string scratchPath(const std::string &name)
+{
+    return "test_" + std::to_string(getpid()) + "_" + name;
+}
+
+std::string readFile(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream s;
+    s << in.rdbuf();
+    return s.str();
+}
+
+void writeFile(const std::string &path, const std::string &bytes)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
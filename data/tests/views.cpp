@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include "check.h"
+
+// Saving a file while another mapping of it is alive: views shared from it, other objects that
+// loaded it, or the original of a copy. Writing into or truncating the file would change what
+// they read, or take their pages away (SIGBUS), so it must be replaced.
+
+static std::string contents(const data::sharedView &v)
+{
+    return std::string(reinterpret_cast<const char *>(v.begin()), v.size());
+}
+
+static ino_t inodeOf(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_ino : 0;
+}
+
+void testViews()
+{
+    std::string photo = readFile("photo.jpeg");
+    std::string path = scratchPath("views.jpeg");
+    
+    // A removal shrinks the file; the view keeps every page of the old one.
+    writeFile(path, photo);
+    {
+        data d(path, data::mapped);
+        CHECK(d.isMapped());
+        data::sharedView v = d.shareAll();
+        d.removeBytesIn(data::range(0, 99999));
+        d.save();
+        CHECK(contents(v) == photo);
+        CHECK(readFile(path) == photo.substr(100000));
+    }
+    
+    // A same-size override, which would otherwise patch the file in place.
+    writeFile(path, photo);
+    {
+        data d(path, data::mapped);
+        data::sharedView v = d.shareAll();
+        byte b[] = {1, 2, 3};
+        data::range r(4096, 4098);
+        d.overrideBytes(b, 3, r);
+        d.save();
+        CHECK(contents(v) == photo);
+        CHECK(readFile(path) == photo.substr(0, 4096) + "\x01\x02\x03" + photo.substr(4099));
+        
+        // Once the views are gone, saves write into the file again.
+        v = data::sharedView();
+        ino_t inode = inodeOf(path);
+        d.overrideBytes(b, 3, r);
+        d.save();
+        CHECK(inodeOf(path) == inode);
+    }
+    
+    // Piece table edits of a mapping that is still shared.
+    writeFile(path, photo);
+    {
+        data d(path, data::mapped);
+        d.usePieceTable(true);
+        data::sharedView v = d.shareAll();
+        byte b[] = {7, 7};
+        d.insertBytes(b, 2, 10);
+        d.removeBytesIn(data::range(200000, 299999));
+        d.save();
+        CHECK(contents(v) == photo);
+        CHECK(readFile(path) == photo.substr(0, 10) + "\x07\x07" + photo.substr(10, 199988) + photo.substr(299998));
+    }
+    
+    // A copy that shrinks and saves the file its original still maps.
+    writeFile(path, photo);
+    {
+        data original(path);
+        CHECK(original.isMapped());
+        data copy(original);
+        copy.removeBytesIn(data::range(0, 99999));
+        copy.save();
+        CHECK(original[photo.size() - 1] == static_cast<byte>(photo.back()));
+        CHECK(original.digest() == photo);
+        CHECK(readFile(path) == photo.substr(100000));
+    }
+    
+    // Two objects that loaded the same file.
+    writeFile(path, photo);
+    {
+        data first(path);
+        data second(path);
+        second.removeBytesIn(data::range(200000, photo.size() - 1));
+        second.save();
+        CHECK(first.digest() == photo);
+        CHECK(readFile(path) == photo.substr(0, 200000));
+        
+        // Once the other mapping is gone, saves write into the file again.
+        first = data();
+        ino_t inode = inodeOf(path);
+        byte b[] = {9, 9};
+        data::range r(0, 1);
+        second.overrideBytes(b, 2, r);
+        second.save();
+        CHECK(inodeOf(path) == inode && readFile(path)[0] == 9);
+    }
+    
+    // A writable mapping shrinking a file that another object maps. Its edits reach the reader's
+    // pages before the save, but the save must not take those pages away.
+    writeFile(path, photo);
+    {
+        data reader(path, data::mapped);
+        data writer(path, data::writable);
+        writer.removeBytesIn(data::range(0, 299999));
+        writer.save();
+        CHECK(reader.digest().size() == photo.size());
+        CHECK(readFile(path) == photo.substr(300000));
+        
+        // The writer moved onto the file it wrote, and still edits it in place.
+        byte b[] = {1, 2};
+        data::range r(0, 1);
+        writer.overrideBytes(b, 2, r);
+        CHECK(readFile(path)[0] == 1);
+    }
+    
+    std::remove(path.c_str());
+}
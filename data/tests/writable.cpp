@@ -0,0 +1,107 @@
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include "check.h"
+
+// Writable mappings: the file only grows as far as the bytes, batches are applied in the file,
+// and saves to another file, or with atomicReplace, carry the mapping over to the file written.
+
+static size_t lengthOf(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+}
+
+static ino_t inodeOf(const std::string &path)
+{
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_ino : 0;
+}
+
+static bool editsGoToFile(data &d, const std::string &path)
+// Postcondition: Returns true if overriding the first byte of d changes the file before any save.
+{
+    byte b = static_cast<byte>(d[0] + 1);
+    data::range first(0, 1);
+    byte both[] = {b, d[1]};
+    d.overrideBytes(both, 2, first);
+    return readFile(path)[0] == static_cast<char>(b);
+}
+
+void testWritable()
+{
+    std::string photo = readFile("photo.jpeg");
+    std::string path = scratchPath("writable.jpeg");
+    std::string other = scratchPath("writable_other.jpeg");
+    const byte *p = reinterpret_cast<const byte *>(photo.data());
+    
+    // Reserving and growing leave the file about as long as the bytes.
+    writeFile(path, photo.substr(0, 10000));
+    {
+        data d(path, data::writable);
+        CHECK(d.isMapped());
+        d.reserve(size_t(1) << 30);
+        CHECK(d.capacity() >= size_t(1) << 30);
+        CHECK(lengthOf(path) == 10000);
+        for (size_t i = 10000; i < 15000; i++)
+            d.appendByte(p[i]);
+        CHECK(lengthOf(path) >= 15000 && lengthOf(path) < 15000 + 4096);
+        CHECK(readFile(path).substr(0, 15000) == photo.substr(0, 15000));
+        
+        ino_t inode = inodeOf(path);
+        d.save();
+        CHECK(readFile(path) == photo.substr(0, 15000) && inodeOf(path) == inode);
+        CHECK(editsGoToFile(d, path));
+    }
+    CHECK(lengthOf(path) == 15000);
+    
+    // Batches are applied in the file, which stays mapped.
+    writeFile(path, photo.substr(0, 20000));
+    {
+        data d(path, data::writable);
+        data::editBatch batch;
+        batch.insertBytes(p + 30000, 3000, 100);
+        batch.removeBytesIn(data::range(5000, 5999));
+        batch.overrideBytes(p + 40000, 10, data::range(19000, 19499));
+        CHECK(d.applyEdits(batch));
+        std::string expected = photo.substr(0, 100) + photo.substr(30000, 3000) + photo.substr(100, 4900) +
+                               photo.substr(6000, 13000) + photo.substr(40000, 10) + photo.substr(19500, 500);
+        CHECK(d.isMapped() && d.digest() == expected);
+        d.save();
+        CHECK(readFile(path) == expected);
+        CHECK(editsGoToFile(d, path));
+    }
+    
+    // Saving to another file moves the mapping there and leaves the first file alone.
+    writeFile(path, photo.substr(0, 8000));
+    {
+        data d(path, data::writable);
+        d.saveToPath(other);
+        CHECK(readFile(other) == photo.substr(0, 8000));
+        CHECK(editsGoToFile(d, other));
+        std::string edited = readFile(other);
+        CHECK(readFile(path) == photo.substr(0, 8000));
+        
+        // atomicReplace writes a new file and maps it.
+        ino_t inode = inodeOf(other);
+        d.appendByte(7);
+        d.save(data::atomicReplace);
+        CHECK(inodeOf(other) != inode);
+        CHECK(readFile(other) == edited + "\x07");
+        CHECK(d.isMapped() && editsGoToFile(d, other));
+    }
+    CHECK(readFile(path) == photo.substr(0, 8000));
+    
+    // An empty file is mapped once it grows.
+    writeFile(path, "");
+    {
+        data d(path, data::writable);
+        d.insertBytes(p, 100, 0);
+        CHECK(d.isMapped() && readFile(path).substr(0, 100) == photo.substr(0, 100));
+        d.save();
+        CHECK(readFile(path) == photo.substr(0, 100));
+    }
+    
+    std::remove(path.c_str());
+    std::remove(other.c_str());
+}